@@ -0,0 +1,252 @@
+/*
+ * button_debounce: see include/button_debounce.h.
+ *
+ * Deadlines are in microseconds of one shared time base, and its single
+ * alarm is always programmed to the earliest pending deadline. Button state
+ * is shared between the GPIO ISR and the timer ISR (possibly on different
+ * cores) under one spinlock.
+ *
+ * The time base is a gptimer free-running at 1 MHz, except with
+ * CONFIG_PM_ENABLE: an enabled gptimer holds a no-light-sleep PM lock for
+ * as long as it exists (gptimer_enable/disable are not ISR-safe, so it
+ * cannot be toggled per press), so low-power builds use a one-shot esp_timer
+ * with ISR dispatch instead, which keeps time across light sleep.
+ *
+ * GPIO edge interrupts cannot wake the chip from light sleep, so with
+ * CONFIG_PM_ENABLE each pin is a GPIO wakeup source with a level trigger
+ * set to the opposite of its settled level, re-pointed whenever the button
+ * settles. While awake that level interrupt acts as the edge interrupt (the
+ * ISR masks the pin at once, so it does not re-trigger), and while asleep
+ * the same level wakes the chip, for both presses and releases.
+ *
+ * The ISR paths use the inline gpio_ll accessors rather than the gpio
+ * driver calls: the latency/static profiles make the gptimer ISR IRAM-safe,
+ * and gpio_get_level()/gpio_intr_enable() are not in IRAM, so they would
+ * fault whenever the alarm fires during a flash write. Pin interrupts are
+ * re-enabled on the core that called button_debounce_init() (where the GPIO
+ * ISR service is installed).
+ */
+
+#include "button_debounce.h"
+
+#include <stdbool.h>
+
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "freertos/FreeRTOS.h"
+#include "hal/gpio_ll.h"
+#include "sdkconfig.h"
+#include "soc/gpio_struct.h"
+
+#if CONFIG_PM_ENABLE
+#include "esp_sleep.h"
+#include "esp_timer.h"
+#define BUTTON_DEBOUNCE_ESP_TIMER 1
+#else
+#include "driver/gptimer.h"
+#endif
+
+#define TIMER_RESOLUTION_HZ 1000000
+#define NO_DEADLINE UINT64_MAX
+
+typedef struct {
+    int gpio;
+    int level;         /* last reported (settled) level */
+    uint64_t deadline; /* timer count at which to sample, NO_DEADLINE if idle */
+} button_t;
+
+static const char *TAG = "button_debounce";
+
+#if BUTTON_DEBOUNCE_ESP_TIMER
+static esp_timer_handle_t s_timer;
+#else
+static gptimer_handle_t s_timer;
+#endif
+static gpio_event_ring_t *s_ring;
+static uint64_t s_window_ticks;
+static button_t s_buttons[BUTTON_DEBOUNCE_MAX_BUTTONS];
+static int s_count;
+static uint32_t s_isr_core;
+static portMUX_TYPE s_lock = portMUX_INITIALIZER_UNLOCKED;
+
+static inline uint64_t IRAM_ATTR now_us(void)
+{
+#if BUTTON_DEBOUNCE_ESP_TIMER
+    return (uint64_t)esp_timer_get_time();
+#else
+    uint64_t now = 0;
+    gptimer_get_raw_count(s_timer, &now);
+    return now;
+#endif
+}
+
+/* Program the alarm for the earliest pending deadline (call under s_lock). */
+static void IRAM_ATTR rearm_locked(void)
+{
+    uint64_t next = NO_DEADLINE;
+    for (int i = 0; i < s_count; i++) {
+        if (s_buttons[i].deadline < next) {
+            next = s_buttons[i].deadline;
+        }
+    }
+
+#if BUTTON_DEBOUNCE_ESP_TIMER
+    esp_timer_stop(s_timer); /* ESP_ERR_INVALID_STATE if not running */
+    if (next != NO_DEADLINE) {
+        uint64_t now = now_us();
+        esp_timer_start_once(s_timer, next > now ? next - now : 1);
+    }
+#else
+    if (next == NO_DEADLINE) {
+        gptimer_set_alarm_action(s_timer, NULL);
+        return;
+    }
+    const gptimer_alarm_config_t alarm = {.alarm_count = next};
+    gptimer_set_alarm_action(s_timer, &alarm);
+#endif
+}
+
+/* Unmask a settled button's pin (call under s_lock). */
+static inline void IRAM_ATTR arm_pin_locked(const button_t *button)
+{
+#if BUTTON_DEBOUNCE_ESP_TIMER
+    /* Wake on (and interrupt at) the level the button moves to next. */
+    gpio_ll_set_intr_type(&GPIO, button->gpio, button->level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL);
+#endif
+    gpio_ll_intr_enable_on_core(&GPIO, s_isr_core, button->gpio);
+}
+
+static void IRAM_ATTR gpio_isr(void *arg)
+{
+    button_t *button = (button_t *)arg;
+
+    gpio_ll_intr_disable(&GPIO, button->gpio);
+    uint64_t now = now_us();
+
+    portENTER_CRITICAL_ISR(&s_lock);
+    button->deadline = now + s_window_ticks;
+    rearm_locked();
+    portEXIT_CRITICAL_ISR(&s_lock);
+}
+
+/* Sample every button whose window has expired at now. */
+static void IRAM_ATTR settle_due(uint64_t now)
+{
+    portENTER_CRITICAL_ISR(&s_lock);
+    for (int i = 0; i < s_count; i++) {
+        button_t *button = &s_buttons[i];
+        if (button->deadline > now) {
+            continue;
+        }
+
+        int level = gpio_ll_get_level(&GPIO, button->gpio);
+        if (level != button->level) {
+            button->level = level;
+            gpio_event_ring_push_from_isr(s_ring, button->gpio, level);
+        }
+
+        arm_pin_locked(button);
+        if (gpio_ll_get_level(&GPIO, button->gpio) != level) {
+            /* Moved while masked: debounce the new edge too. */
+            gpio_ll_intr_disable(&GPIO, button->gpio);
+            button->deadline = now + s_window_ticks;
+        } else {
+            button->deadline = NO_DEADLINE;
+        }
+    }
+    rearm_locked();
+    portEXIT_CRITICAL_ISR(&s_lock);
+}
+
+#if BUTTON_DEBOUNCE_ESP_TIMER
+static void IRAM_ATTR timer_alarm_cb(void *arg)
+{
+    settle_due(now_us());
+}
+#else
+static bool IRAM_ATTR timer_alarm_cb(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    settle_due(edata->count_value);
+
+    /* gpio_event_ring_push_from_isr already requested the yield. */
+    return false;
+}
+#endif
+
+esp_err_t button_debounce_init(gpio_event_ring_t *ring, uint32_t window_ms)
+{
+    ESP_RETURN_ON_FALSE(ring && window_ms > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    ESP_RETURN_ON_FALSE(s_timer == NULL, ESP_ERR_INVALID_STATE, TAG, "already initialized");
+
+    s_ring = ring;
+    s_isr_core = xPortGetCoreID();
+    s_window_ticks = (uint64_t)window_ms * (TIMER_RESOLUTION_HZ / 1000);
+
+    esp_err_t err = gpio_install_isr_service(0);
+    ESP_RETURN_ON_FALSE(err == ESP_OK || err == ESP_ERR_INVALID_STATE, err, TAG, "gpio_install_isr_service failed");
+
+#if BUTTON_DEBOUNCE_ESP_TIMER
+    const esp_timer_create_args_t timer_args = {
+        .callback = timer_alarm_cb,
+        .dispatch_method = ESP_TIMER_ISR,
+        .name = "button_debounce",
+    };
+    return esp_timer_create(&timer_args, &s_timer);
+#else
+    const gptimer_config_t timer_config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    ESP_RETURN_ON_ERROR(gptimer_new_timer(&timer_config, &s_timer), TAG, "gptimer_new_timer failed");
+
+    const gptimer_event_callbacks_t callbacks = {.on_alarm = timer_alarm_cb};
+    ESP_RETURN_ON_ERROR(gptimer_register_event_callbacks(s_timer, &callbacks, NULL), TAG, "register callbacks failed");
+    ESP_RETURN_ON_ERROR(gptimer_enable(s_timer), TAG, "gptimer_enable failed");
+    return gptimer_start(s_timer);
+#endif
+}
+
+esp_err_t button_debounce_add(int gpio, gpio_pull_mode_t pull)
+{
+    ESP_RETURN_ON_FALSE(s_timer, ESP_ERR_INVALID_STATE, TAG, "call button_debounce_init first");
+    ESP_RETURN_ON_FALSE(s_count < BUTTON_DEBOUNCE_MAX_BUTTONS, ESP_ERR_NO_MEM, TAG, "too many buttons");
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << gpio,
+        .mode = GPIO_MODE_INPUT,
+        .pull_up_en = pull == GPIO_PULLUP_ONLY || pull == GPIO_PULLUP_PULLDOWN,
+        .pull_down_en = pull == GPIO_PULLDOWN_ONLY || pull == GPIO_PULLUP_PULLDOWN,
+        .intr_type = GPIO_INTR_ANYEDGE,
+    };
+    ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "gpio_config failed");
+
+    portENTER_CRITICAL(&s_lock);
+    button_t *button = &s_buttons[s_count];
+    button->gpio = gpio;
+    button->level = gpio_get_level(gpio);
+    button->deadline = NO_DEADLINE;
+    s_count++;
+    portEXIT_CRITICAL(&s_lock);
+
+    ESP_RETURN_ON_ERROR(gpio_isr_handler_add(gpio, gpio_isr, button), TAG, "gpio_isr_handler_add failed");
+
+#if BUTTON_DEBOUNCE_ESP_TIMER
+    /* Switch the pin to the level trigger that also wakes from light sleep. */
+    ESP_RETURN_ON_ERROR(gpio_wakeup_enable(gpio, button->level ? GPIO_INTR_LOW_LEVEL : GPIO_INTR_HIGH_LEVEL),
+                        TAG, "gpio_wakeup_enable failed");
+    return esp_sleep_enable_gpio_wakeup();
+#else
+    return ESP_OK;
+#endif
+}
+
+int button_debounce_level(int gpio)
+{
+    for (int i = 0; i < s_count; i++) {
+        if (s_buttons[i].gpio == gpio) {
+            return s_buttons[i].level;
+        }
+    }
+    return -1;
+}
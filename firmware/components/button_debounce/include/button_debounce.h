@@ -0,0 +1,75 @@
+/*
+ * button_debounce: hardware-timer debouncing for up to
+ * BUTTON_DEBOUNCE_MAX_BUTTONS buttons sharing one gptimer (one esp_timer
+ * with CONFIG_PM_ENABLE, so the debounce timer never blocks light sleep).
+ *
+ * The first edge on a button disables that pin's interrupt and arms a
+ * debounce deadline; bounces during the window cost no ISR entries. When the
+ * window expires the settled level is sampled in the timer ISR: if it differs
+ * from the last reported level, one event is pushed to a gpio_event_ring,
+ * then the pin interrupt is re-enabled. If the level moved again while the
+ * pin was masked, the window is restarted instead, so a release that lands
+ * inside the window is not lost.
+ *
+ * Every press and every release therefore produces exactly one event, with
+ * the settled level in ev.level and the settle time in ev.t_us.
+ *
+ * With CONFIG_PM_ENABLE every added button is also a light-sleep wakeup
+ * source (for presses and releases); do not call gpio_wakeup_enable() or
+ * pm_helper_gpio_wakeup() on its pin.
+ *
+ * Typical use:
+ *
+ *     static gpio_event_ring_t s_ring;
+ *
+ *     gpio_event_ring_init(&s_ring, NULL);
+ *     button_debounce_init(&s_ring, 20);
+ *     button_debounce_add(BUTTON_GPIO, GPIO_PULLDOWN_ONLY);
+ *
+ *     gpio_event_t ev;
+ *     while (gpio_event_ring_wait(&s_ring, &ev, portMAX_DELAY)) {
+ *         gpio_set_level(BUZZER_GPIO, ev.level);   // pressed = 1 with pull-down
+ *     }
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "driver/gpio.h"
+#include "esp_err.h"
+#include "gpio_event_ring.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef BUTTON_DEBOUNCE_MAX_BUTTONS
+#define BUTTON_DEBOUNCE_MAX_BUTTONS 8
+#endif
+
+/**
+ * Create the shared debounce timer; settled edges are pushed to ring.
+ *
+ * Installs the GPIO ISR service if it is not installed yet.
+ */
+esp_err_t button_debounce_init(gpio_event_ring_t *ring, uint32_t window_ms);
+
+/**
+ * Configure gpio as a debounced button input (any-edge interrupt; a level
+ * interrupt that follows the settled level, and wakes from light sleep,
+ * with CONFIG_PM_ENABLE).
+ *
+ * @param pull GPIO_PULLUP_ONLY / GPIO_PULLDOWN_ONLY, or GPIO_FLOATING when
+ *             the board has an external resistor
+ */
+esp_err_t button_debounce_add(int gpio, gpio_pull_mode_t pull);
+
+/**
+ * Last settled level of a button (-1 if gpio was not added).
+ */
+int button_debounce_level(int gpio);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,188 @@
+/*
+ * dlog: see include/dlog.h.
+ *
+ * Each core has a bounded MPMC ring with per-slot sequence numbers: a writer
+ * claims a slot with a CAS on head, fills it and publishes it by storing the
+ * slot sequence. Writers on the same ring (preempting tasks, ISRs, or a task
+ * that migrated cores after picking the ring) never block each other; the
+ * single drain task consumes slots in order.
+ */
+
+#include "dlog.h"
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define DRAIN_PERIOD_MS 20
+
+_Static_assert((DLOG_RING_SIZE & (DLOG_RING_SIZE - 1)) == 0, "DLOG_RING_SIZE must be a power of two");
+
+typedef struct {
+    uint32_t seq;
+    uint8_t level;
+    uint8_t num_words;
+    int64_t t_us;
+    const char *tag;
+    const char *fmt;
+    uint32_t words[DLOG_MAX_WORDS];
+} dlog_slot_t;
+
+typedef struct {
+    dlog_slot_t slots[DLOG_RING_SIZE];
+    uint32_t head;
+    uint32_t tail; /* drain task only */
+    uint32_t dropped;
+} dlog_ring_t;
+
+static dlog_ring_t s_rings[portNUM_PROCESSORS];
+static bool s_rings_ready;
+static TaskHandle_t s_drain_task;
+
+static void rings_init(void)
+{
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        for (uint32_t i = 0; i < DLOG_RING_SIZE; i++) {
+            s_rings[core].slots[i].seq = i;
+        }
+    }
+    __atomic_store_n(&s_rings_ready, true, __ATOMIC_RELEASE);
+}
+
+/* Collect argument words as the compile-time layout (DLOG_LAYOUT) dictates. */
+static uint8_t IRAM_ATTR collect_words(uint32_t layout, va_list args, uint32_t *words)
+{
+    uint8_t n = 0;
+    uint32_t count = layout & 0xF;
+    for (uint32_t i = 0; i < count && i < DLOG_MAX_ARGS; i++) {
+        uint32_t kind = (layout >> (4 + 2 * i)) & 0x3;
+        uint64_t value;
+        if (kind == DLOG_ARG_DOUBLE) {
+            double d = va_arg(args, double);
+            memcpy(&value, &d, sizeof(value));
+        } else if (kind == DLOG_ARG_WIDE) {
+            value = va_arg(args, uint64_t);
+        } else {
+            value = va_arg(args, uint32_t);
+        }
+
+        bool wide = kind != DLOG_ARG_WORD;
+        if (n + (wide ? 2 : 1) > DLOG_MAX_WORDS) {
+            break;
+        }
+        words[n++] = (uint32_t)value;
+        if (wide) {
+            words[n++] = (uint32_t)(value >> 32);
+        }
+    }
+    return n;
+}
+
+void IRAM_ATTR dlog_write(esp_log_level_t level, const char *tag, const char *fmt, uint32_t layout, ...)
+{
+    if (!__atomic_load_n(&s_rings_ready, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+
+    dlog_ring_t *ring = &s_rings[xPortGetCoreID()];
+    uint32_t pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+    dlog_slot_t *slot;
+
+    for (;;) {
+        slot = &ring->slots[pos & (DLOG_RING_SIZE - 1)];
+        int32_t diff = (int32_t)(__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) - pos);
+        if (diff == 0) {
+            if (__atomic_compare_exchange_n(&ring->head, &pos, pos + 1, true,
+                                            __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                break;
+            }
+        } else if (diff < 0) {
+            __atomic_add_fetch(&ring->dropped, 1, __ATOMIC_RELAXED);
+            return;
+        } else {
+            pos = __atomic_load_n(&ring->head, __ATOMIC_RELAXED);
+        }
+    }
+
+    slot->t_us = esp_timer_get_time();
+    slot->level = (uint8_t)level;
+    slot->tag = tag;
+    slot->fmt = fmt;
+
+    va_list args;
+    va_start(args, layout);
+    slot->num_words = collect_words(layout, args, slot->words);
+    va_end(args);
+
+    __atomic_store_n(&slot->seq, pos + 1, __ATOMIC_RELEASE);
+}
+
+static bool drain_one(int core)
+{
+    dlog_ring_t *ring = &s_rings[core];
+    uint32_t pos = ring->tail;
+    dlog_slot_t *slot = &ring->slots[pos & (DLOG_RING_SIZE - 1)];
+
+    if (__atomic_load_n(&slot->seq, __ATOMIC_ACQUIRE) != pos + 1) {
+        return false;
+    }
+
+    printf("@DL,%d,%" PRId64 ",%d,%" PRIxPTR ",%" PRIxPTR, core, slot->t_us, slot->level,
+           (uintptr_t)slot->tag, (uintptr_t)slot->fmt);
+    for (int i = 0; i < slot->num_words; i++) {
+        printf(",%" PRIx32, slot->words[i]);
+    }
+    putchar('\n');
+
+    __atomic_store_n(&slot->seq, pos + DLOG_RING_SIZE, __ATOMIC_RELEASE);
+    ring->tail = pos + 1;
+    return true;
+}
+
+static void drain_task(void *arg)
+{
+    uint32_t reported_dropped = 0;
+    for (;;) {
+        bool any = false;
+        for (int core = 0; core < portNUM_PROCESSORS; core++) {
+            while (drain_one(core)) {
+                any = true;
+            }
+        }
+
+        uint32_t dropped = dlog_dropped();
+        if (dropped != reported_dropped) {
+            reported_dropped = dropped;
+            printf("@DL,O,%" PRIu32 "\n", dropped);
+        }
+        if (any) {
+            fflush(stdout);
+        }
+        vTaskDelay(pdMS_TO_TICKS(DRAIN_PERIOD_MS));
+    }
+}
+
+esp_err_t dlog_init(void)
+{
+    if (s_drain_task) {
+        return ESP_OK;
+    }
+    rings_init();
+    return xTaskCreate(drain_task, "dlog", 3072, NULL, 1, &s_drain_task) == pdPASS ? ESP_OK : ESP_ERR_NO_MEM;
+}
+
+uint32_t dlog_dropped(void)
+{
+    uint32_t total = 0;
+    for (int core = 0; core < portNUM_PROCESSORS; core++) {
+        total += __atomic_load_n(&s_rings[core].dropped, __ATOMIC_RELAXED);
+    }
+    return total;
+}
@@ -0,0 +1,149 @@
+/*
+ * dlog: deferred, binary logging for hot paths (event loops, ISRs).
+ *
+ * DLOGx(tag, fmt, ...) does not format anything. It stores the address of
+ * the format string and tag, an esp_timer timestamp and the raw argument
+ * words in a lock-free ring of the calling core, and returns. A low-priority
+ * task drains the rings and prints each record as one compact hex line:
+ *
+ *   @DL,<core>,<t_us>,<level>,<tag_addr>,<fmt_addr>[,<arg_word>...]
+ *
+ * The host decoder (src/dlog.py in the agent repo) resolves the addresses
+ * against the firmware ELF and formats the messages. Because only
+ * addresses are recorded, tags, format strings and %s arguments must be
+ * string literals or other constant strings (not stack/heap buffers).
+ * The format string is never read on the chip: DLOG_AT works out the
+ * argument layout at compile time (argument count, and for each argument
+ * whether it is one word, a 64-bit integer or a double), so DLOGx is safe
+ * in IRAM-safe ISRs while the flash cache is disabled. At most
+ * DLOG_MAX_ARGS arguments per message.
+ *
+ * Drop-in use for existing ESP_LOGx calls:
+ *
+ *     #define DLOG_REPLACE_ESP_LOG
+ *     #include "dlog.h"        // after esp_log.h
+ *
+ *     void app_main(void)
+ *     {
+ *         dlog_init();
+ *         ESP_LOGI(TAG, "pressed %d times", count);   // -> DLOGI
+ *     }
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <type_traits>
+#endif
+
+#include "esp_err.h"
+#include "esp_log.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Records per core ring (power of two). */
+#ifndef DLOG_RING_SIZE
+#define DLOG_RING_SIZE 128
+#endif
+
+/* Argument words per record (64-bit and double arguments take two). */
+#ifndef DLOG_MAX_WORDS
+#define DLOG_MAX_WORDS 8
+#endif
+
+/* Arguments per message (the layout descriptor has 2 bits per argument). */
+#define DLOG_MAX_ARGS 8
+
+/* Records below this level are compiled in but dropped at runtime. */
+#ifndef DLOG_LEVEL
+#define DLOG_LEVEL ESP_LOG_INFO
+#endif
+
+/**
+ * Start the drain task (call once, early in app_main).
+ */
+esp_err_t dlog_init(void);
+
+/**
+ * Record a message; use the DLOGx macros instead. ISR-safe, never blocks.
+ *
+ * layout is DLOG_LAYOUT(args): the argument count in bits 0-3, then 2 bits
+ * per argument (DLOG_ARG_WORD / DLOG_ARG_WIDE / DLOG_ARG_DOUBLE).
+ */
+void dlog_write(esp_log_level_t level, const char *tag, const char *fmt, uint32_t layout, ...)
+    __attribute__((format(printf, 3, 5)));
+
+/**
+ * Records dropped because a ring was full.
+ */
+uint32_t dlog_dropped(void);
+
+/* How an argument is passed after default promotions (never evaluates it). */
+#define DLOG_ARG_WORD 0u
+#define DLOG_ARG_WIDE 1u
+#define DLOG_ARG_DOUBLE 2u
+
+#ifdef __cplusplus
+#define DLOG_ARG_KIND(x)                                                    \
+    (std::is_floating_point<decltype((x) + 0)>::value ? DLOG_ARG_DOUBLE     \
+     : sizeof((x) + 0) > 4                             ? DLOG_ARG_WIDE      \
+                                                       : DLOG_ARG_WORD)
+#else
+#define DLOG_ARG_KIND(x)                                                    \
+    _Generic((x) + 0, float: DLOG_ARG_DOUBLE, double: DLOG_ARG_DOUBLE,      \
+             default: (sizeof((x) + 0) > 4 ? DLOG_ARG_WIDE : DLOG_ARG_WORD))
+#endif
+
+#define DLOG_K(x, i) (DLOG_ARG_KIND(x) << (4 + 2 * (i)))
+#define DLOG_KINDS_0() 0u
+#define DLOG_KINDS_1(a) DLOG_K(a, 0)
+#define DLOG_KINDS_2(a, b) (DLOG_KINDS_1(a) | DLOG_K(b, 1))
+#define DLOG_KINDS_3(a, b, c) (DLOG_KINDS_2(a, b) | DLOG_K(c, 2))
+#define DLOG_KINDS_4(a, b, c, d) (DLOG_KINDS_3(a, b, c) | DLOG_K(d, 3))
+#define DLOG_KINDS_5(a, b, c, d, e) (DLOG_KINDS_4(a, b, c, d) | DLOG_K(e, 4))
+#define DLOG_KINDS_6(a, b, c, d, e, f) (DLOG_KINDS_5(a, b, c, d, e) | DLOG_K(f, 5))
+#define DLOG_KINDS_7(a, b, c, d, e, f, g) (DLOG_KINDS_6(a, b, c, d, e, f) | DLOG_K(g, 6))
+#define DLOG_KINDS_8(a, b, c, d, e, f, g, h) (DLOG_KINDS_7(a, b, c, d, e, f, g) | DLOG_K(h, 7))
+
+#define DLOG_NARGS_(_0, _1, _2, _3, _4, _5, _6, _7, _8, n, ...) n
+#define DLOG_NARGS(...) DLOG_NARGS_(_, ##__VA_ARGS__, 8, 7, 6, 5, 4, 3, 2, 1, 0)
+#define DLOG_CAT_(a, b) a##b
+#define DLOG_CAT(a, b) DLOG_CAT_(a, b)
+
+/* Compile-time argument layout of a DLOGx call (see dlog_write). */
+#define DLOG_LAYOUT(...) \
+    ((uint32_t)DLOG_NARGS(__VA_ARGS__) | DLOG_CAT(DLOG_KINDS_, DLOG_NARGS(__VA_ARGS__))(__VA_ARGS__))
+
+#define DLOG_AT(level, tag, fmt, ...)                                                        \
+    do {                                                                                     \
+        if ((level) <= DLOG_LEVEL) {                                                         \
+            dlog_write((level), (tag), (fmt), DLOG_LAYOUT(__VA_ARGS__), ##__VA_ARGS__);      \
+        }                                                                                    \
+    } while (0)
+
+#define DLOGE(tag, fmt, ...) DLOG_AT(ESP_LOG_ERROR, tag, fmt, ##__VA_ARGS__)
+#define DLOGW(tag, fmt, ...) DLOG_AT(ESP_LOG_WARN, tag, fmt, ##__VA_ARGS__)
+#define DLOGI(tag, fmt, ...) DLOG_AT(ESP_LOG_INFO, tag, fmt, ##__VA_ARGS__)
+#define DLOGD(tag, fmt, ...) DLOG_AT(ESP_LOG_DEBUG, tag, fmt, ##__VA_ARGS__)
+#define DLOGV(tag, fmt, ...) DLOG_AT(ESP_LOG_VERBOSE, tag, fmt, ##__VA_ARGS__)
+
+#ifdef DLOG_REPLACE_ESP_LOG
+#undef ESP_LOGE
+#undef ESP_LOGW
+#undef ESP_LOGI
+#undef ESP_LOGD
+#undef ESP_LOGV
+#define ESP_LOGE DLOGE
+#define ESP_LOGW DLOGW
+#define ESP_LOGI DLOGI
+#define ESP_LOGD DLOGD
+#define ESP_LOGV DLOGV
+#endif
+
+#ifdef __cplusplus
+}
+#endif
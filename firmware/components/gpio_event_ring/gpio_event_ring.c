@@ -0,0 +1,110 @@
+/*
+ * gpio_event_ring: see include/gpio_event_ring.h.
+ *
+ * head/tail are free-running counters; the producer publishes an event with
+ * a release store of head, the consumer frees a slot with a release store of
+ * tail, so no critical section is needed on either side.
+ */
+
+#include "gpio_event_ring.h"
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_timer.h"
+#include "soc/gpio_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+
+_Static_assert((GPIO_EVENT_RING_CAPACITY & (GPIO_EVENT_RING_CAPACITY - 1)) == 0,
+               "GPIO_EVENT_RING_CAPACITY must be a power of two");
+
+typedef struct {
+    gpio_event_ring_t *ring;
+    uint8_t gpio;
+} pin_ctx_t;
+
+/* One handler context per pin, so add_pin never allocates. */
+static pin_ctx_t s_pins[SOC_GPIO_PIN_COUNT];
+
+static inline int IRAM_ATTR read_level(int gpio)
+{
+#if SOC_GPIO_PIN_COUNT > 32
+    if (gpio >= 32) {
+        return (REG_READ(GPIO_IN1_REG) >> (gpio - 32)) & 1;
+    }
+#endif
+    return (REG_READ(GPIO_IN_REG) >> gpio) & 1;
+}
+
+void gpio_event_ring_init(gpio_event_ring_t *ring, TaskHandle_t consumer)
+{
+    ring->head = 0;
+    ring->tail = 0;
+    ring->dropped = 0;
+    ring->consumer = consumer ? consumer : xTaskGetCurrentTaskHandle();
+}
+
+bool IRAM_ATTR gpio_event_ring_push_from_isr(gpio_event_ring_t *ring, int gpio, int level)
+{
+    int64_t now = esp_timer_get_time();
+    uint32_t head = ring->head;
+
+    if (head - __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE) >= GPIO_EVENT_RING_CAPACITY) {
+        ring->dropped++;
+        return false;
+    }
+
+    gpio_event_t *slot = &ring->events[head & (GPIO_EVENT_RING_CAPACITY - 1)];
+    slot->t_us = now;
+    slot->gpio = (uint8_t)gpio;
+    slot->level = (uint8_t)level;
+    __atomic_store_n(&ring->head, head + 1, __ATOMIC_RELEASE);
+
+    BaseType_t woken = pdFALSE;
+    vTaskNotifyGiveIndexedFromISR(ring->consumer, GPIO_EVENT_RING_NOTIFY_INDEX, &woken);
+    portYIELD_FROM_ISR(woken);
+    return true;
+}
+
+static void IRAM_ATTR pin_isr_handler(void *arg)
+{
+    const pin_ctx_t *ctx = (const pin_ctx_t *)arg;
+    gpio_event_ring_push_from_isr(ctx->ring, ctx->gpio, read_level(ctx->gpio));
+}
+
+esp_err_t gpio_event_ring_add_pin(gpio_event_ring_t *ring, int gpio)
+{
+    if (!GPIO_IS_VALID_GPIO(gpio)) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    s_pins[gpio] = (pin_ctx_t){.ring = ring, .gpio = (uint8_t)gpio};
+    return gpio_isr_handler_add(gpio, pin_isr_handler, &s_pins[gpio]);
+}
+
+bool gpio_event_ring_pop(gpio_event_ring_t *ring, gpio_event_t *out)
+{
+    uint32_t tail = ring->tail;
+    if (tail == __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    *out = ring->events[tail & (GPIO_EVENT_RING_CAPACITY - 1)];
+    __atomic_store_n(&ring->tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool gpio_event_ring_wait(gpio_event_ring_t *ring, gpio_event_t *out, TickType_t timeout)
+{
+    TimeOut_t start;
+    vTaskSetTimeOutState(&start);
+
+    while (!gpio_event_ring_pop(ring, out)) {
+        if (xTaskCheckForTimeOut(&start, &timeout) != pdFALSE) {
+            return false;
+        }
+        /* Notifications are counted, so an event pushed between the pop and
+         * this take is not lost. */
+        ulTaskNotifyTakeIndexed(GPIO_EVENT_RING_NOTIFY_INDEX, pdFALSE, timeout);
+    }
+    return true;
+}
@@ -0,0 +1,104 @@
+/*
+ * gpio_event_ring: zero-allocation GPIO edge events from ISR to task.
+ *
+ * A fixed-size single-producer / single-consumer ring of timestamped edge
+ * events. The producer is the GPIO ISR service (all pins of one ring must go
+ * through gpio_install_isr_service, whose handlers run serialized on one
+ * core); the consumer is a single task, woken with a direct-to-task
+ * notification. Pushing never blocks, allocates or logs; it captures the pin
+ * level and esp_timer time at the moment the interrupt fires and requests a
+ * context switch so the consumer runs as soon as the ISR returns.
+ *
+ * Typical use:
+ *
+ *     static gpio_event_ring_t s_ring;
+ *
+ *     static void button_task(void *arg)
+ *     {
+ *         gpio_event_ring_init(&s_ring, NULL);             // consumer = this task
+ *         gpio_install_isr_service(0);
+ *         gpio_event_ring_add_pin(&s_ring, BUTTON_GPIO);   // after gpio_config()
+ *
+ *         gpio_event_t ev;
+ *         for (;;) {
+ *             if (gpio_event_ring_wait(&s_ring, &ev, portMAX_DELAY)) {
+ *                 gpio_set_level(BUZZER_GPIO, ev.level);
+ *             }
+ *         }
+ *     }
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Number of buffered events per ring (power of two). */
+#ifndef GPIO_EVENT_RING_CAPACITY
+#define GPIO_EVENT_RING_CAPACITY 32
+#endif
+
+/* Task notification index used to wake the consumer. */
+#ifndef GPIO_EVENT_RING_NOTIFY_INDEX
+#define GPIO_EVENT_RING_NOTIFY_INDEX 0
+#endif
+
+typedef struct {
+    int64_t t_us;  /* esp_timer_get_time() when the ISR ran */
+    uint8_t gpio;
+    uint8_t level; /* pin level sampled inside the ISR */
+} gpio_event_t;
+
+typedef struct {
+    gpio_event_t events[GPIO_EVENT_RING_CAPACITY];
+    volatile uint32_t head;    /* written by the producer only */
+    volatile uint32_t tail;    /* written by the consumer only */
+    volatile uint32_t dropped; /* events lost because the ring was full */
+    TaskHandle_t consumer;
+} gpio_event_ring_t;
+
+/**
+ * Reset a ring and set the task woken on new events (NULL = calling task).
+ */
+void gpio_event_ring_init(gpio_event_ring_t *ring, TaskHandle_t consumer);
+
+/**
+ * Register the built-in ISR handler for a pin; its edges are pushed to ring.
+ *
+ * The pin must already be configured (gpio_config with an interrupt type) and
+ * gpio_install_isr_service() must have been called.
+ */
+esp_err_t gpio_event_ring_add_pin(gpio_event_ring_t *ring, int gpio);
+
+/**
+ * Push an event from ISR context and wake the consumer.
+ *
+ * For custom ISR handlers; the level should be read inside the ISR.
+ *
+ * @return false if the ring was full (the event is counted in dropped)
+ */
+bool gpio_event_ring_push_from_isr(gpio_event_ring_t *ring, int gpio, int level);
+
+/**
+ * Pop the oldest event without blocking (consumer task only).
+ */
+bool gpio_event_ring_pop(gpio_event_ring_t *ring, gpio_event_t *out);
+
+/**
+ * Pop the oldest event, blocking up to timeout ticks (consumer task only).
+ *
+ * @return false on timeout
+ */
+bool gpio_event_ring_wait(gpio_event_ring_t *ring, gpio_event_t *out, TickType_t timeout);
+
+#ifdef __cplusplus
+}
+#endif
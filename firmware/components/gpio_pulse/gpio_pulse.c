@@ -0,0 +1,91 @@
+/*
+ * gpio_pulse: see include/gpio_pulse.h.
+ */
+
+#include "gpio_pulse.h"
+
+#include "driver/gpio.h"
+#include "esp_check.h"
+
+#define TONE_DUTY_RESOLUTION LEDC_TIMER_10_BIT
+#define TONE_DUTY_50_PCT (1 << (TONE_DUTY_RESOLUTION - 1))
+
+static const char *TAG = "gpio_pulse";
+
+static void set_output(const gpio_pulse_config_t *config, bool on)
+{
+    if (config->tone_hz) {
+        ledc_set_duty(LEDC_LOW_SPEED_MODE, config->ledc_channel, on ? TONE_DUTY_50_PCT : 0);
+        ledc_update_duty(LEDC_LOW_SPEED_MODE, config->ledc_channel);
+    } else {
+        gpio_set_level(config->gpio, on != config->active_low);
+    }
+}
+
+static void off_timer_cb(void *arg)
+{
+    gpio_pulse_t *pulse = (gpio_pulse_t *)arg;
+    set_output(&pulse->config, false);
+}
+
+esp_err_t gpio_pulse_init(gpio_pulse_t *pulse, const gpio_pulse_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(pulse && config && GPIO_IS_VALID_OUTPUT_GPIO(config->gpio),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    pulse->config = *config;
+
+    if (config->tone_hz) {
+        const ledc_timer_config_t timer_config = {
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .duty_resolution = TONE_DUTY_RESOLUTION,
+            .timer_num = config->ledc_timer,
+            .freq_hz = config->tone_hz,
+            .clk_cfg = LEDC_AUTO_CLK,
+        };
+        ESP_RETURN_ON_ERROR(ledc_timer_config(&timer_config), TAG, "ledc_timer_config failed");
+
+        const ledc_channel_config_t channel_config = {
+            .gpio_num = config->gpio,
+            .speed_mode = LEDC_LOW_SPEED_MODE,
+            .channel = config->ledc_channel,
+            .timer_sel = config->ledc_timer,
+            .duty = 0,
+        };
+        ESP_RETURN_ON_ERROR(ledc_channel_config(&channel_config), TAG, "ledc_channel_config failed");
+    } else {
+        const gpio_config_t io_config = {
+            .pin_bit_mask = 1ULL << config->gpio,
+            .mode = GPIO_MODE_OUTPUT,
+        };
+        ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "gpio_config failed");
+        set_output(config, false);
+    }
+
+    const esp_timer_create_args_t timer_args = {
+        .callback = off_timer_cb,
+        .arg = pulse,
+        .name = "gpio_pulse",
+    };
+    return esp_timer_create(&timer_args, &pulse->off_timer);
+}
+
+esp_err_t gpio_pulse_trigger(gpio_pulse_t *pulse, uint32_t duration_ms)
+{
+    esp_timer_stop(pulse->off_timer); /* ESP_ERR_INVALID_STATE if not running */
+    set_output(&pulse->config, true);
+    return esp_timer_start_once(pulse->off_timer, (uint64_t)duration_ms * 1000);
+}
+
+esp_err_t gpio_pulse_on(gpio_pulse_t *pulse)
+{
+    esp_timer_stop(pulse->off_timer);
+    set_output(&pulse->config, true);
+    return ESP_OK;
+}
+
+esp_err_t gpio_pulse_off(gpio_pulse_t *pulse)
+{
+    esp_timer_stop(pulse->off_timer);
+    set_output(&pulse->config, false);
+    return ESP_OK;
+}
@@ -0,0 +1,67 @@
+/*
+ * gpio_pulse: non-blocking timed output pulses (buzzers, indicator LEDs).
+ *
+ * gpio_pulse_trigger() switches the output on and returns immediately; a
+ * one-shot esp_timer created once in gpio_pulse_init() switches it off after
+ * the requested duration. Retriggering while a pulse is running restarts the
+ * duration. With tone_hz set, the pin is driven by an LEDC channel at 50 %
+ * duty instead of a static level (passive buzzers).
+ *
+ * Typical use (beep on every button press without blocking the handler):
+ *
+ *     static gpio_pulse_t s_buzzer;
+ *
+ *     gpio_pulse_init(&s_buzzer, &(gpio_pulse_config_t){.gpio = BUZZER_GPIO});
+ *     ...
+ *     gpio_pulse_trigger(&s_buzzer, 100);   // 100 ms beep, returns at once
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/ledc.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+    int gpio;
+    uint32_t tone_hz;             /* 0 = drive a static level */
+    bool active_low;              /* static-level pulses only */
+    ledc_timer_t ledc_timer;      /* tone mode only (default LEDC_TIMER_0) */
+    ledc_channel_t ledc_channel;  /* tone mode only (default LEDC_CHANNEL_0) */
+} gpio_pulse_config_t;
+
+typedef struct {
+    gpio_pulse_config_t config;
+    esp_timer_handle_t off_timer;
+} gpio_pulse_t;
+
+/**
+ * Configure the output (initially off) and create the one-shot off timer.
+ */
+esp_err_t gpio_pulse_init(gpio_pulse_t *pulse, const gpio_pulse_config_t *config);
+
+/**
+ * Switch the output on for duration_ms (task context; never blocks).
+ */
+esp_err_t gpio_pulse_trigger(gpio_pulse_t *pulse, uint32_t duration_ms);
+
+/**
+ * Switch the output on until gpio_pulse_off().
+ */
+esp_err_t gpio_pulse_on(gpio_pulse_t *pulse);
+
+/**
+ * Switch the output off and cancel a running pulse.
+ */
+esp_err_t gpio_pulse_off(gpio_pulse_t *pulse);
+
+#ifdef __cplusplus
+}
+#endif
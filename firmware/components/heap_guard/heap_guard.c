@@ -0,0 +1,105 @@
+/*
+ * heap_guard: see include/heap_guard.h.
+ */
+
+#include "heap_guard.h"
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "esp_attr.h"
+#include "esp_heap_caps.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+#include "esp_cpu.h"
+#include "esp_debug_helpers.h"
+#endif
+
+#define MAX_CALLERS 6
+#define REPORT_PERIOD_MS 500
+#define REPORTER_STACK_BYTES 2560
+
+static volatile uint32_t s_count;
+
+#if CONFIG_HEAP_USE_HOOKS
+static volatile bool s_armed;
+static volatile uint32_t s_bytes;
+static void *volatile s_callers[MAX_CALLERS];
+
+static StaticTask_t s_reporter_tcb;
+static StackType_t s_reporter_stack[REPORTER_STACK_BYTES];
+
+/* Backtrace of the first violation (only the direct caller off Xtensa). */
+static void IRAM_ATTR record_callers(void)
+{
+#if CONFIG_IDF_TARGET_ARCH_XTENSA
+    esp_backtrace_frame_t frame;
+    esp_backtrace_get_start(&frame.pc, &frame.sp, &frame.next_pc);
+    for (int i = 0; i < MAX_CALLERS && esp_backtrace_get_next_frame(&frame); i++) {
+        s_callers[i] = (void *)esp_cpu_process_stack_pc(frame.pc);
+    }
+#else
+    s_callers[0] = __builtin_return_address(0);
+#endif
+}
+
+void IRAM_ATTR esp_heap_trace_alloc_hook(void *ptr, size_t size, uint32_t caps)
+{
+    (void)ptr;
+    (void)caps;
+    if (!s_armed) {
+        return;
+    }
+
+    uint32_t index = __atomic_fetch_add(&s_count, 1, __ATOMIC_RELAXED);
+    __atomic_add_fetch(&s_bytes, size, __ATOMIC_RELAXED);
+    if (index == 0) {
+        record_callers();
+    }
+#if HEAP_GUARD_ABORT
+    abort();
+#endif
+}
+
+static void reporter_task(void *arg)
+{
+    uint32_t reported = 0;
+    for (;;) {
+        uint32_t count = __atomic_load_n(&s_count, __ATOMIC_RELAXED);
+        if (count != reported) {
+            reported = count;
+            printf("@HG,%" PRIu32 ",%" PRIu32, count, s_bytes);
+            for (int i = 0; i < MAX_CALLERS && s_callers[i]; i++) {
+                printf(",%" PRIxPTR, (uintptr_t)s_callers[i]);
+            }
+            putchar('\n');
+        }
+        vTaskDelay(pdMS_TO_TICKS(REPORT_PERIOD_MS));
+    }
+}
+#endif /* CONFIG_HEAP_USE_HOOKS */
+
+esp_err_t heap_guard_arm(void)
+{
+#if CONFIG_HEAP_USE_HOOKS
+    /* First print before arming, so stdout's lazily allocated buffers and
+     * locks are not reported as violations. */
+    printf("@HG,0,0\n");
+    xTaskCreateStatic(reporter_task, "heap_guard", REPORTER_STACK_BYTES, NULL, 1,
+                      s_reporter_stack, &s_reporter_tcb);
+    __atomic_store_n(&s_armed, true, __ATOMIC_RELEASE);
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+uint32_t heap_guard_violations(void)
+{
+    return __atomic_load_n(&s_count, __ATOMIC_RELAXED);
+}
@@ -0,0 +1,46 @@
+/*
+ * heap_guard: detect heap allocations after initialization.
+ *
+ * Static-allocation firmware creates every task, queue, semaphore and timer
+ * while app_main runs and must not touch the heap afterwards. Calling
+ * heap_guard_arm() as the last statement of app_main installs that rule:
+ * every later allocation is counted through the CONFIG_HEAP_USE_HOOKS
+ * allocation hook (with a backtrace of the first one), and a reporter task
+ * prints
+ *
+ *   @HG,<allocations>,<bytes>[,<backtrace_pc>...]
+ *
+ * whenever the count changes (parsed by the benchmark stage; resolve the
+ * addresses with addr2line against the firmware ELF). Define
+ * HEAP_GUARD_ABORT=1 to abort() on the first violation instead.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#ifndef HEAP_GUARD_ABORT
+#define HEAP_GUARD_ABORT 0
+#endif
+
+/**
+ * Forbid heap allocation from now on (call at the end of app_main).
+ *
+ * Returns ESP_ERR_NOT_SUPPORTED if CONFIG_HEAP_USE_HOOKS is disabled.
+ */
+esp_err_t heap_guard_arm(void);
+
+/**
+ * Allocations since heap_guard_arm().
+ */
+uint32_t heap_guard_violations(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,105 @@
+/*
+ * isr_probe: cycle-counter latency histograms for ISRs and the tasks they wake,
+ * plus a periodic per-task CPU load dump.
+ *
+ * Each probe measures two things with esp_cpu_get_cycle_count():
+ *   isr   cycles from isr_probe_enter() to isr_probe_exit() (handler run time)
+ *   wake  cycles from isr_probe_exit() to isr_probe_wake() in the consumer task
+ *         (ISR-to-task wakeup latency)
+ * Samples go into log2 histograms in DRAM (bucket b counts samples of
+ * 2^(b-1) .. 2^b - 1 cycles), so recording is a few instructions and never
+ * blocks or allocates. The cycle counters of the two cores are not in sync:
+ * wake samples taken on the other core than the ISR fall back to esp_timer
+ * time (1 us resolution), which keeps the ISR and its consumer on one core
+ * (see the task placement) the accurate case.
+ *
+ * Typical use:
+ *
+ *     static int s_probe;
+ *
+ *     static void IRAM_ATTR button_isr(void *arg)
+ *     {
+ *         isr_probe_enter(s_probe);
+ *         ...                                  // push event / give notification
+ *         isr_probe_exit(s_probe);
+ *     }
+ *
+ *     static void button_task(void *arg)
+ *     {
+ *         s_probe = isr_probe_register("button");
+ *         isr_probe_start(1000);               // dump every second
+ *         for (;;) {
+ *             if (gpio_event_ring_wait(&s_ring, &ev, portMAX_DELAY)) {
+ *                 isr_probe_wake(s_probe);
+ *                 ...
+ *             }
+ *         }
+ *     }
+ *
+ * Dump line protocol (parsed by src/benchmark.py; histograms are cumulative):
+ *   @IP,S,<cpu_mhz>                                           dump started
+ *   @IP,L,<probe>,<isr|wake>,<count>,<max_cycles>[,<bucket>:<n>...]
+ *   @IP,T,<task_name>,<core>,<cpu_pct>                        CPU share of one
+ *          core since the previous dump (needs the component's sdkconfig options)
+ *   @IP,E                                                     dump finished
+ *
+ * Define ISR_PROBE_DISABLE to compile every probe call out.
+ */
+
+#pragma once
+
+#include <stdint.h>
+
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Maximum number of probes. */
+#ifndef ISR_PROBE_MAX
+#define ISR_PROBE_MAX 8
+#endif
+
+#define ISR_PROBE_BUCKETS 33
+
+#ifndef ISR_PROBE_DISABLE
+
+/**
+ * Register a probe (call at init, not from an ISR).
+ *
+ * @return probe id, or -1 when ISR_PROBE_MAX probes exist (calls with -1 are ignored)
+ */
+int isr_probe_register(const char *name);
+
+/** Stamp ISR entry. IRAM-safe. */
+void isr_probe_enter(int id);
+
+/** Stamp ISR exit: records the handler run time and arms the wake measurement. IRAM-safe. */
+void isr_probe_exit(int id);
+
+/** Stamp consumer wakeup (task context, right after the wait returns). */
+void isr_probe_wake(int id);
+
+/**
+ * Start a low-priority task printing the dump every period_ms.
+ */
+esp_err_t isr_probe_start(uint32_t period_ms);
+
+/** Print one dump now. */
+void isr_probe_dump(void);
+
+#else
+
+static inline int isr_probe_register(const char *name) { (void)name; return -1; }
+static inline void isr_probe_enter(int id) { (void)id; }
+static inline void isr_probe_exit(int id) { (void)id; }
+static inline void isr_probe_wake(int id) { (void)id; }
+static inline esp_err_t isr_probe_start(uint32_t period_ms) { (void)period_ms; return ESP_OK; }
+static inline void isr_probe_dump(void) {}
+
+#endif
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,205 @@
+/*
+ * isr_probe: see include/isr_probe.h.
+ *
+ * Every histogram has a single writer (the probe's ISR for isr, its consumer
+ * task for wake), so recording needs no lock; the dump task reads 32-bit
+ * counters and may see a sample half-recorded, which only shifts one count
+ * between two dumps. Cycle counts are converted with the CPU frequency at
+ * dump time, so keep dynamic frequency scaling off while measuring.
+ */
+
+#include "isr_probe.h"
+
+#ifndef ISR_PROBE_DISABLE
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_cpu.h"
+#include "esp_rom_sys.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+
+#define ISR_PROBE_MAX_TASKS 32
+#define DUMP_STACK_BYTES 3072
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
+static const char *TAG = "isr_probe";
+
+typedef struct {
+    uint32_t count;
+    uint32_t max_cycles;
+    uint32_t buckets[ISR_PROBE_BUCKETS];
+} histogram_t;
+
+typedef struct {
+    const char *name;
+    uint32_t enter_cycles;
+    uint32_t exit_cycles;
+    uint32_t exit_us; /* low 32 bits of esp_timer time, for cross-core wakes */
+    int exit_core;
+    volatile uint32_t armed; /* set by exit, cleared by wake */
+    histogram_t isr;
+    histogram_t wake;
+} probe_t;
+
+static DRAM_ATTR probe_t s_probes[ISR_PROBE_MAX];
+static int s_num_probes;
+static uint32_t s_period_ms;
+
+/* Static, so starting the probe after heap_guard_arm() does not allocate. */
+static StaticTask_t s_dump_tcb;
+static StackType_t s_dump_stack[DUMP_STACK_BYTES];
+
+static inline void IRAM_ATTR record(histogram_t *h, uint32_t cycles)
+{
+    h->buckets[cycles ? 32 - __builtin_clz(cycles) : 0]++;
+    if (cycles > h->max_cycles) {
+        h->max_cycles = cycles;
+    }
+    h->count++;
+}
+
+int isr_probe_register(const char *name)
+{
+    if (s_num_probes == ISR_PROBE_MAX) {
+        ESP_LOGW(TAG, "ISR_PROBE_MAX (%d) probes already registered, '%s' ignored", ISR_PROBE_MAX, name);
+        return -1;
+    }
+    memset(&s_probes[s_num_probes], 0, sizeof(s_probes[0]));
+    s_probes[s_num_probes].name = name;
+    return s_num_probes++;
+}
+
+void IRAM_ATTR isr_probe_enter(int id)
+{
+    if (id >= 0) {
+        s_probes[id].enter_cycles = esp_cpu_get_cycle_count();
+    }
+}
+
+void IRAM_ATTR isr_probe_exit(int id)
+{
+    if (id < 0) {
+        return;
+    }
+    probe_t *p = &s_probes[id];
+    uint32_t now = esp_cpu_get_cycle_count();
+    record(&p->isr, now - p->enter_cycles);
+
+    p->exit_cycles = now;
+    p->exit_us = (uint32_t)esp_timer_get_time();
+    p->exit_core = esp_cpu_get_core_id();
+    __atomic_store_n(&p->armed, 1, __ATOMIC_RELEASE);
+}
+
+void isr_probe_wake(int id)
+{
+    if (id < 0) {
+        return;
+    }
+    probe_t *p = &s_probes[id];
+    if (!__atomic_exchange_n(&p->armed, 0, __ATOMIC_ACQUIRE)) {
+        return;
+    }
+    uint32_t cycles;
+    if (p->exit_core == esp_cpu_get_core_id()) {
+        cycles = esp_cpu_get_cycle_count() - p->exit_cycles;
+    } else {
+        cycles = ((uint32_t)esp_timer_get_time() - p->exit_us) * esp_rom_get_cpu_ticks_per_us();
+    }
+    record(&p->wake, cycles);
+}
+
+static void dump_histogram(const probe_t *p, const char *kind, const histogram_t *h)
+{
+    printf("@IP,L,%s,%s,%" PRIu32 ",%" PRIu32, p->name, kind, h->count, h->max_cycles);
+    for (int b = 0; b < ISR_PROBE_BUCKETS; b++) {
+        if (h->buckets[b]) {
+            printf(",%d:%" PRIu32, b, h->buckets[b]);
+        }
+    }
+    printf("\n");
+}
+
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+/* CPU share of every task since the previous call, in per mille of one core. */
+static void dump_tasks(void)
+{
+    static TaskStatus_t tasks[ISR_PROBE_MAX_TASKS];
+    static struct {
+        UBaseType_t number;
+        configRUN_TIME_COUNTER_TYPE runtime;
+    } last[ISR_PROBE_MAX_TASKS];
+    static UBaseType_t num_last;
+    static configRUN_TIME_COUNTER_TYPE last_total;
+
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    UBaseType_t count = uxTaskGetSystemState(tasks, ISR_PROBE_MAX_TASKS, &total);
+    configRUN_TIME_COUNTER_TYPE elapsed = total - last_total;
+
+    for (UBaseType_t i = 0; i < count && last_total != 0 && elapsed > 0; i++) {
+        UBaseType_t j = 0;
+        while (j < num_last && last[j].number != tasks[i].xTaskNumber) {
+            j++;
+        }
+        if (j == num_last) {
+            continue; /* created since the previous dump */
+        }
+        configRUN_TIME_COUNTER_TYPE delta = tasks[i].ulRunTimeCounter - last[j].runtime;
+        uint32_t permille = (uint32_t)((uint64_t)delta * 1000 / elapsed);
+#if CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID
+        int core = tasks[i].xCoreID == tskNO_AFFINITY ? -1 : (int)tasks[i].xCoreID;
+#else
+        int core = -1;
+#endif
+        printf("@IP,T,%s,%d,%" PRIu32 ".%" PRIu32 "\n", tasks[i].pcTaskName, core, permille / 10, permille % 10);
+    }
+
+    for (num_last = 0; num_last < count; num_last++) {
+        last[num_last].number = tasks[num_last].xTaskNumber;
+        last[num_last].runtime = tasks[num_last].ulRunTimeCounter;
+    }
+    last_total = total;
+}
+#endif
+
+void isr_probe_dump(void)
+{
+    printf("@IP,S,%" PRIu32 "\n", (uint32_t)esp_rom_get_cpu_ticks_per_us());
+    for (int i = 0; i < s_num_probes; i++) {
+        dump_histogram(&s_probes[i], "isr", &s_probes[i].isr);
+        dump_histogram(&s_probes[i], "wake", &s_probes[i].wake);
+    }
+#if CONFIG_FREERTOS_USE_TRACE_FACILITY && CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS
+    dump_tasks();
+#endif
+    printf("@IP,E\n");
+}
+
+static void dump_task(void *arg)
+{
+    TickType_t last_wake = xTaskGetTickCount();
+    while (1) {
+        vTaskDelayUntil(&last_wake, pdMS_TO_TICKS(s_period_ms));
+        isr_probe_dump();
+    }
+}
+
+esp_err_t isr_probe_start(uint32_t period_ms)
+{
+    ESP_RETURN_ON_FALSE(period_ms > 0, ESP_ERR_INVALID_ARG, TAG, "period_ms must be > 0");
+    ESP_RETURN_ON_FALSE(s_period_ms == 0, ESP_ERR_INVALID_STATE, TAG, "already started");
+    s_period_ms = period_ms;
+    xTaskCreateStatic(dump_task, "isr_probe", DUMP_STACK_BYTES, NULL, 1, s_dump_stack, &s_dump_tcb);
+    return ESP_OK;
+}
+
+#endif /* ISR_PROBE_DISABLE */
@@ -0,0 +1,126 @@
+/*
+ * pattern_player: peripheral-timed output patterns on one GPIO via RMT.
+ *
+ * A pattern is a table of (level, duration) steps. It is compiled once into
+ * RMT symbols and played by the RMT peripheral, so step timing is exact to
+ * 1 / PATTERN_PLAYER_RESOLUTION_HZ and the CPU is not involved per step.
+ * Steps longer than one RMT half-symbol are split automatically.
+ *
+ * Looped patterns that fit in the channel memory (mem_block_symbols) are
+ * repeated by the RMT hardware itself; longer ones are re-queued by a
+ * player task that wakes once per repetition.
+ *
+ * With carrier_hz set, high steps are modulated with a square-wave carrier
+ * (passive buzzer tones); without it they drive a plain high level.
+ *
+ * Typical use (SOS forever):
+ *
+ *     static pattern_player_t s_led;
+ *     static pattern_step_t s_steps[64];
+ *
+ *     pattern_player_init(&s_led, &(pattern_player_config_t){.gpio = LED_GPIO});
+ *     size_t n = pattern_morse_compile("SOS", 200, 3, s_steps, 64);
+ *     pattern_player_load(&s_led, s_steps, n);
+ *     pattern_player_play(&s_led, true);
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "driver/rmt_tx.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "freertos/task.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* RMT tick rate; one step half-symbol holds at most 32767 ticks. */
+#ifndef PATTERN_PLAYER_RESOLUTION_HZ
+#define PATTERN_PLAYER_RESOLUTION_HZ 1000000
+#endif
+
+/* Compiled symbols per player (two half-steps each). */
+#ifndef PATTERN_PLAYER_MAX_SYMBOLS
+#define PATTERN_PLAYER_MAX_SYMBOLS 512
+#endif
+
+typedef struct {
+    uint32_t duration_us;
+    uint8_t level;
+} pattern_step_t;
+
+typedef struct {
+    int gpio;
+    uint32_t carrier_hz;       /* 0 = plain levels */
+    size_t mem_block_symbols;  /* RMT channel memory (0 = SOC default block) */
+} pattern_player_config_t;
+
+typedef struct {
+    rmt_channel_handle_t channel;
+    rmt_encoder_handle_t encoder;
+    rmt_symbol_word_t symbols[PATTERN_PLAYER_MAX_SYMBOLS];
+    size_t num_symbols;
+    size_t mem_block_symbols;
+
+    /* Software repeat for patterns that do not fit in channel memory. */
+    TaskHandle_t repeat_task;
+    SemaphoreHandle_t repeat_idle;
+    StaticSemaphore_t repeat_idle_buf;
+    volatile bool repeating;
+    bool hw_looping;
+} pattern_player_t;
+
+/**
+ * Create and enable the RMT TX channel (and the repeat task) once at startup.
+ */
+esp_err_t pattern_player_init(pattern_player_t *player, const pattern_player_config_t *config);
+
+/**
+ * Compile steps into the player's symbol buffer (stops any running pattern).
+ *
+ * @return ESP_ERR_INVALID_SIZE if the pattern needs more than
+ *         PATTERN_PLAYER_MAX_SYMBOLS symbols
+ */
+esp_err_t pattern_player_load(pattern_player_t *player, const pattern_step_t *steps, size_t num_steps);
+
+/**
+ * Start the loaded pattern once or forever; returns immediately.
+ */
+esp_err_t pattern_player_play(pattern_player_t *player, bool loop);
+
+/**
+ * Wait until a one-shot pattern has finished (timeout_ms = -1: forever).
+ */
+esp_err_t pattern_player_wait(pattern_player_t *player, int timeout_ms);
+
+/**
+ * Stop the pattern (hardware loops are aborted immediately).
+ *
+ * Software-repeated patterns stop at the end of the current repetition.
+ */
+esp_err_t pattern_player_stop(pattern_player_t *player);
+
+/**
+ * Load a square wave (PWM) of freq_hz / duty_pct and loop it in hardware.
+ */
+esp_err_t pattern_player_square(pattern_player_t *player, uint32_t freq_hz, uint32_t duty_pct);
+
+/**
+ * Compile text to Morse steps: dot = unit_ms on, dash = dash_units * unit_ms
+ * on, 1 unit between elements, 3 between letters, 7 between words and after
+ * the message (so looping keeps word spacing). Unknown characters are skipped.
+ *
+ * @return number of steps written (0 if they do not fit in max_steps)
+ */
+size_t pattern_morse_compile(const char *text, uint32_t unit_ms, uint32_t dash_units,
+                             pattern_step_t *steps, size_t max_steps);
+
+#ifdef __cplusplus
+}
+#endif
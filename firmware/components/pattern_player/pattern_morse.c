@@ -0,0 +1,68 @@
+/*
+ * Morse text -> pattern_step_t table (see pattern_morse_compile()).
+ */
+
+#include <ctype.h>
+#include <string.h>
+
+#include "pattern_player.h"
+
+static const char *const LETTERS[26] = {
+    ".-", "-...", "-.-.", "-..", ".", "..-.", "--.", "....", "..", ".---", "-.-", ".-..", "--",
+    "-.", "---", ".--.", "--.-", ".-.", "...", "-", "..-", "...-", ".--", "-..-", "-.--", "--..",
+};
+
+static const char *const DIGITS[10] = {
+    "-----", ".----", "..---", "...--", "....-", ".....", "-....", "--...", "---..", "----.",
+};
+
+static const char *code_for(char c)
+{
+    if (isalpha((unsigned char)c)) {
+        return LETTERS[toupper((unsigned char)c) - 'A'];
+    }
+    if (isdigit((unsigned char)c)) {
+        return DIGITS[c - '0'];
+    }
+    return NULL;
+}
+
+size_t pattern_morse_compile(const char *text, uint32_t unit_ms, uint32_t dash_units,
+                             pattern_step_t *steps, size_t max_steps)
+{
+    const uint32_t unit_us = unit_ms * 1000;
+    size_t n = 0;
+
+#define EMIT(lvl, units)                                              \
+    do {                                                              \
+        if (n >= max_steps) {                                         \
+            return 0;                                                 \
+        }                                                             \
+        steps[n++] = (pattern_step_t){.level = (lvl), .duration_us = (units) * unit_us}; \
+    } while (0)
+
+    for (const char *c = text; *c; c++) {
+        if (*c == ' ') {
+            /* Word gap: extend the previous letter gap from 3 to 7 units. */
+            if (n > 0 && steps[n - 1].level == 0) {
+                steps[n - 1].duration_us = 7 * unit_us;
+            }
+            continue;
+        }
+
+        const char *code = code_for(*c);
+        if (!code) {
+            continue;
+        }
+        for (const char *e = code; *e; e++) {
+            EMIT(1, *e == '-' ? dash_units : 1);
+            EMIT(0, e[1] ? 1 : 3);
+        }
+    }
+#undef EMIT
+
+    if (n > 0) {
+        steps[n - 1].duration_us = 7 * unit_us;
+    }
+    return n;
+}
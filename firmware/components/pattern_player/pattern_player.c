@@ -0,0 +1,163 @@
+/*
+ * pattern_player: see include/pattern_player.h.
+ */
+
+#include "pattern_player.h"
+
+#include "driver/gpio.h"
+#include "driver/rmt_encoder.h"
+#include "esp_check.h"
+#include "soc/soc_caps.h"
+
+#define MAX_HALF_TICKS 32767U
+#define US_TO_TICKS(us) ((uint64_t)(us) * PATTERN_PLAYER_RESOLUTION_HZ / 1000000)
+
+static const char *TAG = "pattern_player";
+
+static const rmt_transmit_config_t ONCE = {.loop_count = 0, .flags.eot_level = 0};
+static const rmt_transmit_config_t HW_LOOP = {.loop_count = -1, .flags.eot_level = 0};
+
+static void repeat_task(void *arg)
+{
+    pattern_player_t *player = (pattern_player_t *)arg;
+
+    for (;;) {
+        ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+        while (player->repeating) {
+            if (rmt_transmit(player->channel, player->encoder, player->symbols,
+                             player->num_symbols * sizeof(rmt_symbol_word_t), &ONCE) != ESP_OK) {
+                break;
+            }
+            rmt_tx_wait_all_done(player->channel, -1);
+        }
+        xSemaphoreGive(player->repeat_idle);
+    }
+}
+
+esp_err_t pattern_player_init(pattern_player_t *player, const pattern_player_config_t *config)
+{
+    ESP_RETURN_ON_FALSE(player && config && GPIO_IS_VALID_OUTPUT_GPIO(config->gpio),
+                        ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    player->num_symbols = 0;
+    player->repeating = false;
+    player->hw_looping = false;
+    player->mem_block_symbols = config->mem_block_symbols ? config->mem_block_symbols
+                                                          : SOC_RMT_MEM_WORDS_PER_CHANNEL;
+
+    const rmt_tx_channel_config_t channel_config = {
+        .gpio_num = config->gpio,
+        .clk_src = RMT_CLK_SRC_DEFAULT,
+        .resolution_hz = PATTERN_PLAYER_RESOLUTION_HZ,
+        .mem_block_symbols = player->mem_block_symbols,
+        .trans_queue_depth = 2,
+    };
+    ESP_RETURN_ON_ERROR(rmt_new_tx_channel(&channel_config, &player->channel), TAG, "rmt_new_tx_channel failed");
+
+    if (config->carrier_hz) {
+        const rmt_carrier_config_t carrier = {
+            .frequency_hz = config->carrier_hz,
+            .duty_cycle = 0.5,
+        };
+        ESP_RETURN_ON_ERROR(rmt_apply_carrier(player->channel, &carrier), TAG, "rmt_apply_carrier failed");
+    }
+
+    const rmt_copy_encoder_config_t encoder_config = {};
+    ESP_RETURN_ON_ERROR(rmt_new_copy_encoder(&encoder_config, &player->encoder), TAG, "rmt_new_copy_encoder failed");
+    ESP_RETURN_ON_ERROR(rmt_enable(player->channel), TAG, "rmt_enable failed");
+
+    player->repeat_idle = xSemaphoreCreateBinaryStatic(&player->repeat_idle_buf);
+    ESP_RETURN_ON_FALSE(xTaskCreate(repeat_task, "pattern_player", 2048, player,
+                                    configMAX_PRIORITIES - 2, &player->repeat_task) == pdPASS,
+                        ESP_ERR_NO_MEM, TAG, "repeat task creation failed");
+    return ESP_OK;
+}
+
+esp_err_t pattern_player_load(pattern_player_t *player, const pattern_step_t *steps, size_t num_steps)
+{
+    ESP_RETURN_ON_ERROR(pattern_player_stop(player), TAG, "stop failed");
+
+    /* Flatten steps into half-symbols of at most MAX_HALF_TICKS each. */
+    size_t halves = 0;
+    for (size_t i = 0; i < num_steps; i++) {
+        uint64_t ticks = US_TO_TICKS(steps[i].duration_us);
+        while (ticks > 0) {
+            uint32_t chunk = ticks > MAX_HALF_TICKS ? MAX_HALF_TICKS : (uint32_t)ticks;
+            ticks -= chunk;
+
+            size_t index = halves / 2;
+            ESP_RETURN_ON_FALSE(index < PATTERN_PLAYER_MAX_SYMBOLS, ESP_ERR_INVALID_SIZE, TAG,
+                                "pattern needs more than %d symbols", PATTERN_PLAYER_MAX_SYMBOLS);
+            rmt_symbol_word_t *symbol = &player->symbols[index];
+            if (halves % 2 == 0) {
+                symbol->level0 = steps[i].level ? 1 : 0;
+                symbol->duration0 = chunk;
+            } else {
+                symbol->level1 = steps[i].level ? 1 : 0;
+                symbol->duration1 = chunk;
+            }
+            halves++;
+        }
+    }
+
+    if (halves % 2) {
+        /* Pad the final symbol with a minimal low half. */
+        rmt_symbol_word_t *symbol = &player->symbols[halves / 2];
+        symbol->level1 = 0;
+        symbol->duration1 = 1;
+        halves++;
+    }
+
+    player->num_symbols = halves / 2;
+    return ESP_OK;
+}
+
+esp_err_t pattern_player_play(pattern_player_t *player, bool loop)
+{
+    ESP_RETURN_ON_FALSE(player->num_symbols > 0, ESP_ERR_INVALID_STATE, TAG, "no pattern loaded");
+    ESP_RETURN_ON_ERROR(pattern_player_stop(player), TAG, "stop failed");
+
+    if (loop && player->num_symbols > player->mem_block_symbols) {
+        player->repeating = true;
+        xTaskNotifyGive(player->repeat_task);
+        return ESP_OK;
+    }
+
+    player->hw_looping = loop;
+    return rmt_transmit(player->channel, player->encoder, player->symbols,
+                        player->num_symbols * sizeof(rmt_symbol_word_t), loop ? &HW_LOOP : &ONCE);
+}
+
+esp_err_t pattern_player_wait(pattern_player_t *player, int timeout_ms)
+{
+    return rmt_tx_wait_all_done(player->channel, timeout_ms);
+}
+
+esp_err_t pattern_player_stop(pattern_player_t *player)
+{
+    if (player->repeating) {
+        player->repeating = false;
+        xSemaphoreTake(player->repeat_idle, portMAX_DELAY);
+    }
+
+    if (player->hw_looping) {
+        /* An infinite loop never completes; disabling aborts it. */
+        player->hw_looping = false;
+        ESP_RETURN_ON_ERROR(rmt_disable(player->channel), TAG, "rmt_disable failed");
+        ESP_RETURN_ON_ERROR(rmt_enable(player->channel), TAG, "rmt_enable failed");
+    }
+    return rmt_tx_wait_all_done(player->channel, -1);
+}
+
+esp_err_t pattern_player_square(pattern_player_t *player, uint32_t freq_hz, uint32_t duty_pct)
+{
+    ESP_RETURN_ON_FALSE(freq_hz > 0 && duty_pct > 0 && duty_pct < 100, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    uint32_t period_us = 1000000 / freq_hz;
+    const pattern_step_t steps[] = {
+        {.level = 1, .duration_us = period_us * duty_pct / 100},
+        {.level = 0, .duration_us = period_us - period_us * duty_pct / 100},
+    };
+    ESP_RETURN_ON_ERROR(pattern_player_load(player, steps, 2), TAG, "load failed");
+    return pattern_player_play(player, true);
+}
@@ -0,0 +1,64 @@
+/*
+ * periodic_timer: one gptimer allocated at startup, retuned at runtime.
+ *
+ * periodic_timer_init() creates, enables and starts the gptimer once.
+ * Changing the period afterwards only reprograms the alarm
+ * (gptimer_set_alarm_action), so it never allocates, never re-initializes
+ * the driver and is safe to call from a task or an ISR (the component's
+ * sdkconfig.defaults places the gpio and gptimer control functions it uses
+ * in IRAM, CONFIG_GPIO_CTRL_FUNC_IN_IRAM / CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM).
+ *
+ * Typical use (LED toggled at a button-selected rate):
+ *
+ *     static periodic_timer_t s_led;
+ *
+ *     periodic_timer_init_toggle(&s_led, LED_GPIO);    // once, at startup
+ *     ...
+ *     periodic_timer_set_period_us(&s_led, 500000);    // toggle every 500 ms (1 Hz blink)
+ *     periodic_timer_set_period_us(&s_led, 0);         // stop, LED off
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gptimer.h"
+#include "esp_err.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called from the timer ISR on every period; keep it short (IRAM_ATTR). */
+typedef void (*periodic_timer_cb_t)(void *arg);
+
+typedef struct {
+    gptimer_handle_t timer;
+    periodic_timer_cb_t cb;
+    void *arg;
+    int toggle_gpio; /* -1 unless created with periodic_timer_init_toggle() */
+    int level;
+    uint64_t period_us;
+} periodic_timer_t;
+
+/**
+ * Allocate and start the timer (1 us resolution), initially without alarm.
+ */
+esp_err_t periodic_timer_init(periodic_timer_t *t, periodic_timer_cb_t cb, void *arg);
+
+/**
+ * Like periodic_timer_init(), toggling gpio (configured as output, low) each period.
+ */
+esp_err_t periodic_timer_init_toggle(periodic_timer_t *t, int gpio);
+
+/**
+ * Set the period, restarting the phase; 0 stops the callback.
+ *
+ * For toggle timers, stopping also drives the pin low.
+ */
+esp_err_t periodic_timer_set_period_us(periodic_timer_t *t, uint64_t period_us);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,87 @@
+/*
+ * periodic_timer: see include/periodic_timer.h.
+ */
+
+#include "periodic_timer.h"
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+
+#define TIMER_RESOLUTION_HZ 1000000
+
+static const char *TAG = "periodic_timer";
+
+static bool IRAM_ATTR on_alarm(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    periodic_timer_t *t = (periodic_timer_t *)arg;
+
+    if (t->toggle_gpio >= 0) {
+        t->level = !t->level;
+        gpio_set_level(t->toggle_gpio, t->level);
+    }
+    if (t->cb) {
+        t->cb(t->arg);
+    }
+    return false;
+}
+
+static esp_err_t start_timer(periodic_timer_t *t)
+{
+    const gptimer_config_t config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    ESP_RETURN_ON_ERROR(gptimer_new_timer(&config, &t->timer), TAG, "gptimer_new_timer failed");
+
+    const gptimer_event_callbacks_t callbacks = {.on_alarm = on_alarm};
+    ESP_RETURN_ON_ERROR(gptimer_register_event_callbacks(t->timer, &callbacks, t), TAG, "register callbacks failed");
+    ESP_RETURN_ON_ERROR(gptimer_enable(t->timer), TAG, "gptimer_enable failed");
+    return gptimer_start(t->timer);
+}
+
+esp_err_t periodic_timer_init(periodic_timer_t *t, periodic_timer_cb_t cb, void *arg)
+{
+    ESP_RETURN_ON_FALSE(t && cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *t = (periodic_timer_t){.cb = cb, .arg = arg, .toggle_gpio = -1};
+    return start_timer(t);
+}
+
+esp_err_t periodic_timer_init_toggle(periodic_timer_t *t, int gpio)
+{
+    ESP_RETURN_ON_FALSE(t && GPIO_IS_VALID_OUTPUT_GPIO(gpio), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << gpio,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "gpio_config failed");
+    gpio_set_level(gpio, 0);
+
+    *t = (periodic_timer_t){.toggle_gpio = gpio};
+    return start_timer(t);
+}
+
+esp_err_t IRAM_ATTR periodic_timer_set_period_us(periodic_timer_t *t, uint64_t period_us)
+{
+    t->period_us = period_us;
+
+    if (period_us == 0) {
+        esp_err_t err = gptimer_set_alarm_action(t->timer, NULL);
+        if (t->toggle_gpio >= 0) {
+            t->level = 0;
+            gpio_set_level(t->toggle_gpio, 0);
+        }
+        return err;
+    }
+
+    const gptimer_alarm_config_t alarm = {
+        .alarm_count = period_us,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    gptimer_set_raw_count(t->timer, 0);
+    return gptimer_set_alarm_action(t->timer, &alarm);
+}
@@ -0,0 +1,78 @@
+/*
+ * pm_helper: automatic light sleep for timer/interrupt-driven firmware.
+ *
+ * pm_helper_init() turns on dynamic frequency scaling and automatic light
+ * sleep (needs CONFIG_PM_ENABLE and CONFIG_FREERTOS_USE_TICKLESS_IDLE, as
+ * set by the low-power sdkconfig profile). From then on the chip sleeps
+ * whenever every task is blocked, and wakes for the next esp_timer alarm,
+ * FreeRTOS timeout or enabled wakeup source.
+ *
+ * Hold a lock only while a peripheral actually needs a clock that light
+ * sleep would stop (e.g. while a UART transfer or an LEDC tone is running):
+ *
+ *     static pm_helper_lock_t s_tone_lock;
+ *
+ *     pm_helper_lock_init(&s_tone_lock, PM_HELPER_NO_SLEEP, "tone");
+ *     pm_helper_hold(&s_tone_lock);     // before starting the tone
+ *     ...
+ *     pm_helper_release(&s_tone_lock);  // once it has ended
+ *
+ * GPIO edge interrupts do not fire during light sleep. Buttons added to
+ * button_debounce wake the chip by themselves; other inputs that must wake
+ * it are registered with pm_helper_gpio_wakeup().
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "esp_err.h"
+#include "esp_pm.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    PM_HELPER_NO_SLEEP = ESP_PM_NO_LIGHT_SLEEP,   /* keep the chip awake */
+    PM_HELPER_APB_MAX = ESP_PM_APB_FREQ_MAX,      /* awake, APB at 80 MHz */
+    PM_HELPER_CPU_MAX = ESP_PM_CPU_FREQ_MAX,      /* awake, CPU at max_mhz */
+} pm_helper_lock_type_t;
+
+typedef struct {
+    esp_pm_lock_handle_t handle;
+    volatile int32_t holds;
+} pm_helper_lock_t;
+
+/**
+ * Enable DFS between min_mhz and max_mhz and automatic light sleep.
+ *
+ * Returns ESP_ERR_NOT_SUPPORTED when CONFIG_PM_ENABLE is off; callers can
+ * treat that as "run without power management".
+ */
+esp_err_t pm_helper_init(int max_mhz, int min_mhz);
+
+/**
+ * Create a lock (not held) once at startup.
+ */
+esp_err_t pm_helper_lock_init(pm_helper_lock_t *lock, pm_helper_lock_type_t type, const char *name);
+
+/**
+ * Acquire / release a lock; calls nest. ISR-safe.
+ */
+esp_err_t pm_helper_hold(pm_helper_lock_t *lock);
+esp_err_t pm_helper_release(pm_helper_lock_t *lock);
+
+/**
+ * Wake from light sleep while gpio is at level.
+ *
+ * This replaces the pin's interrupt type with the same level trigger, so an
+ * edge interrupt on gpio becomes a level interrupt. Not for button_debounce
+ * pins, which manage their own wakeup.
+ */
+esp_err_t pm_helper_gpio_wakeup(int gpio, int level);
+
+#ifdef __cplusplus
+}
+#endif
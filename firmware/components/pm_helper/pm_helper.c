@@ -0,0 +1,72 @@
+/*
+ * pm_helper: see include/pm_helper.h.
+ */
+
+#include "pm_helper.h"
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "esp_log.h"
+#include "esp_sleep.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "pm_helper";
+
+esp_err_t pm_helper_init(int max_mhz, int min_mhz)
+{
+#if CONFIG_PM_ENABLE
+    const esp_pm_config_t config = {
+        .max_freq_mhz = max_mhz,
+        .min_freq_mhz = min_mhz,
+#if CONFIG_FREERTOS_USE_TICKLESS_IDLE
+        .light_sleep_enable = true,
+#endif
+    };
+    ESP_RETURN_ON_ERROR(esp_pm_configure(&config), TAG, "esp_pm_configure failed");
+#if !CONFIG_FREERTOS_USE_TICKLESS_IDLE
+    ESP_LOGW(TAG, "CONFIG_FREERTOS_USE_TICKLESS_IDLE is off: DFS only, no light sleep");
+#endif
+    return ESP_OK;
+#else
+    (void)max_mhz;
+    (void)min_mhz;
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+}
+
+esp_err_t pm_helper_lock_init(pm_helper_lock_t *lock, pm_helper_lock_type_t type, const char *name)
+{
+    ESP_RETURN_ON_FALSE(lock, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+    lock->holds = 0;
+    lock->handle = NULL;
+#if CONFIG_PM_ENABLE
+    return esp_pm_lock_create((esp_pm_lock_type_t)type, 0, name, &lock->handle);
+#else
+    (void)type;
+    (void)name;
+    return ESP_OK;
+#endif
+}
+
+esp_err_t IRAM_ATTR pm_helper_hold(pm_helper_lock_t *lock)
+{
+    __atomic_add_fetch(&lock->holds, 1, __ATOMIC_RELAXED);
+    return lock->handle ? esp_pm_lock_acquire(lock->handle) : ESP_OK;
+}
+
+esp_err_t IRAM_ATTR pm_helper_release(pm_helper_lock_t *lock)
+{
+    if (__atomic_sub_fetch(&lock->holds, 1, __ATOMIC_RELAXED) < 0) {
+        __atomic_add_fetch(&lock->holds, 1, __ATOMIC_RELAXED);
+        return ESP_ERR_INVALID_STATE;
+    }
+    return lock->handle ? esp_pm_lock_release(lock->handle) : ESP_OK;
+}
+
+esp_err_t pm_helper_gpio_wakeup(int gpio, int level)
+{
+    ESP_RETURN_ON_ERROR(gpio_wakeup_enable(gpio, level ? GPIO_INTR_HIGH_LEVEL : GPIO_INTR_LOW_LEVEL),
+                        TAG, "gpio_wakeup_enable failed");
+    return esp_sleep_enable_gpio_wakeup();
+}
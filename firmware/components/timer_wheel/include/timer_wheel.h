@@ -0,0 +1,113 @@
+/*
+ * timer_wheel: many periodic and one-shot channels on one gptimer.
+ *
+ * timer_wheel_init() allocates a single gptimer whose auto-reload alarm
+ * fires every tick_us. The tick ISR advances a hashed timing wheel of
+ * TIMER_WHEEL_SLOTS lists: a channel due n ticks ahead sits in slot
+ * (now + n) % TIMER_WHEEL_SLOTS, so each tick only visits that slot's list
+ * and the due channels are found in O(1). Periods longer than
+ * TIMER_WHEEL_SLOTS ticks wait out whole wheel revolutions in their slot.
+ *
+ * GPIO channels do not write their pin themselves: every pin change due on a
+ * tick is collected into one set mask and one clear mask and applied through
+ * GPIO.out_w1tc / GPIO.out_w1ts (out1_* for GPIO 32+), so outputs toggling
+ * on the same tick change in the same register write. Periodic channels are
+ * phase-aligned to multiples of their period, so a 500 ms and a 1 s LED
+ * toggle together every second whenever they were started.
+ *
+ * Typical use (two LEDs, one timer):
+ *
+ *     static timer_wheel_t s_wheel;
+ *     static timer_wheel_channel_t s_led1, s_led2;
+ *
+ *     timer_wheel_init(&s_wheel, 1000);                      // 1 ms tick, once at startup
+ *     timer_wheel_channel_init_gpio(&s_led1, LED1_GPIO);
+ *     timer_wheel_channel_init_gpio(&s_led2, LED2_GPIO);
+ *     timer_wheel_start_periodic(&s_wheel, &s_led1, 500000); // toggle every 500 ms
+ *     timer_wheel_start_periodic(&s_wheel, &s_led2, 1000000);
+ *     ...
+ *     timer_wheel_start_oneshot(&s_wheel, &s_led1, 100000);  // 100 ms pulse instead
+ *     timer_wheel_stop(&s_wheel, &s_led2);                   // stop, LED off
+ */
+
+#pragma once
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "driver/gptimer.h"
+#include "esp_err.h"
+#include "freertos/FreeRTOS.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Wheel size (power of two); periods up to this many ticks are only visited when due. */
+#ifndef TIMER_WHEEL_SLOTS
+#define TIMER_WHEEL_SLOTS 256
+#endif
+
+/*
+ * Called from the tick ISR when the channel is due; keep it short (IRAM_ATTR).
+ * Return true if a higher-priority task was woken (like gptimer callbacks).
+ */
+typedef bool (*timer_wheel_cb_t)(void *arg);
+
+typedef struct timer_wheel_channel {
+    struct timer_wheel_channel *next;
+    struct timer_wheel_channel **pprev; /* NULL while not scheduled */
+    timer_wheel_cb_t cb;
+    void *arg;
+    int gpio; /* -1 unless created with timer_wheel_channel_init_gpio() */
+    int level;
+    uint32_t period_ticks; /* 0 for one-shot */
+    uint32_t rounds;       /* wheel revolutions left before due */
+} timer_wheel_channel_t;
+
+typedef struct {
+    gptimer_handle_t timer;
+    uint32_t tick_us;
+    uint32_t now; /* ticks since start */
+    portMUX_TYPE lock;
+    timer_wheel_channel_t *slots[TIMER_WHEEL_SLOTS];
+} timer_wheel_t;
+
+/**
+ * Allocate and start the wheel's gptimer (1 us resolution) with a tick_us period.
+ */
+esp_err_t timer_wheel_init(timer_wheel_t *w, uint32_t tick_us);
+
+/**
+ * Set up a channel calling cb(arg) from the tick ISR when due.
+ */
+esp_err_t timer_wheel_channel_init(timer_wheel_channel_t *ch, timer_wheel_cb_t cb, void *arg);
+
+/**
+ * Set up a channel driving gpio (configured as output, low): toggled each
+ * period, or high for the length of a one-shot.
+ */
+esp_err_t timer_wheel_channel_init_gpio(timer_wheel_channel_t *ch, int gpio);
+
+/**
+ * (Re)start ch with period_us (rounded to whole ticks); 0 stops it.
+ *
+ * ISR-safe; takes effect on the next multiple of the period.
+ */
+esp_err_t timer_wheel_start_periodic(timer_wheel_t *w, timer_wheel_channel_t *ch, uint64_t period_us);
+
+/**
+ * (Re)arm ch to fire once after delay_us (rounded up to whole ticks).
+ *
+ * GPIO channels go high now and low when it fires. ISR-safe.
+ */
+esp_err_t timer_wheel_start_oneshot(timer_wheel_t *w, timer_wheel_channel_t *ch, uint64_t delay_us);
+
+/**
+ * Unschedule ch; GPIO channels are driven low. ISR-safe.
+ */
+void timer_wheel_stop(timer_wheel_t *w, timer_wheel_channel_t *ch);
+
+#ifdef __cplusplus
+}
+#endif
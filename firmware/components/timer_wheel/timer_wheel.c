@@ -0,0 +1,234 @@
+/*
+ * timer_wheel: see include/timer_wheel.h.
+ *
+ * Every slot list and channel field is guarded by the wheel's spinlock.
+ * The tick ISR detaches the current slot's list before walking it, so a
+ * channel rescheduled into the same slot (period of exactly
+ * TIMER_WHEEL_SLOTS ticks) waits for the next revolution, and drops the
+ * lock around callbacks, which may start or stop channels themselves.
+ */
+
+#include "timer_wheel.h"
+
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#include "esp_check.h"
+#include "soc/gpio_struct.h"
+#include "soc/soc_caps.h"
+
+_Static_assert((TIMER_WHEEL_SLOTS & (TIMER_WHEEL_SLOTS - 1)) == 0, "TIMER_WHEEL_SLOTS must be a power of two");
+
+#define TIMER_RESOLUTION_HZ 1000000
+#define SLOT_MASK (TIMER_WHEEL_SLOTS - 1)
+
+static const char *TAG = "timer_wheel";
+
+static inline void IRAM_ATTR wheel_link(timer_wheel_channel_t **head, timer_wheel_channel_t *ch)
+{
+    ch->next = *head;
+    if (ch->next) {
+        ch->next->pprev = &ch->next;
+    }
+    ch->pprev = head;
+    *head = ch;
+}
+
+static inline void IRAM_ATTR wheel_unlink(timer_wheel_channel_t *ch)
+{
+    if (!ch->pprev) {
+        return;
+    }
+    *ch->pprev = ch->next;
+    if (ch->next) {
+        ch->next->pprev = ch->pprev;
+    }
+    ch->next = NULL;
+    ch->pprev = NULL;
+}
+
+/* Due `ticks` (>= 1) ticks from now. */
+static inline void IRAM_ATTR schedule(timer_wheel_t *w, timer_wheel_channel_t *ch, uint32_t ticks)
+{
+    ch->rounds = (ticks - 1) / TIMER_WHEEL_SLOTS;
+    wheel_link(&w->slots[(w->now + ticks) & SLOT_MASK], ch);
+}
+
+/* Apply a tick's pin changes: one clear and one set write per GPIO bank. */
+static inline void IRAM_ATTR write_outputs(uint64_t set, uint64_t clear)
+{
+    if ((uint32_t)clear) {
+        GPIO.out_w1tc = (uint32_t)clear;
+    }
+    if ((uint32_t)set) {
+        GPIO.out_w1ts = (uint32_t)set;
+    }
+#if SOC_GPIO_PIN_COUNT > 32
+    if (clear >> 32) {
+        GPIO.out1_w1tc.val = (uint32_t)(clear >> 32);
+    }
+    if (set >> 32) {
+        GPIO.out1_w1ts.val = (uint32_t)(set >> 32);
+    }
+#endif
+}
+
+static bool IRAM_ATTR on_tick(gptimer_handle_t timer, const gptimer_alarm_event_data_t *edata, void *arg)
+{
+    timer_wheel_t *w = (timer_wheel_t *)arg;
+    uint64_t set = 0;
+    uint64_t clear = 0;
+    bool woken = false;
+
+    portENTER_CRITICAL_ISR(&w->lock);
+    w->now++;
+    timer_wheel_channel_t **slot = &w->slots[w->now & SLOT_MASK];
+    timer_wheel_channel_t *due = *slot;
+    *slot = NULL;
+    if (due) {
+        due->pprev = &due;
+    }
+
+    timer_wheel_channel_t *ch;
+    while ((ch = due) != NULL) {
+        wheel_unlink(ch);
+        if (ch->rounds) {
+            ch->rounds--;
+            wheel_link(slot, ch);
+            continue;
+        }
+
+        if (ch->period_ticks) {
+            schedule(w, ch, ch->period_ticks);
+        }
+        if (ch->gpio >= 0) {
+            ch->level = ch->period_ticks ? !ch->level : 0;
+            if (ch->level) {
+                set |= 1ULL << ch->gpio;
+            } else {
+                clear |= 1ULL << ch->gpio;
+            }
+        }
+        if (ch->cb) {
+            timer_wheel_cb_t cb = ch->cb;
+            void *cb_arg = ch->arg;
+            portEXIT_CRITICAL_ISR(&w->lock);
+            woken |= cb(cb_arg);
+            portENTER_CRITICAL_ISR(&w->lock);
+        }
+    }
+    portEXIT_CRITICAL_ISR(&w->lock);
+
+    write_outputs(set, clear);
+    return woken;
+}
+
+esp_err_t timer_wheel_init(timer_wheel_t *w, uint32_t tick_us)
+{
+    ESP_RETURN_ON_FALSE(w && tick_us > 0, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *w = (timer_wheel_t){.tick_us = tick_us, .lock = portMUX_INITIALIZER_UNLOCKED};
+
+    const gptimer_config_t config = {
+        .clk_src = GPTIMER_CLK_SRC_DEFAULT,
+        .direction = GPTIMER_COUNT_UP,
+        .resolution_hz = TIMER_RESOLUTION_HZ,
+    };
+    ESP_RETURN_ON_ERROR(gptimer_new_timer(&config, &w->timer), TAG, "gptimer_new_timer failed");
+
+    const gptimer_event_callbacks_t callbacks = {.on_alarm = on_tick};
+    ESP_RETURN_ON_ERROR(gptimer_register_event_callbacks(w->timer, &callbacks, w), TAG, "register callbacks failed");
+
+    const gptimer_alarm_config_t alarm = {
+        .alarm_count = tick_us,
+        .reload_count = 0,
+        .flags.auto_reload_on_alarm = true,
+    };
+    ESP_RETURN_ON_ERROR(gptimer_set_alarm_action(w->timer, &alarm), TAG, "set alarm failed");
+    ESP_RETURN_ON_ERROR(gptimer_enable(w->timer), TAG, "gptimer_enable failed");
+    return gptimer_start(w->timer);
+}
+
+esp_err_t timer_wheel_channel_init(timer_wheel_channel_t *ch, timer_wheel_cb_t cb, void *arg)
+{
+    ESP_RETURN_ON_FALSE(ch && cb, ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    *ch = (timer_wheel_channel_t){.cb = cb, .arg = arg, .gpio = -1};
+    return ESP_OK;
+}
+
+esp_err_t timer_wheel_channel_init_gpio(timer_wheel_channel_t *ch, int gpio)
+{
+    ESP_RETURN_ON_FALSE(ch && GPIO_IS_VALID_OUTPUT_GPIO(gpio), ESP_ERR_INVALID_ARG, TAG, "invalid argument");
+
+    const gpio_config_t io_config = {
+        .pin_bit_mask = 1ULL << gpio,
+        .mode = GPIO_MODE_OUTPUT,
+    };
+    ESP_RETURN_ON_ERROR(gpio_config(&io_config), TAG, "gpio_config failed");
+    gpio_set_level(gpio, 0);
+
+    *ch = (timer_wheel_channel_t){.gpio = gpio};
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR timer_wheel_start_periodic(timer_wheel_t *w, timer_wheel_channel_t *ch, uint64_t period_us)
+{
+    if (period_us == 0) {
+        timer_wheel_stop(w, ch);
+        return ESP_OK;
+    }
+    uint64_t ticks = (period_us + w->tick_us / 2) / w->tick_us;
+    if (ticks > UINT32_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    portENTER_CRITICAL_SAFE(&w->lock);
+    wheel_unlink(ch);
+    ch->period_ticks = (uint32_t)ticks;
+    schedule(w, ch, ch->period_ticks - w->now % ch->period_ticks);
+    portEXIT_CRITICAL_SAFE(&w->lock);
+    return ESP_OK;
+}
+
+esp_err_t IRAM_ATTR timer_wheel_start_oneshot(timer_wheel_t *w, timer_wheel_channel_t *ch, uint64_t delay_us)
+{
+    uint64_t ticks = (delay_us + w->tick_us - 1) / w->tick_us;
+    if (ticks > UINT32_MAX) {
+        return ESP_ERR_INVALID_ARG;
+    }
+    if (ticks == 0) {
+        ticks = 1;
+    }
+
+    portENTER_CRITICAL_SAFE(&w->lock);
+    wheel_unlink(ch);
+    ch->period_ticks = 0;
+    schedule(w, ch, (uint32_t)ticks);
+    bool rising = ch->gpio >= 0 && !ch->level;
+    if (ch->gpio >= 0) {
+        ch->level = 1;
+    }
+    portEXIT_CRITICAL_SAFE(&w->lock);
+
+    if (rising) {
+        write_outputs(1ULL << ch->gpio, 0);
+    }
+    return ESP_OK;
+}
+
+void IRAM_ATTR timer_wheel_stop(timer_wheel_t *w, timer_wheel_channel_t *ch)
+{
+    portENTER_CRITICAL_SAFE(&w->lock);
+    wheel_unlink(ch);
+    ch->period_ticks = 0;
+    bool falling = ch->gpio >= 0;
+    ch->level = 0;
+    portEXIT_CRITICAL_SAFE(&w->lock);
+
+    if (falling) {
+        write_outputs(0, 1ULL << ch->gpio);
+    }
+}
@@ -0,0 +1,241 @@
+/*
+ * edge_trace: esp_timer-stamped GPIO edge trace over UART for the benchmark stage.
+ *
+ * A periodic esp_timer (ISR dispatch) samples the watched pins every
+ * EDGE_TRACE_SAMPLE_US from the pad input register. Output pins are read back
+ * from the pad too, not from the GPIO output latch: outputs driven by RMT
+ * (pattern_player) or LEDC (gpio_pulse tones) are routed through the GPIO
+ * matrix and never change the latch. The sampler keeps the input buffer of
+ * every traced output pin enabled (re-enabling it after the generated code's
+ * gpio_config() turns it off); the output driver is not touched. Level
+ * changes go through a single-producer / single-consumer ring to a
+ * low-priority task that prints them.
+ *
+ * Line protocol (parsed by src/benchmark.py):
+ *   @ET,S,<sample_us>,<output_mask_hex>,<input_mask_hex>   trace started
+ *   @ET,E,<gpio>,<level>,<t_us>                            level change
+ *   @ET,I,<core0_idle_pct>,<core1_idle_pct>                 CPU idle over the last second
+ *   @ET,H,<task_name>,<free_bytes>                         new stack high-water mark
+ *   @ET,O,<count>                                          samples dropped (ring full)
+ *
+ * Edge timestamps have a resolution of EDGE_TRACE_SAMPLE_US.
+ */
+
+#include <inttypes.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "esp_attr.h"
+#include "esp_err.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "soc/gpio_periph.h"
+#include "soc/gpio_reg.h"
+#include "soc/io_mux_reg.h"
+#include "soc/soc.h"
+#include "soc/soc_caps.h"
+
+#include "edge_trace_config.h"
+
+#ifndef EDGE_TRACE_SAMPLE_US
+#define EDGE_TRACE_SAMPLE_US 100
+#endif
+
+#define EDGE_TRACE_RING_SIZE 1024 /* power of two */
+#define EDGE_TRACE_MAX_TASKS 32
+#define EDGE_TRACE_STATS_PERIOD_MS 1000
+
+#ifndef configRUN_TIME_COUNTER_TYPE
+#define configRUN_TIME_COUNTER_TYPE uint32_t
+#endif
+
+typedef struct {
+    uint64_t changed;
+    uint64_t levels;
+    int64_t t_us;
+} edge_sample_t;
+
+static edge_sample_t s_ring[EDGE_TRACE_RING_SIZE];
+static volatile uint32_t s_head;
+static volatile uint32_t s_tail;
+static volatile uint32_t s_overflows;
+static uint64_t s_last_levels;
+
+/* IO_MUX registers of the traced output pins (DRAM: read from the ISR). */
+static DRAM_ATTR uint32_t s_output_mux_regs[64];
+static DRAM_ATTR int s_num_outputs;
+
+static inline void IRAM_ATTR enable_output_readback(void)
+{
+    for (int i = 0; i < s_num_outputs; i++) {
+        if (!(REG_READ(s_output_mux_regs[i]) & FUN_IE)) {
+            PIN_INPUT_ENABLE(s_output_mux_regs[i]);
+        }
+    }
+}
+
+static inline uint64_t IRAM_ATTR read_levels(void)
+{
+    uint64_t in = ((uint64_t)REG_READ(GPIO_IN1_REG) << 32) | REG_READ(GPIO_IN_REG);
+    return in & (EDGE_TRACE_OUTPUT_MASK | EDGE_TRACE_INPUT_MASK);
+}
+
+static void IRAM_ATTR sample_cb(void *arg)
+{
+    enable_output_readback();
+    uint64_t levels = read_levels();
+    uint64_t changed = levels ^ s_last_levels;
+    if (!changed) {
+        return;
+    }
+    s_last_levels = levels;
+
+    uint32_t head = s_head;
+    if (head - __atomic_load_n(&s_tail, __ATOMIC_ACQUIRE) >= EDGE_TRACE_RING_SIZE) {
+        s_overflows++;
+        return;
+    }
+    s_ring[head & (EDGE_TRACE_RING_SIZE - 1)] = (edge_sample_t){
+        .changed = changed,
+        .levels = levels,
+        .t_us = esp_timer_get_time(),
+    };
+    __atomic_store_n(&s_head, head + 1, __ATOMIC_RELEASE);
+}
+
+static void print_sample(const edge_sample_t *sample)
+{
+    uint64_t changed = sample->changed;
+    while (changed) {
+        int gpio = __builtin_ctzll(changed);
+        changed &= changed - 1;
+        printf("@ET,E,%d,%d,%" PRId64 "\n", gpio, (int)((sample->levels >> gpio) & 1), sample->t_us);
+    }
+}
+
+/* Report a task's minimum free stack whenever it reaches a new low. */
+static void report_stacks(const TaskStatus_t *tasks, UBaseType_t count)
+{
+    static struct {
+        UBaseType_t number;
+        uint32_t free_bytes;
+    } reported[EDGE_TRACE_MAX_TASKS];
+    static UBaseType_t num_reported;
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        /* ESP-IDF stacks are byte-addressed: the high-water mark is in bytes. */
+        uint32_t free_bytes = tasks[i].usStackHighWaterMark * sizeof(StackType_t);
+        UBaseType_t slot = 0;
+        while (slot < num_reported && reported[slot].number != tasks[i].xTaskNumber) {
+            slot++;
+        }
+        if (slot == num_reported) {
+            if (num_reported == EDGE_TRACE_MAX_TASKS) {
+                continue;
+            }
+            num_reported++;
+            reported[slot].number = tasks[i].xTaskNumber;
+            reported[slot].free_bytes = UINT32_MAX;
+        }
+        if (free_bytes < reported[slot].free_bytes) {
+            reported[slot].free_bytes = free_bytes;
+            printf("@ET,H,%s,%" PRIu32 "\n", tasks[i].pcTaskName, free_bytes);
+        }
+    }
+}
+
+static void report_stats(void)
+{
+    static TaskStatus_t tasks[EDGE_TRACE_MAX_TASKS];
+    static configRUN_TIME_COUNTER_TYPE last_idle[2];
+    static configRUN_TIME_COUNTER_TYPE last_total;
+
+    configRUN_TIME_COUNTER_TYPE total = 0;
+    configRUN_TIME_COUNTER_TYPE idle[2] = {0, 0};
+    UBaseType_t count = uxTaskGetSystemState(tasks, EDGE_TRACE_MAX_TASKS, &total);
+
+    for (UBaseType_t i = 0; i < count; i++) {
+        if (strncmp(tasks[i].pcTaskName, "IDLE", 4) == 0 && tasks[i].xCoreID >= 0 && tasks[i].xCoreID < 2) {
+            idle[tasks[i].xCoreID] = tasks[i].ulRunTimeCounter;
+        }
+    }
+
+    configRUN_TIME_COUNTER_TYPE elapsed = total - last_total;
+    if (last_total != 0 && elapsed > 0) {
+        printf("@ET,I,%.1f,%.1f\n",
+               100.0 * (double)(idle[0] - last_idle[0]) / (double)elapsed,
+               100.0 * (double)(idle[1] - last_idle[1]) / (double)elapsed);
+    }
+    last_total = total;
+    memcpy(last_idle, idle, sizeof(last_idle));
+
+    report_stacks(tasks, count);
+}
+
+static void drain_task(void *arg)
+{
+    TickType_t last_stats = xTaskGetTickCount();
+    uint32_t reported_overflows = 0;
+
+    while (1) {
+        while (s_tail != __atomic_load_n(&s_head, __ATOMIC_ACQUIRE)) {
+            print_sample(&s_ring[s_tail & (EDGE_TRACE_RING_SIZE - 1)]);
+            __atomic_store_n(&s_tail, s_tail + 1, __ATOMIC_RELEASE);
+        }
+
+        if (xTaskGetTickCount() - last_stats >= pdMS_TO_TICKS(EDGE_TRACE_STATS_PERIOD_MS)) {
+            last_stats = xTaskGetTickCount();
+            report_stats();
+            if (s_overflows != reported_overflows) {
+                reported_overflows = s_overflows;
+                printf("@ET,O,%" PRIu32 "\n", reported_overflows);
+            }
+        }
+
+        vTaskDelay(pdMS_TO_TICKS(10));
+    }
+}
+
+static void edge_trace_start(void)
+{
+    uint64_t outputs = EDGE_TRACE_OUTPUT_MASK;
+    while (outputs) {
+        int gpio = __builtin_ctzll(outputs);
+        outputs &= outputs - 1;
+        if (gpio < SOC_GPIO_PIN_COUNT && GPIO_PIN_MUX_REG[gpio]) {
+            s_output_mux_regs[s_num_outputs++] = GPIO_PIN_MUX_REG[gpio];
+        }
+    }
+    enable_output_readback();
+    s_last_levels = read_levels();
+    printf("@ET,S,%d,%llx,%llx\n", EDGE_TRACE_SAMPLE_US,
+           (unsigned long long)EDGE_TRACE_OUTPUT_MASK, (unsigned long long)EDGE_TRACE_INPUT_MASK);
+
+    /* Initial levels of every watched pin. */
+    edge_sample_t initial = {
+        .changed = EDGE_TRACE_OUTPUT_MASK | EDGE_TRACE_INPUT_MASK,
+        .levels = s_last_levels,
+        .t_us = esp_timer_get_time(),
+    };
+    print_sample(&initial);
+
+    xTaskCreate(drain_task, "edge_trace", 3072, NULL, 1, NULL);
+
+    const esp_timer_create_args_t args = {
+        .callback = sample_cb,
+        .dispatch_method = ESP_TIMER_ISR,
+        .name = "edge_trace",
+    };
+    esp_timer_handle_t timer;
+    ESP_ERROR_CHECK(esp_timer_create(&args, &timer));
+    ESP_ERROR_CHECK(esp_timer_start_periodic(timer, EDGE_TRACE_SAMPLE_US));
+}
+
+extern void __real_app_main(void);
+
+void __wrap_app_main(void)
+{
+    edge_trace_start();
+    __real_app_main();
+}
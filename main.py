@@ -3,11 +3,18 @@ Entry point for the embedded code generation agent.
 
 Usage:
     python main.py [task_directory] [prompt_file]
+    python main.py --batch TASK_GLOB [--batch ...] [--prompts PROMPT_GLOB] [--concurrency N]
+    python main.py --suite [--save-baseline]           # Regression benchmark over config.yaml -> suite
+    python main.py --serve                             # Warm HTTP job server (config.yaml -> server)
+    python main.py --materialize RUN_DIR [DEST]        # Check out a run's stored artifacts as files
+    python main.py ... --no-cache                      # Bypass the LLM response cache
 
 Examples:
     python main.py                                     # Fully driven by config.yaml
     python main.py tasks/dht11_sensor                  # Override task_dir from CLI
     python main.py tasks/dht11_sensor prompt.txt       # Override prompt file from CLI
+    python main.py --batch "tasks/lab*"                # Every prompt of every lab task
+    python main.py --batch "tasks/lab1*" --prompts "prompt*.txt" --concurrency 8
 
 Task directory structure:
     tasks/dht11_sensor/
@@ -16,30 +23,49 @@ Task directory structure:
     ├── advanced.txt            # Prompt option 3
     └── runs/
         └── 2026-02-12_14-30-25/
-            ├── debug.json
+            ├── debug.jsonl          # Streamed per node (long bodies in blobs/)
+            ├── debug.json           # Consolidated export (debug.export_json)
             ├── metadata.json
             └── output/
 """
 
+import argparse
+import asyncio
+import dataclasses
 import sys
-from datetime import datetime
+import time
 from pathlib import Path
 
 from dotenv import load_dotenv
 
 load_dotenv()
 
-from src.config import load_config
+from src.batch import expand_jobs, format_summary, run_batch
+from src.config import AppConfig, load_config
+from src import nodes
 from src.graph import build_graph
-from src.nodes import configure_model
-
-
-def list_prompt_files(task_dir: Path) -> list[Path]:
-    """Find all .txt files in the task directory (excluding runs/)."""
-    return sorted([
-        f for f in task_dir.glob("*.txt")
-        if f.is_file()
-    ])
+from src.nodes import (
+    configure_benchmark,
+    configure_build,
+    configure_cache,
+    configure_candidates,
+    configure_debug,
+    configure_firmware,
+    configure_incremental,
+    configure_lint,
+    configure_manager,
+    configure_model,
+    configure_prompt_cache,
+    configure_scheduler,
+    configure_skills,
+    configure_store,
+    get_model,
+    registry,
+)
+from src.objects import materialize
+from src.runs import build_inputs, create_run_dir, list_prompt_files
+from src.server import AgentServer, serve
+from src.suite import build_results, compare, format_report, load_baseline, write_results
 
 
 def select_prompt_file(task_dir: Path, prompt_arg: str = None) -> Path:
@@ -113,19 +139,321 @@ def select_prompt_file(task_dir: Path, prompt_arg: str = None) -> Path:
     sys.exit(1)
 
 
+def parse_args(argv: list[str] = None) -> argparse.Namespace:
+    """Parse command line arguments."""
+    parser = argparse.ArgumentParser(description="Embedded code generation agent")
+    parser.add_argument("task_dir", nargs="?", help="Task directory (overrides config.yaml)")
+    parser.add_argument("prompt_file", nargs="?", help="Prompt filename or 1-based index")
+    parser.add_argument(
+        "--batch",
+        action="append",
+        metavar="TASK_GLOB",
+        help="Run in batch mode over task directories matching this glob (repeatable)",
+    )
+    parser.add_argument(
+        "--prompts",
+        action="append",
+        metavar="PROMPT_GLOB",
+        help="Batch mode: prompt filename glob inside each task dir (default: all .txt)",
+    )
+    parser.add_argument(
+        "--concurrency",
+        type=int,
+        help="Batch mode: max concurrent runs (overrides config.yaml -> batch.concurrency)",
+    )
+    parser.add_argument(
+        "--suite",
+        action="store_true",
+        help="Run the regression benchmark suite (config.yaml -> suite) and compare to its baseline",
+    )
+    parser.add_argument(
+        "--save-baseline",
+        action="store_true",
+        help="Suite mode: store this run's results as the new baseline",
+    )
+    parser.add_argument(
+        "--serve",
+        action="store_true",
+        help="Run the long-lived HTTP job server (config.yaml -> server)",
+    )
+    parser.add_argument(
+        "--materialize",
+        nargs="+",
+        metavar="RUN_DIR [DEST]",
+        help="Write a run's artifacts as plain files from the object store (default DEST: its output/)",
+    )
+    parser.add_argument(
+        "--no-cache",
+        action="store_true",
+        help="Bypass the on-disk LLM response cache for this invocation",
+    )
+    return parser.parse_args(argv)
+
+
+def apply_config(config: AppConfig) -> None:
+    """Push runtime configuration into the node modules."""
+    configure_model(
+        model_name=config.model.name,
+        temperature=config.model.temperature,
+        api_base=config.model.api_base,
+        api_key_env=config.model.api_key_env,
+    )
+    configure_scheduler(config.scheduler, requests_per_min=config.model.requests_per_min)
+    configure_prompt_cache(config.prompt_cache)
+    configure_cache(enabled=config.cache.enabled, cache_dir=config.cache.dir)
+    configure_debug(config.debug)
+    configure_store(config.store)
+    configure_manager(
+        fast_path=config.manager.fast_path,
+        min_confidence=config.manager.min_confidence,
+    )
+    configure_skills(
+        retrieval=config.skills.retrieval,
+        top_k=config.skills.top_k,
+        token_budget=config.skills.token_budget,
+    )
+    configure_candidates(config.candidates)
+    configure_incremental(config.incremental)
+    configure_lint(config.lint)
+    configure_build(config.build)
+    configure_benchmark(config.benchmark)
+    configure_firmware(profile=config.firmware.profile, instrument=config.firmware.instrument)
+
+
+def run_batch_mode(config: AppConfig, args: argparse.Namespace) -> None:
+    """Run every task x prompt combination concurrently against one compiled graph."""
+    jobs = expand_jobs(args.batch, args.prompts)
+    if not jobs:
+        print(f"Error: No task/prompt combinations matched {args.batch}")
+        sys.exit(1)
+
+    results, _ = execute_batch(config, jobs, args.concurrency)
+    if not all(r.ok for r in results):
+        sys.exit(1)
+
+
+def execute_batch(config: AppConfig, jobs: list, concurrency: int = None) -> tuple:
+    """Run jobs through one compiled graph, printing progress; returns (results, wall_time_s)."""
+    concurrency = concurrency or config.batch.concurrency
+    if concurrency < 1:
+        print("Error: --concurrency must be a positive integer.")
+        sys.exit(1)
+
+    apply_config(config)
+
+    print(f"Batch: {len(jobs)} runs, concurrency={concurrency}")
+    print(f"Model: {config.model.name} (temperature={config.model.temperature})")
+    print(f"Graph.enable_diagram: {config.graph.enable_diagram}\n")
+
+    app = build_graph(
+        enable_diagram=config.graph.enable_diagram,
+        streaming=config.graph.streaming,
+        enable_build=config.build.enabled,
+        enable_benchmark=config.benchmark.enabled,
+        candidates=config.candidates.count,
+    )
+
+    def on_result(result, completed, total):
+        status = "ok" if result.ok else "FAILED"
+        print(f"[{completed}/{total}] {status} {result.job.label} -> {result.run_dir} ({result.duration_s:.1f}s)")
+        if result.error:
+            print(f"    {result.error}")
+
+    start_time = time.time()
+    results = asyncio.run(run_batch(app, jobs, concurrency=concurrency, on_result=on_result))
+    wall_time_s = time.time() - start_time
+
+    print()
+    print(format_summary(results, wall_time_s, concurrency))
+    return results, wall_time_s
+
+
+def run_server_mode(config: AppConfig) -> None:
+    """Warm up the graph, model client and skill index once, then serve jobs over HTTP."""
+    apply_config(config)
+    app = build_graph(
+        enable_diagram=config.graph.enable_diagram,
+        streaming=config.graph.streaming,
+        enable_build=config.build.enabled,
+        enable_benchmark=config.benchmark.enabled,
+        candidates=config.candidates.count,
+    )
+    try:
+        get_model()
+    except ValueError as e:
+        print(f"Error: {e}")
+        sys.exit(1)
+    print(f"Skills: {len(registry.scan_skills().splitlines())} indexed")
+    print(f"Model: {config.model.name} (requests_per_min={config.model.requests_per_min or 'unlimited'})")
+
+    limiter = nodes.SCHEDULER.bucket(nodes.MODEL_API_BASE)
+    server = AgentServer(
+        app,
+        workers=config.server.workers,
+        queue_size=config.server.queue_size,
+        history=config.server.history,
+        tasks_root=Path(config.server.tasks_root),
+        rate_tokens=limiter.available if limiter else None,
+    )
+    serve(server, config.server.host, config.server.port)
+
+
+def run_suite_mode(config: AppConfig, args: argparse.Namespace) -> None:
+    """Run the regression suite, write its results and compare them to the baseline."""
+    suite = config.suite
+    jobs = expand_jobs(list(suite.tasks), list(suite.prompts))
+    if not jobs:
+        print(f"Error: No task/prompt combinations matched suite.tasks {list(suite.tasks)}")
+        sys.exit(1)
+
+    results, _ = execute_batch(config, jobs, args.concurrency)
+    current = build_results(
+        results,
+        model=config.model.name,
+        temperature=config.model.temperature,
+        prompt_cost_per_mtok=suite.prompt_cost_per_mtok,
+        completion_cost_per_mtok=suite.completion_cost_per_mtok,
+    )
+    baseline_path = Path(suite.baseline)
+    baseline = load_baseline(baseline_path)
+    if baseline is not None:
+        current["comparison"] = compare(current, baseline, suite.tolerance_pct)
+
+    results_path = write_results(current, Path(suite.results_dir))
+    print()
+    print(format_report(current, current.get("comparison")))
+    print(f"\nResults saved to: {results_path}")
+
+    if args.save_baseline:
+        baseline_path.parent.mkdir(parents=True, exist_ok=True)
+        baseline_path.write_text(results_path.read_text(encoding="utf-8"), encoding="utf-8")
+        print(f"Baseline saved to: {baseline_path}")
+    elif current.get("comparison", {}).get("regressions"):
+        sys.exit(1)
+
+
+async def stream_run(app, inputs: dict) -> None:
+    """Drive a single run and print per-node progress."""
+    async for event in app.astream(inputs):
+        for node_name, output in event.items():
+            print(f"--- Node: {node_name} ---")
+
+            if node_name == "manager":
+                print(f"  Project: {output.get('project_name')}")
+                print(f"  Skills: {output.get('active_skills')}")
+                print(f"  Path: {output['debug_logs'][-1]['metadata'].get('path', 'llm')}")
+                skill_stats = output.get("skill_context_stats") or {}
+                print(f"  Skill tokens: {skill_stats.get('tokens_injected')} ({skill_stats.get('mode')})")
+
+            elif node_name == "coder":
+                metrics = output["debug_logs"][-1].get("metrics", {})
+                if metrics.get("streamed"):
+                    print(
+                        f"  TTFT: {metrics.get('ttft_ms')} ms, "
+                        f"{metrics.get('completion_tokens')} tokens "
+                        f"@ {metrics.get('tokens_per_s')} tok/s"
+                    )
+                if metrics.get("cached_tokens"):
+                    print(f"  Prompt cache: {metrics['cached_tokens']}/{metrics.get('prompt_tokens')} input tokens cached")
+
+            elif node_name == "assemble_artifacts" and output.get("incremental"):
+                incremental = output["incremental"]
+                print(
+                    f"  Incremental: {incremental.get('mode')} against {incremental.get('base_run')} "
+                    f"(similarity {incremental.get('similarity')}) {incremental.get('patch', '')}"
+                )
+
+            elif node_name == "lint_firmware":
+                lint = output.get("lint_result", {})
+                print(f"  Lint: {lint.get('status')} ({len(lint.get('findings', []))} findings) {lint.get('reason', '')}")
+                if output.get("repair_feedback"):
+                    print(f"  Lint repair {output.get('lint_repairs')} requested")
+
+            elif node_name == "candidate":
+                for candidate in output.get("candidates", []):
+                    build = (candidate.get("build") or {}).get("status", "-")
+                    bench = (candidate.get("benchmark") or {}).get("status", "-")
+                    lint = (candidate.get("lint") or {}).get("status", "-")
+                    outcome = candidate.get("error") or f"lint {lint}, build {build}, benchmark {bench}"
+                    print(
+                        f"  Candidate {candidate['index']} "
+                        f"(t={candidate['temperature']}, {candidate['skills']} skills): {outcome}"
+                    )
+
+            elif node_name == "select_candidate":
+                selected = next(c for c in output["candidate_summary"] if c["selected"])
+                print(f"  Selected candidate {selected['index']} (timing error {selected['timing_error_ms']} ms)")
+
+            elif node_name == "persist":
+                print(f"  {output.get('status_msg')}")
+
+            elif node_name == "build_verify":
+                build = output.get("build_result", {})
+                print(f"  Build: {build.get('status')} ({build.get('duration_ms')} ms) {build.get('reason', '')}")
+                if output.get("repair_feedback"):
+                    print(f"  Repair attempt {output.get('repair_attempts')} requested")
+
+            elif node_name == "benchmark":
+                bench = output.get("benchmark_result", {})
+                print(f"  Benchmark: {bench.get('status')} {bench.get('reason', '')}")
+                for pin, metrics in bench.get("pins", {}).items():
+                    period = metrics.get("period_ms")
+                    if period:
+                        print(
+                            f"    GPIO {pin}: period {period['mean']} ms, "
+                            f"jitter {metrics['jitter_ms']['stdev']} ms, "
+                            f"error {metrics.get('period_error_pct', '-')} %"
+                        )
+                probes = (bench.get("instrumentation") or {}).get("probes", {})
+                for name, kinds in probes.items():
+                    for kind, stats in kinds.items():
+                        if stats.get("count"):
+                            print(f"    {name} {kind}: p99 {stats['p99_us']} us, max {stats['max_us']} us ({stats['count']} samples)")
+                current = bench.get("current")
+                if current and "mean_ma" in current:
+                    print(f"    Current: mean {current['mean_ma']} mA, idle {current['idle_ma']} mA")
+
+
 def main():
     config = load_config("config.yaml")
-    cli_task_dir = sys.argv[1] if len(sys.argv) > 1 else None
-    cli_prompt_arg = sys.argv[2] if len(sys.argv) > 2 else None
-
-    task_dir_str = cli_task_dir or config.input.task_dir
+    args = parse_args()
+    if args.no_cache:
+        config = dataclasses.replace(
+            config, cache=dataclasses.replace(config.cache, enabled=False)
+        )
+
+    if args.serve:
+        run_server_mode(config)
+        return
+
+    if args.materialize:
+        if len(args.materialize) > 2:
+            print("Error: --materialize takes RUN_DIR and an optional DEST.")
+            sys.exit(1)
+        try:
+            dest = materialize(Path(args.materialize[0]), Path(args.materialize[1]) if len(args.materialize) > 1 else None)
+        except ValueError as e:
+            print(f"Error: {e}")
+            sys.exit(1)
+        print(f"Materialized: {dest}")
+        return
+
+    if args.suite:
+        run_suite_mode(config, args)
+        return
+
+    if args.batch:
+        run_batch_mode(config, args)
+        return
+
+    task_dir_str = args.task_dir or config.input.task_dir
     if not task_dir_str:
         print("Error: task directory is required.")
         print("Provide it via CLI arg or config.yaml -> input.task_dir")
         sys.exit(1)
 
     task_dir = Path(task_dir_str)
-    prompt_arg = cli_prompt_arg or config.input.prompt_file
+    prompt_arg = args.prompt_file or config.input.prompt_file
 
     # Validate task directory
     if not task_dir.exists():
@@ -133,22 +461,16 @@ def main():
         sys.exit(1)
 
     prompt_file = select_prompt_file(task_dir, prompt_arg)
-    requirements = prompt_file.read_text().strip()
     prompt_file_name = prompt_file.name
 
     task_name = task_dir.name
 
     # Create timestamped run directory
-    timestamp = datetime.now().strftime("%Y-%m-%d_%H-%M-%S")
-    run_dir = task_dir / "runs" / timestamp
-    run_dir.mkdir(parents=True, exist_ok=True)
+    run_dir = create_run_dir(task_dir)
+    inputs = build_inputs(task_dir, prompt_file, run_dir)
+    requirements = inputs["requirements"]
 
-    configure_model(
-        model_name=config.model.name,
-        temperature=config.model.temperature,
-        api_base=config.model.api_base,
-        api_key_env=config.model.api_key_env,
-    )
+    apply_config(config)
 
     print(f"Task: {task_name}")
     print(f"Prompt: {prompt_file_name}")
@@ -156,33 +478,28 @@ def main():
     print(f"Model.api_base: {config.model.api_base}")
     print(f"Model.api_key_env: {config.model.api_key_env}")
     print(f"Graph.enable_diagram: {config.graph.enable_diagram}")
+    print(f"Graph.streaming: {config.graph.streaming}")
+    print(f"Cache.enabled: {config.cache.enabled}")
+    print(f"Candidates.count: {config.candidates.count}")
+    print(f"Incremental.enabled: {config.incremental.enabled}")
+    print(f"Lint.enabled: {config.lint.enabled}")
+    print(f"Build.enabled: {config.build.enabled}")
+    print(f"Benchmark.enabled: {config.benchmark.enabled}")
     print(f"Run directory: {run_dir}")
     print(f"Requirements:\n{requirements}\n")
     print("Starting embedded code generation...\n")
 
-    app = build_graph(enable_diagram=config.graph.enable_diagram)
-
-    inputs = {
-        "requirements": requirements,
-        "task_name": task_name,
-        "prompt_file": prompt_file_name,
-        "run_dir": str(run_dir),
-        "messages": [],
-        "debug_logs": [],
-    }
-
-    for event in app.stream(inputs):
-        for node_name, output in event.items():
-            print(f"--- Node: {node_name} ---")
-
-            if node_name == "manager":
-                print(f"  Project: {output.get('project_name')}")
-                print(f"  Skills: {output.get('active_skills')}")
+    app = build_graph(
+        enable_diagram=config.graph.enable_diagram,
+        streaming=config.graph.streaming,
+        enable_build=config.build.enabled,
+        enable_benchmark=config.benchmark.enabled,
+        candidates=config.candidates.count,
+    )
 
-            elif node_name == "persist":
-                print(f"  {output.get('status_msg')}")
+    asyncio.run(stream_run(app, inputs))
 
-    print(f"\nDebug logs saved to: {run_dir}/debug.json")
+    print(f"\nDebug logs saved to: {run_dir}/debug.jsonl")
     print(f"Metadata saved to: {run_dir}/metadata.json")
 
 
@@ -0,0 +1,153 @@
+"""
+Batch runner: executes many task x prompt combinations against one compiled graph.
+
+Each job still gets its own runs/<timestamp> directory; jobs are run
+concurrently through the graph's async interface with a bounded number in
+flight.
+"""
+
+import asyncio
+import glob
+import statistics
+import time
+from dataclasses import dataclass
+from pathlib import Path
+from typing import Callable, List, Optional
+
+from src.runs import build_inputs, create_run_dir, list_prompt_files
+
+
+@dataclass(frozen=True)
+class BatchJob:
+    """One task directory + prompt file combination."""
+
+    task_dir: Path
+    prompt_file: Path
+
+    @property
+    def label(self) -> str:
+        return f"{self.task_dir.name}/{self.prompt_file.name}"
+
+
+@dataclass
+class BatchResult:
+    """Outcome of a single batch job."""
+
+    job: BatchJob
+    run_dir: Optional[Path] = None
+    ok: bool = False
+    duration_s: float = 0.0
+    error: str = ""
+    final_state: Optional[dict] = None
+
+
+def expand_jobs(task_patterns: List[str], prompt_patterns: Optional[List[str]] = None) -> List[BatchJob]:
+    """
+    Expand task directory globs and prompt file globs into a job matrix.
+
+    Args:
+        task_patterns: Glob patterns or paths for task directories (e.g. "tasks/lab*")
+        prompt_patterns: Optional filename globs matched inside each task dir
+            (e.g. "prompt*.txt"). Defaults to every prompt file in the task.
+
+    Returns:
+        Sorted, de-duplicated list of jobs
+    """
+    task_dirs: List[Path] = []
+    for pattern in task_patterns:
+        matches = sorted(glob.glob(pattern)) or [pattern]
+        for match in matches:
+            path = Path(match)
+            if path.is_dir() and path.name != "runs" and path not in task_dirs:
+                task_dirs.append(path)
+
+    jobs: List[BatchJob] = []
+    for task_dir in task_dirs:
+        if prompt_patterns:
+            prompt_files = sorted({
+                f for pattern in prompt_patterns
+                for f in task_dir.glob(pattern)
+                if f.is_file()
+            })
+        else:
+            prompt_files = list_prompt_files(task_dir)
+
+        jobs.extend(BatchJob(task_dir=task_dir, prompt_file=f) for f in prompt_files)
+
+    return jobs
+
+
+async def _run_job(app, job: BatchJob, semaphore: asyncio.Semaphore) -> BatchResult:
+    """Run a single job once a concurrency slot is available."""
+    async with semaphore:
+        result = BatchResult(job=job)
+        start_time = time.time()
+        try:
+            result.run_dir = create_run_dir(job.task_dir)
+            inputs = build_inputs(job.task_dir, job.prompt_file, result.run_dir)
+            result.final_state = await app.ainvoke(inputs)
+            result.ok = True
+        except Exception as e:  # pylint: disable=broad-except
+            result.error = f"{type(e).__name__}: {e}"
+        result.duration_s = time.time() - start_time
+        return result
+
+
+async def run_batch(
+    app,
+    jobs: List[BatchJob],
+    concurrency: int = 4,
+    on_result: Optional[Callable[[BatchResult, int, int], None]] = None,
+) -> List[BatchResult]:
+    """
+    Run all jobs through a compiled graph with at most `concurrency` in flight.
+
+    Args:
+        app: Compiled LangGraph application (shared by all jobs)
+        jobs: Jobs to run
+        concurrency: Maximum number of concurrent graph invocations
+        on_result: Optional callback(result, completed_count, total) per finished job
+
+    Returns:
+        Results in job order
+    """
+    semaphore = asyncio.Semaphore(max(1, concurrency))
+    tasks = [asyncio.create_task(_run_job(app, job, semaphore)) for job in jobs]
+
+    completed = 0
+    for finished in asyncio.as_completed(tasks):
+        result = await finished
+        completed += 1
+        if on_result:
+            on_result(result, completed, len(jobs))
+
+    return [task.result() for task in tasks]
+
+
+def format_summary(results: List[BatchResult], wall_time_s: float, concurrency: int) -> str:
+    """Format a throughput summary for a finished batch."""
+    ok = [r for r in results if r.ok]
+    failed = [r for r in results if not r.ok]
+    durations = [r.duration_s for r in results]
+    busy_time_s = sum(durations)
+
+    lines = [
+        "=== Batch summary ===",
+        f"Runs: {len(results)} ({len(ok)} ok, {len(failed)} failed), concurrency={concurrency}",
+        f"Wall time: {wall_time_s:.1f}s",
+    ]
+
+    if results and wall_time_s > 0:
+        lines.append(f"Throughput: {len(results) / wall_time_s * 60:.2f} runs/min")
+        lines.append(
+            "Per-run latency: "
+            f"mean={statistics.mean(durations):.1f}s "
+            f"p50={statistics.median(durations):.1f}s "
+            f"max={max(durations):.1f}s"
+        )
+        lines.append(f"Speedup vs serial: {busy_time_s / wall_time_s:.2f}x")
+
+    for r in failed:
+        lines.append(f"  FAILED {r.job.label}: {r.error}")
+
+    return "\n".join(lines)
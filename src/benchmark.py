@@ -0,0 +1,592 @@
+"""
+On-target timing benchmark for generated firmware.
+
+The benchmark build adds the edge_trace test component
+(firmware/test_components/edge_trace) to the warm build tree. It wraps
+app_main, samples the watched GPIOs with an ISR-dispatched esp_timer and
+prints esp_timer-stamped level changes plus per-core CPU idle over UART.
+Alternatively edges can come from a logic-analyzer capture (sigrok CSV),
+which gives sample-clock resolution instead of EDGE_TRACE_SAMPLE_US.
+
+Per-task expectations live in an optional <task_dir>/benchmark.yaml:
+
+    duration_s: 10
+    pins:
+      13: {role: output, period_ms: 1000}     # rising-to-rising period
+      21: {role: input}
+    latency:
+      - {from: 21, to: 13, edge: rising}      # input edge -> next output edge
+    pulse_ratio: {pin: 13, expected: 2.0}     # long/short high-pulse ratio (e.g. Morse)
+    analyzer_channels: {D0: 13, D1: 21}       # logic-analyzer channel -> GPIO
+    trace: true                               # false: build without edge_trace
+                                              # (current-only, e.g. idle current)
+
+Supply current is measured when benchmark.current_cmd is configured: the
+command runs for the capture length and prints one current sample in mA per
+line (a trailing CSV field is also accepted), e.g. a PPK2/INA219 logger. The
+edge_trace sampler itself keeps the CPU awake, so idle-current tasks should
+set trace: false.
+
+Firmware built with the isr_probe component (firmware.instrument) dumps
+ISR run-time / wakeup-latency histograms and per-task CPU load on the same
+UART; they are ingested under "instrumentation" in the result.
+
+Without benchmark.yaml, pins are derived from "GPIO <n>" mentions in the
+requirements (pins named alongside a button/switch are inputs).
+"""
+
+import csv
+import math
+import re
+import shlex
+import statistics
+import subprocess
+import time
+from pathlib import Path
+from typing import Dict, List, Optional
+
+import yaml
+
+from src.devices import flash_images
+from src.dlog import ElfImage, decode_lines
+from src.placement import stack_report
+
+TRACE_COMPONENT_DIR = Path(__file__).resolve().parent.parent / "firmware" / "test_components" / "edge_trace"
+
+# sdkconfig options the trace component needs (appended to sdkconfig.defaults).
+BENCHMARK_SDKCONFIG = [
+    "CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD=y",
+    "CONFIG_FREERTOS_USE_TRACE_FACILITY=y",
+    "CONFIG_FREERTOS_GENERATE_RUN_TIME_STATS=y",
+    "CONFIG_FREERTOS_VTASKLIST_INCLUDE_COREID=y",
+]
+
+# Max time between an input edge and the output edge it is paired with.
+LATENCY_WINDOW_US = 1_000_000
+
+
+# --- Spec ---
+
+
+def derive_spec(requirements: str) -> dict:
+    """Derive watched pins from "GPIO <n>" mentions in the requirements."""
+    pins: Dict[int, dict] = {}
+    for sentence in re.split(r"(?<=[.;\n])", requirements):
+        for match in re.finditer(r"GPIO\s*(\d+)", sentence, re.IGNORECASE):
+            role = "input" if re.search(r"button|switch|sensor", sentence, re.IGNORECASE) else "output"
+            pins.setdefault(int(match.group(1)), {"role": role})
+
+    spec: dict = {"pins": pins, "latency": [], "source": "requirements"}
+
+    outputs = [pin for pin, cfg in pins.items() if cfg["role"] == "output"]
+    inputs = [pin for pin, cfg in pins.items() if cfg["role"] == "input"]
+    frequencies = re.findall(r"(\d+(?:\.\d+)?)\s*Hz", requirements)
+    if len(outputs) == 1 and len(frequencies) == 1:
+        pins[outputs[0]]["period_ms"] = 1000.0 / float(frequencies[0])
+    spec["latency"] = [{"from": i, "to": o, "edge": "rising"} for i in inputs for o in outputs]
+
+    return spec
+
+
+def load_spec(task_dir: Path, requirements: str) -> dict:
+    """Load <task_dir>/benchmark.yaml, falling back to derive_spec()."""
+    spec_path = task_dir / "benchmark.yaml"
+    if not spec_path.exists():
+        return derive_spec(requirements)
+
+    raw = yaml.safe_load(spec_path.read_text()) or {}
+    pins = {int(pin): dict(cfg or {}) for pin, cfg in (raw.get("pins") or {}).items()}
+    for cfg in pins.values():
+        cfg.setdefault("role", "output")
+
+    spec = dict(raw)
+    spec["pins"] = pins
+    spec.setdefault("latency", [])
+    spec["source"] = str(spec_path)
+    return spec
+
+
+# --- Instrumented build ---
+
+
+def _mask(spec: dict, role: str) -> int:
+    mask = 0
+    for pin, cfg in spec["pins"].items():
+        if cfg["role"] == role:
+            mask |= 1 << pin
+    return mask
+
+
+def instrument_artifacts(artifacts: List[dict], spec: dict, sample_us: int = 100) -> List[dict]:
+    """
+    Return artifacts for the benchmark build: the project plus edge_trace.
+
+    The trace component and its generated pin config go under
+    components/edge_trace/, and BENCHMARK_SDKCONFIG is appended to
+    sdkconfig.defaults (created if the project has none).
+    """
+    instrumented = [dict(a) for a in artifacts]
+    if not spec.get("trace", True):
+        return instrumented
+
+    defaults = next((a for a in instrumented if a["path"] == "sdkconfig.defaults"), None)
+    if defaults is None:
+        defaults = {"path": "sdkconfig.defaults", "content": "", "role": "config"}
+        instrumented.append(defaults)
+    defaults["content"] = defaults["content"].rstrip("\n") + "\n# benchmark instrumentation\n" + "\n".join(BENCHMARK_SDKCONFIG) + "\n"
+
+    for src in sorted(TRACE_COMPONENT_DIR.iterdir()):
+        if src.is_file():
+            instrumented.append({
+                "path": f"components/edge_trace/{src.name}",
+                "content": src.read_text(encoding="utf-8"),
+                "role": "benchmark",
+            })
+
+    instrumented.append({
+        "path": "components/edge_trace/edge_trace_config.h",
+        "content": (
+            "#pragma once\n"
+            f"#define EDGE_TRACE_OUTPUT_MASK 0x{_mask(spec, 'output'):x}ULL\n"
+            f"#define EDGE_TRACE_INPUT_MASK 0x{_mask(spec, 'input'):x}ULL\n"
+            f"#define EDGE_TRACE_SAMPLE_US {int(sample_us)}\n"
+        ),
+        "role": "benchmark",
+    })
+    return instrumented
+
+
+# --- Flash and capture ---
+
+
+def capture_uart(port: str, baud: int, duration_s: float) -> List[str]:
+    """Reset the board via RTS and capture UART lines for duration_s."""
+    import serial  # pylint: disable=import-outside-toplevel
+
+    lines: List[str] = []
+    with serial.Serial(port, baud, timeout=0.2) as ser:
+        ser.dtr = False
+        ser.rts = True
+        time.sleep(0.1)
+        ser.rts = False
+
+        deadline = time.time() + duration_s
+        while time.time() < deadline:
+            raw = ser.readline()
+            if raw:
+                lines.append(raw.decode("utf-8", errors="replace").rstrip("\r\n"))
+    return lines
+
+
+# --- Parsing ---
+
+
+def _empty_trace(sample_us: Optional[int], started: bool) -> dict:
+    return {
+        "edges": {},
+        "idle": [],
+        "overflows": 0,
+        "sample_us": sample_us,
+        "started": started,
+        "stack_free": {},
+        "heap_after_boot": None,
+        "isr_probe": None,
+        "task_cpu": {},
+    }
+
+
+def parse_trace(lines: List[str]) -> dict:
+    """
+    Parse edge_trace (and heap_guard / isr_probe) UART lines.
+
+    Returns:
+        {"edges": {gpio: [(t_us, level), ...]}, "idle": [(core0, core1), ...],
+         "overflows": int, "sample_us": int | None, "started": bool,
+         "stack_free": {task: min_free_bytes}, "heap_after_boot": dict | None,
+         "isr_probe": {"cpu_mhz", "probes": {name: {kind: histogram}}} | None
+            (last complete dump; histograms are cumulative),
+         "task_cpu": {task: {"core", "samples": [pct, ...]}}}
+    """
+    trace = _empty_trace(None, False)
+    dump = None
+    for line in lines:
+        if line.startswith("@IP,"):
+            fields = line.split(",")
+            try:
+                if fields[1] == "S":
+                    dump = {"cpu_mhz": int(fields[2]), "probes": {}, "tasks": {}}
+                elif dump is None:
+                    continue
+                elif fields[1] == "L":
+                    dump["probes"].setdefault(fields[2], {})[fields[3]] = {
+                        "count": int(fields[4]),
+                        "max_cycles": int(fields[5]),
+                        "buckets": {int(b): int(n) for b, n in (f.split(":") for f in fields[6:])},
+                    }
+                elif fields[1] == "T":
+                    dump["tasks"][",".join(fields[2:-2])] = (int(fields[-2]), float(fields[-1]))
+                elif fields[1] == "E":
+                    trace["isr_probe"] = {"cpu_mhz": dump["cpu_mhz"], "probes": dump["probes"]}
+                    for task, (core, pct) in dump["tasks"].items():
+                        trace["task_cpu"].setdefault(task, {"core": core, "samples": []})["samples"].append(pct)
+                    dump = None
+            except (IndexError, ValueError):
+                continue
+            continue
+        if line.startswith("@HG,"):
+            fields = line.split(",")
+            try:
+                trace["heap_after_boot"] = {
+                    "allocations": int(fields[1]),
+                    "bytes": int(fields[2]),
+                    "backtrace": [f"0x{int(pc, 16):08x}" for pc in fields[3:]],
+                }
+            except (IndexError, ValueError):
+                pass
+            continue
+        if not line.startswith("@ET,"):
+            continue
+        fields = line.split(",")
+        try:
+            if fields[1] == "S":
+                trace = _empty_trace(int(fields[2]), True)
+            elif fields[1] == "E":
+                trace["edges"].setdefault(int(fields[2]), []).append((int(fields[4]), int(fields[3])))
+            elif fields[1] == "I":
+                trace["idle"].append((float(fields[2]), float(fields[3])))
+            elif fields[1] == "O":
+                trace["overflows"] = int(fields[2])
+            elif fields[1] == "H":
+                name, free_bytes = ",".join(fields[2:-1]), int(fields[-1])
+                trace["stack_free"][name] = min(free_bytes, trace["stack_free"].get(name, free_bytes))
+        except (IndexError, ValueError):
+            continue
+    return trace
+
+
+def parse_sigrok_csv(path: Path, channel_map: Dict[str, int]) -> Dict[int, List[tuple]]:
+    """
+    Parse a sigrok CSV export ("Time [s]"/"time" column + one column per channel).
+
+    Returns:
+        {gpio: [(t_us, level), ...]} with one entry per level change
+    """
+    edges: Dict[int, List[tuple]] = {}
+    last: Dict[str, int] = {}
+    with Path(path).open(newline="") as f:
+        rows = (row for row in f if not row.startswith(";"))
+        reader = csv.DictReader(rows)
+        time_key = next((k for k in reader.fieldnames or [] if k.lower().startswith("time")), None)
+        for index, row in enumerate(reader):
+            t_us = int(float(row[time_key]) * 1e6) if time_key else index
+            for channel, gpio in channel_map.items():
+                if channel not in row:
+                    continue
+                level = int(row[channel])
+                if last.get(channel) != level:
+                    last[channel] = level
+                    edges.setdefault(int(gpio), []).append((t_us, level))
+    return edges
+
+
+def parse_current_samples(text: str) -> List[float]:
+    """Parse current samples (mA): one number per line, or the last CSV field."""
+    samples = []
+    for line in text.splitlines():
+        field = line.strip().split(",")[-1].strip()
+        try:
+            samples.append(float(field))
+        except ValueError:
+            continue
+    return samples
+
+
+# --- Analysis ---
+
+
+def _stats(values: List[float]) -> dict:
+    return {
+        "count": len(values),
+        "mean": round(statistics.mean(values), 3),
+        "min": round(min(values), 3),
+        "max": round(max(values), 3),
+        "stdev": round(statistics.stdev(values), 3) if len(values) > 1 else 0.0,
+    }
+
+
+def _pin_metrics(edges: List[tuple], cfg: dict) -> dict:
+    """Period, jitter and duty metrics for one pin (times in ms)."""
+    # The first entry of a UART trace is the initial level, not an edge.
+    transitions = [(t, level) for i, (t, level) in enumerate(edges) if i > 0 and level != edges[i - 1][1]]
+    rising = [t for t, level in transitions if level == 1]
+    metrics: dict = {"role": cfg["role"], "edges": len(transitions)}
+
+    periods = [(b - a) / 1000.0 for a, b in zip(rising, rising[1:])]
+    if periods:
+        period = _stats(periods)
+        metrics["period_ms"] = period
+        metrics["jitter_ms"] = {"stdev": period["stdev"], "peak_to_peak": round(period["max"] - period["min"], 3)}
+        if cfg.get("period_ms"):
+            expected = float(cfg["period_ms"])
+            metrics["expected_period_ms"] = expected
+            metrics["period_error_pct"] = round((period["mean"] - expected) / expected * 100, 3)
+
+    highs = [
+        (transitions[i + 1][0] - t) / 1000.0
+        for i, (t, level) in enumerate(transitions[:-1]) if level == 1
+    ]
+    if highs:
+        metrics["high_ms"] = _stats(highs)
+        if periods:
+            metrics["duty_pct"] = round(statistics.mean(highs) / metrics["period_ms"]["mean"] * 100, 2)
+    return metrics
+
+
+def _pulse_ratio(edges: List[tuple], expected: Optional[float]) -> dict:
+    """Split high pulses into short/long clusters at the largest gap and compare."""
+    transitions = [(t, level) for i, (t, level) in enumerate(edges) if i > 0 and level != edges[i - 1][1]]
+    highs = sorted(
+        (transitions[i + 1][0] - t) / 1000.0
+        for i, (t, level) in enumerate(transitions[:-1]) if level == 1
+    )
+    if len(highs) < 2:
+        return {"status": "insufficient pulses"}
+
+    split = max(range(1, len(highs)), key=lambda i: highs[i] - highs[i - 1])
+    short, long = highs[:split], highs[split:]
+    ratio = statistics.mean(long) / statistics.mean(short)
+    result = {
+        "short_ms": _stats(short),
+        "long_ms": _stats(long),
+        "ratio": round(ratio, 3),
+    }
+    if expected:
+        result["expected"] = expected
+        result["ratio_error_pct"] = round((ratio - expected) / expected * 100, 3)
+    return result
+
+
+def _latency(edges: Dict[int, List[tuple]], pair: dict) -> dict:
+    """Input-edge to next-output-edge latency (us)."""
+    want = 0 if pair.get("edge") == "falling" else 1
+    src = [t for i, (t, level) in enumerate(edges.get(int(pair["from"]), [])) if i > 0 and level == want]
+    dst = [t for i, (t, _) in enumerate(edges.get(int(pair["to"]), [])) if i > 0]
+
+    latencies = []
+    for t in src:
+        following = next((d for d in dst if d >= t), None)
+        if following is not None and following - t <= LATENCY_WINDOW_US:
+            latencies.append(float(following - t))
+
+    result = {"from": int(pair["from"]), "to": int(pair["to"]), "edge": "falling" if want == 0 else "rising"}
+    if latencies:
+        result["latency_us"] = _stats(latencies)
+    else:
+        result["status"] = "no paired edges (stimulate the input during capture)"
+    return result
+
+
+def analyze_current(samples: List[float], duration_s: float) -> dict:
+    """Current statistics; idle_ma is the 10th percentile (the sleep floor)."""
+    if not samples:
+        return {"status": "no samples"}
+    ordered = sorted(samples)
+    mean = statistics.mean(samples)
+    return {
+        "samples": len(samples),
+        "mean_ma": round(mean, 4),
+        "min_ma": round(ordered[0], 4),
+        "max_ma": round(ordered[-1], 4),
+        "median_ma": round(statistics.median(ordered), 4),
+        "idle_ma": round(ordered[len(ordered) // 10], 4),
+        "charge_mah": round(mean * duration_s / 3600, 6),
+    }
+
+
+def _histogram_stats(hist: dict, cpu_mhz: int) -> dict:
+    """Percentiles (upper bucket bounds) and max of an isr_probe log2 cycle histogram, in us."""
+    count = hist["count"]
+    max_us = round(hist["max_cycles"] / cpu_mhz, 3)
+    stats = {"count": count, "max_us": max_us}
+    if not count:
+        return stats
+
+    ordered = sorted(hist["buckets"].items())
+    for name, q in (("p50_us", 0.5), ("p90_us", 0.9), ("p99_us", 0.99)):
+        seen = 0
+        for bucket, n in ordered:
+            seen += n
+            if seen >= q * count:
+                stats[name] = min(max_us, round(((1 << bucket) - 1) / cpu_mhz, 3))
+                break
+    stats["buckets_us"] = [[round(((1 << bucket) - 1) / cpu_mhz, 3), n] for bucket, n in ordered]
+    return stats
+
+
+def probe_metrics(trace: dict) -> dict:
+    """isr_probe latency histograms and per-task CPU load of a parsed trace, if any."""
+    probe = trace.get("isr_probe")
+    task_cpu = trace.get("task_cpu") or {}
+    if not probe and not task_cpu:
+        return {}
+
+    instrumentation: dict = {}
+    if probe:
+        instrumentation["cpu_mhz"] = probe["cpu_mhz"]
+        instrumentation["probes"] = {
+            name: {kind: _histogram_stats(hist, probe["cpu_mhz"]) for kind, hist in kinds.items()}
+            for name, kinds in probe["probes"].items()
+        }
+    if task_cpu:
+        instrumentation["task_cpu_pct"] = {
+            task: {
+                "core": entry["core"],
+                "mean": round(statistics.mean(entry["samples"]), 2),
+                "max": max(entry["samples"]),
+                "samples": len(entry["samples"]),
+            }
+            for task, entry in sorted(task_cpu.items())
+        }
+    return {"instrumentation": instrumentation}
+
+
+def analyze(trace: dict, spec: dict, placement: Optional[dict] = None) -> dict:
+    """
+    Compute period/jitter/latency/idle metrics for a parsed trace.
+
+    With the run's task placement, measured stack high-water marks are turned
+    into used/recommended stack sizes per planned task.
+    """
+    edges = trace["edges"]
+    results: dict = {
+        "resolution_us": trace.get("sample_us"),
+        "overflows": trace.get("overflows", 0),
+        "pins": {
+            str(pin): _pin_metrics(edges.get(pin, []), cfg)
+            for pin, cfg in spec["pins"].items()
+        },
+        "latency": [_latency(edges, pair) for pair in spec.get("latency", [])],
+    }
+
+    ratio_spec = spec.get("pulse_ratio")
+    if ratio_spec:
+        results["pulse_ratio"] = _pulse_ratio(edges.get(int(ratio_spec["pin"]), []), ratio_spec.get("expected"))
+
+    idle = trace.get("idle", [])
+    if idle:
+        results["cpu_idle_pct"] = {
+            "core0": round(statistics.mean(s[0] for s in idle), 2),
+            "core1": round(statistics.mean(s[1] for s in idle), 2),
+            "samples": len(idle),
+        }
+
+    if trace.get("stack_free"):
+        results["stack"] = stack_report(trace["stack_free"], placement)
+    if trace.get("heap_after_boot") is not None:
+        heap = trace["heap_after_boot"]
+        results["heap_after_boot"] = {**heap, "ok": heap["allocations"] == 0}
+    results.update(probe_metrics(trace))
+    return results
+
+
+# --- Entry point ---
+
+
+def _decode_dlog(lines: List[str], firmware_dir: Path, run_dir: Path) -> None:
+    """Write benchmark_console.log with dlog records decoded, if any were captured."""
+    elfs = sorted(Path(firmware_dir).glob("*.elf"))
+    if not elfs or not any(line.startswith("@DL,") for line in lines):
+        return
+    decoded = decode_lines((l for l in lines if not l.startswith(("@ET,", "@IP,"))), ElfImage(elfs[0]))
+    (run_dir / "benchmark_console.log").write_text("\n".join(decoded), encoding="utf-8")
+
+
+def run_benchmark(
+    firmware_dir: Path,
+    run_dir: Path,
+    spec: dict,
+    port: str,
+    chip: str = "esp32s3",
+    baud: int = 115200,
+    flash_baud: int = 921600,
+    duration_s: Optional[float] = None,
+    analyzer_cmd: str = "",
+    current_cmd: str = "",
+    placement: Optional[dict] = None,
+    flash_state: Optional[Path] = None,
+) -> dict:
+    """
+    Flash an instrumented build, capture the trace and analyze it.
+
+    Args:
+        firmware_dir: <run_dir>/firmware from build_verify
+        run_dir: Run directory (receives benchmark_trace.log / capture CSV)
+        spec: Benchmark spec (see module docstring)
+        port: Serial port of the board
+        chip: esptool chip name
+        baud: Console baud rate
+        flash_baud: Flashing baud rate
+        duration_s: Capture length (default spec duration_s or 10)
+        analyzer_cmd: Optional logic-analyzer command template run during the
+            capture, formatted with {output} and {duration_s}; its sigrok CSV
+            replaces the UART edge trace
+        current_cmd: Optional current-logger command template run during the
+            capture, formatted with {duration_s} (see module docstring)
+        placement: The run's task placement (for stack recommendations)
+        flash_state: Record of the images last flashed to this board, for
+            skipping unchanged images (see src/devices.py)
+
+    Returns:
+        Benchmark result dict for metadata.json
+    """
+    duration_s = float(duration_s or spec.get("duration_s", 10))
+    start_time = time.time()
+
+    flash = flash_images(port, firmware_dir, chip=chip, baud=flash_baud, state_path=flash_state)
+
+    analyzer = None
+    capture_path = run_dir / "benchmark_capture.csv"
+    if analyzer_cmd:
+        cmd = analyzer_cmd.format(output=capture_path, duration_s=math.ceil(duration_s))
+        analyzer = subprocess.Popen(shlex.split(cmd), stdout=subprocess.DEVNULL, stderr=subprocess.PIPE)
+
+    current = None
+    if current_cmd:
+        cmd = current_cmd.format(duration_s=math.ceil(duration_s))
+        current = subprocess.Popen(shlex.split(cmd), stdout=subprocess.PIPE, stderr=subprocess.PIPE)
+
+    lines = capture_uart(port, baud, duration_s)
+    (run_dir / "benchmark_trace.log").write_text("\n".join(lines), encoding="utf-8")
+    _decode_dlog(lines, firmware_dir, run_dir)
+    trace = parse_trace(lines)
+
+    if analyzer:
+        _, stderr = analyzer.communicate(timeout=duration_s + 30)
+        if analyzer.returncode != 0:
+            raise RuntimeError(f"Logic analyzer capture failed: {stderr.decode(errors='replace').strip()}")
+        trace["edges"] = parse_sigrok_csv(capture_path, spec.get("analyzer_channels", {}))
+        trace["sample_us"] = None
+
+    traced = spec.get("trace", True)
+    if traced and not trace["started"] and not analyzer:
+        raise RuntimeError("No edge_trace start marker on UART (is the instrumented image running?)")
+
+    extra = {}
+    if current:
+        stdout, stderr = current.communicate(timeout=duration_s + 30)
+        if current.returncode != 0:
+            raise RuntimeError(f"Current measurement failed: {stderr.decode(errors='replace').strip()}")
+        (run_dir / "benchmark_current.log").write_bytes(stdout)
+        extra["current"] = analyze_current(parse_current_samples(stdout.decode(errors="replace")), duration_s)
+
+    return {
+        "status": "ok",
+        "port": port,
+        "flash": flash,
+        "duration_s": duration_s,
+        "spec_source": spec.get("source"),
+        "edge_source": "logic_analyzer" if analyzer else "uart_trace",
+        "elapsed_ms": round((time.time() - start_time) * 1000, 2),
+        **(analyze(trace, spec, placement) if traced or analyzer else probe_metrics(trace)),
+        **extra,
+    }
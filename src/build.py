@@ -0,0 +1,252 @@
+"""
+Compile-in-the-loop ESP-IDF build verification against warm, shared build trees.
+
+Generated projects are synced into a long-lived project tree keyed by the
+hash of the target + sdkconfig defaults, so ESP-IDF components stay compiled
+between runs and only main/ (and anything else that actually changed) is
+rebuilt. ccache is enabled on top for reuse across trees.
+
+Layout:
+    <cache_dir>/<sdkconfig_hash>/slot-<n>/        # project tree (+ build/)
+    <cache_dir>/<sdkconfig_hash>/slot-<n>.lock
+
+Each artifact is only rewritten when its content changes, which preserves
+mtimes and keeps the incremental build incremental. The root project name is
+normalized so the CMake cache and output file names stay stable across runs.
+"""
+
+import hashlib
+import json
+import os
+import re
+import shutil
+import subprocess
+import time
+from dataclasses import asdict, dataclass, field
+from pathlib import Path
+from typing import List, Optional
+
+from src.locks import lease_any
+
+# Fixed project name used inside the warm trees (see module docstring).
+TREE_PROJECT_NAME = "embed_agent_app"
+
+# Files produced by the build that are kept with the run for flashing/decoding.
+FIRMWARE_FILES = (
+    f"{TREE_PROJECT_NAME}.bin",
+    f"{TREE_PROJECT_NAME}.elf",
+    "bootloader/bootloader.bin",
+    "partition_table/partition-table.bin",
+    "flash_args",
+)
+
+MAX_DIAGNOSTIC_LINES = 60
+
+_DIAGNOSTIC_RE = re.compile(r"(fatal error|error|undefined reference to|multiple definition of)", re.IGNORECASE)
+
+
+@dataclass
+class BuildResult:
+    """Outcome of a build verification."""
+
+    status: str = "skipped"  # ok | failed | skipped
+    reason: str = ""
+    duration_ms: float = 0.0
+    diagnostics: str = ""
+    sdkconfig_hash: str = ""
+    tree: str = ""
+    log_path: str = ""
+    firmware_dir: str = ""
+    app_size: Optional[int] = None
+    extra: dict = field(default_factory=dict)
+
+    def to_dict(self) -> dict:
+        return asdict(self)
+
+
+def find_idf_py() -> Optional[str]:
+    """Return the idf.py executable if an ESP-IDF environment is active."""
+    found = shutil.which("idf.py")
+    if found:
+        return found
+
+    idf_path = os.environ.get("IDF_PATH")
+    if idf_path:
+        candidate = Path(idf_path) / "tools" / "idf.py"
+        if candidate.exists():
+            return str(candidate)
+    return None
+
+
+def sdkconfig_hash(target: str, artifacts: List[dict]) -> str:
+    """Hash the configuration inputs that invalidate prebuilt components."""
+    digest = hashlib.sha256()
+    digest.update(target.encode("utf-8"))
+    digest.update(os.environ.get("IDF_PATH", "").encode("utf-8"))
+    for artifact in sorted(artifacts, key=lambda a: a.get("path", "")):
+        if Path(artifact.get("path", "")).name.startswith("sdkconfig"):
+            digest.update(artifact["path"].encode("utf-8"))
+            digest.update(artifact.get("content", "").encode("utf-8"))
+    return digest.hexdigest()[:16]
+
+
+def _normalize_root_cmake(content: str) -> str:
+    return re.sub(r"project\s*\([^)]*\)", f"project({TREE_PROJECT_NAME})", content)
+
+
+def sync_tree(tree: Path, artifacts: List[dict]) -> List[str]:
+    """
+    Mirror artifacts into a warm project tree, touching only changed files.
+
+    Files synced by a previous run but absent now are removed. The build/
+    directory and the generated sdkconfig are never touched.
+
+    Returns:
+        Relative paths that were (re)written
+    """
+    tree.mkdir(parents=True, exist_ok=True)
+    manifest_path = tree / ".synced.json"
+    try:
+        previous = set(json.loads(manifest_path.read_text(encoding="utf-8")))
+    except (OSError, ValueError):
+        previous = set()
+
+    written: List[str] = []
+    current = set()
+    for artifact in artifacts:
+        rel_path = artifact["path"]
+        content = artifact.get("content", "")
+        if rel_path == "CMakeLists.txt":
+            content = _normalize_root_cmake(content)
+
+        path = tree / rel_path
+        current.add(rel_path)
+        try:
+            if path.read_text(encoding="utf-8") == content:
+                continue
+        except OSError:
+            pass
+
+        path.parent.mkdir(parents=True, exist_ok=True)
+        path.write_text(content, encoding="utf-8")
+        written.append(rel_path)
+
+    for stale in previous - current:
+        (tree / stale).unlink(missing_ok=True)
+
+    manifest_path.write_text(json.dumps(sorted(current)), encoding="utf-8")
+    return written
+
+
+def extract_diagnostics(log_text: str, tree: Path) -> str:
+    """
+    Extract compiler/linker errors (with the following source/caret lines).
+
+    Tree paths are rewritten to project-relative paths (e.g. main/main.c:12:5).
+    """
+    lines = log_text.replace(f"{tree}{os.sep}", "").splitlines()
+    picked: List[str] = []
+    for i, line in enumerate(lines):
+        if _DIAGNOSTIC_RE.search(line) and "warning:" not in line:
+            picked.extend(lines[i:i + 3])
+        if len(picked) >= MAX_DIAGNOSTIC_LINES:
+            break
+
+    if not picked:
+        picked = lines[-MAX_DIAGNOSTIC_LINES:]
+
+    return "\n".join(picked[:MAX_DIAGNOSTIC_LINES])
+
+
+def _collect_firmware(build_dir: Path, run_dir: Path) -> tuple[Path, Optional[int]]:
+    """Copy flashable images, flash_args and the ELF into <run_dir>/firmware."""
+    firmware_dir = run_dir / "firmware"
+    for rel_path in FIRMWARE_FILES:
+        src = build_dir / rel_path
+        if src.exists():
+            dst = firmware_dir / rel_path
+            dst.parent.mkdir(parents=True, exist_ok=True)
+            dst.unlink(missing_ok=True)  # may be a read-only object store link
+            shutil.copy2(src, dst)
+
+    app_bin = build_dir / f"{TREE_PROJECT_NAME}.bin"
+    app_size = app_bin.stat().st_size if app_bin.exists() else None
+    return firmware_dir, app_size
+
+
+def run_build(
+    artifacts: List[dict],
+    run_dir: Path,
+    target: str = "esp32s3",
+    cache_dir: str = ".cache/idf-build",
+    slots: int = 1,
+    timeout_s: int = 600,
+) -> BuildResult:
+    """
+    Build artifacts in a warm tree and collect diagnostics or firmware.
+
+    Args:
+        artifacts: Assembled artifacts (path/content), as persisted to output/
+        run_dir: Run directory receiving build.log and firmware/
+        target: IDF_TARGET
+        cache_dir: Root of the warm build trees
+        slots: Number of warm trees per sdkconfig hash (parallel builds)
+        timeout_s: Build timeout
+
+    Returns:
+        BuildResult
+    """
+    idf_py = find_idf_py()
+    if not idf_py:
+        return BuildResult(status="skipped", reason="idf.py not found (ESP-IDF environment not exported)")
+
+    key = sdkconfig_hash(target, artifacts)
+    root = Path(cache_dir) / key
+    lock_paths = [root / f"slot-{i}.lock" for i in range(max(1, slots))]
+    log_path = run_dir / "build.log"
+
+    start_time = time.time()
+    with lease_any(lock_paths, fallback_index=hash(str(run_dir))) as slot:
+        tree = root / f"slot-{slot}"
+        changed = sync_tree(tree, artifacts)
+
+        env = dict(os.environ, IDF_TARGET=target, IDF_CCACHE_ENABLE="1")
+        cmd = [idf_py, "-C", str(tree), "-B", str(tree / "build"), "--ccache", "build"]
+        try:
+            proc = subprocess.run(
+                cmd,
+                env=env,
+                capture_output=True,
+                text=True,
+                timeout=timeout_s,
+                check=False,
+            )
+            log_text = proc.stdout + proc.stderr
+            returncode = proc.returncode
+        except subprocess.TimeoutExpired as e:
+            output = b"".join(
+                part if isinstance(part, bytes) else (part or "").encode("utf-8")
+                for part in (e.stdout, e.stderr)
+            )
+            log_text = f"{output.decode('utf-8', errors='replace')}\nBuild timed out after {timeout_s}s"
+            returncode = -1
+
+        log_path.write_text(log_text, encoding="utf-8")
+
+        result = BuildResult(
+            sdkconfig_hash=key,
+            tree=str(tree),
+            log_path=str(log_path),
+            extra={"slot": slot, "changed_files": changed},
+        )
+        if returncode == 0:
+            firmware_dir, app_size = _collect_firmware(tree / "build", run_dir)
+            result.status = "ok"
+            result.firmware_dir = str(firmware_dir)
+            result.app_size = app_size
+        else:
+            result.status = "failed"
+            result.diagnostics = extract_diagnostics(log_text, tree)
+
+    result.duration_ms = round((time.time() - start_time) * 1000, 2)
+    return result
@@ -0,0 +1,113 @@
+"""
+Content-addressed on-disk cache for deterministic LLM responses.
+
+Entries are keyed by the SHA-256 of the model name, temperature and the full
+rendered prompt messages (system prompt including skill content, plus the user
+requirements), mirroring the per-artifact sha256 in manifest.lock.json.
+
+Layout:
+    <cache_dir>/<sha[:2]>/<sha>.json
+"""
+
+import hashlib
+import json
+import os
+import tempfile
+import threading
+from datetime import datetime
+from pathlib import Path
+from typing import Any, Optional
+
+
+def _render_messages(messages: Any) -> list:
+    """Normalize tuple or BaseMessage prompt messages to [role, content] pairs."""
+    rendered = []
+    for message in messages:
+        if isinstance(message, tuple):
+            role, content = message
+        else:
+            role, content = message.type, message.content
+        if isinstance(content, list):
+            # Content blocks (e.g. with prompt-cache hints): key on the text only
+            content = "\n".join(b.get("text", "") if isinstance(b, dict) else str(b) for b in content)
+        rendered.append([role, content])
+    return rendered
+
+
+class ResponseCache:
+    """On-disk response cache. Only temperature-0 calls are cacheable."""
+
+    def __init__(self, cache_dir: str = ".cache/llm", enabled: bool = True):
+        self.cache_dir = Path(cache_dir)
+        self.enabled = enabled
+        self.hits = 0
+        self.misses = 0
+        self._lock = threading.Lock()
+
+    def make_key(self, model: str, temperature: float, messages: Any) -> Optional[str]:
+        """
+        Compute the cache key for a call, or None if the call is not cacheable.
+
+        Args:
+            model: Model name
+            temperature: Sampling temperature (non-zero disables caching)
+            messages: Rendered prompt messages
+
+        Returns:
+            Hex SHA-256 key or None
+        """
+        if not self.enabled or temperature != 0:
+            return None
+
+        payload = json.dumps(
+            {
+                "model": model,
+                "temperature": float(temperature),
+                "messages": _render_messages(messages),
+            },
+            sort_keys=True,
+            ensure_ascii=False,
+        ).encode("utf-8")
+        return hashlib.sha256(payload).hexdigest()
+
+    def _path(self, key: str) -> Path:
+        return self.cache_dir / key[:2] / f"{key}.json"
+
+    def get(self, key: str) -> Optional[dict]:
+        """Return the cached record for key, or None on miss."""
+        path = self._path(key)
+        try:
+            record = json.loads(path.read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            record = None
+
+        with self._lock:
+            if record is None:
+                self.misses += 1
+            else:
+                self.hits += 1
+        return record
+
+    def put(self, key: str, content: str, usage: dict = None) -> None:
+        """Store a response. Writes are atomic so concurrent runs never read partial files."""
+        path = self._path(key)
+        path.parent.mkdir(parents=True, exist_ok=True)
+
+        record = {
+            "content": content,
+            "usage": usage or {},
+            "created": datetime.now().isoformat(),
+        }
+        fd, tmp_name = tempfile.mkstemp(dir=path.parent, suffix=".tmp")
+        try:
+            with os.fdopen(fd, "w", encoding="utf-8") as tmp_file:
+                json.dump(record, tmp_file)
+            os.replace(tmp_name, path)
+        except BaseException:
+            Path(tmp_name).unlink(missing_ok=True)
+            raise
+
+    def evict(self, key: Optional[str]) -> None:
+        """Drop an entry (e.g. a response that later failed to parse)."""
+        if key:
+            self._path(key).unlink(missing_ok=True)
@@ -0,0 +1,95 @@
+"""
+Multi-candidate generation: prompt variants and winner selection.
+
+With candidates.count > 1 the graph fans out one candidate node per variant
+(LangGraph Send); each candidate is generated, linted, built and benchmarked
+on its own (under <run_dir>/candidates/<index>/) and select_candidate keeps
+the best one by rank_key():
+
+    1. build ok (then skipped, then failed)
+    2. fewest lint errors
+    3. benchmark ok
+    4. lowest timing error in ms: period jitter (stdev) + |period error| of
+       every pin, + mean input-to-output latency of every latency pair
+    5. smallest app image, then fewest code lines
+"""
+
+import math
+from typing import List
+
+BUILD_RANK = {"ok": 0, "skipped": 1}
+
+
+def candidate_variants(count: int, temperatures: List[float], vary_skills: bool = True) -> List[dict]:
+    """
+    Variants for count candidates: temperatures are cycled; with vary_skills
+    every second candidate gets the full skill documents instead of the
+    retrieved sections.
+    """
+    return [
+        {
+            "index": i,
+            "temperature": float(temperatures[i % len(temperatures)]),
+            "skills": "full" if vary_skills and i % 2 == 1 else "retrieved",
+        }
+        for i in range(count)
+    ]
+
+
+def timing_error_ms(benchmark: dict) -> float:
+    """Summed jitter/period error/latency of a benchmark result (inf if nothing was measured)."""
+    total = 0.0
+    measured = False
+    for metrics in (benchmark.get("pins") or {}).values():
+        if "jitter_ms" in metrics:
+            total += metrics["jitter_ms"]["stdev"]
+            measured = True
+        if "period_error_pct" in metrics:
+            total += abs(metrics["period_error_pct"]) / 100 * metrics["expected_period_ms"]
+    for pair in benchmark.get("latency") or []:
+        if "latency_us" in pair:
+            total += pair["latency_us"]["mean"] / 1000
+            measured = True
+    return total if measured else math.inf
+
+
+def rank_key(candidate: dict) -> tuple:
+    """Sort key of a candidate record (lower is better, see module docstring)."""
+    build = candidate.get("build") or {}
+    benchmark = candidate.get("benchmark") or {}
+    lint_errors = sum(1 for f in (candidate.get("lint") or {}).get("findings", []) if f["severity"] == "error")
+    benchmark_ok = benchmark.get("status") == "ok"
+    return (
+        BUILD_RANK.get(build.get("status"), 2),
+        lint_errors,
+        0 if benchmark_ok else 1,
+        timing_error_ms(benchmark) if benchmark_ok else math.inf,
+        build.get("app_size") or math.inf,
+        candidate.get("lines", 0),
+    )
+
+
+def summarize(candidate: dict) -> dict:
+    """Per-candidate entry for metadata.json (no code/artifact contents)."""
+    build = candidate.get("build") or {}
+    benchmark = candidate.get("benchmark") or {}
+    lint = candidate.get("lint") or {}
+    timing = timing_error_ms(benchmark) if benchmark.get("status") == "ok" else math.inf
+    return {
+        "index": candidate["index"],
+        "temperature": candidate["temperature"],
+        "skills": candidate["skills"],
+        "lines": candidate.get("lines"),
+        "code_sha256": candidate.get("code_sha256"),
+        "lint": {"status": lint.get("status"), "findings": len(lint.get("findings", []))},
+        "build": {k: build.get(k) for k in ("status", "reason", "app_size", "duration_ms", "firmware_dir")},
+        "benchmark": benchmark,
+        "timing_error_ms": None if math.isinf(timing) else round(timing, 4),
+        "dir": candidate.get("dir"),
+        "error": candidate.get("error"),
+    }
+
+
+def select(candidates: List[dict]) -> List[dict]:
+    """Candidates ordered best first."""
+    return sorted(candidates, key=lambda c: (rank_key(c), c["index"]))
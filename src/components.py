@@ -0,0 +1,85 @@
+"""
+Bundled ESP-IDF components emitted next to main/ in generated projects.
+
+Each directory under firmware/components/ is a regular ESP-IDF component
+with its public headers in include/. A component is emitted when the
+generated code includes one of its headers; components that include
+another bundled component's header pull it in as well.
+
+A component may ship an sdkconfig.defaults with the options it needs; it is
+not emitted itself but merged into the project's sdkconfig.defaults.
+"""
+
+import re
+from pathlib import Path
+from typing import Dict, List
+
+COMPONENTS_DIR = Path(__file__).resolve().parent.parent / "firmware" / "components"
+
+COMPONENT_SDKCONFIG = "sdkconfig.defaults"
+
+_INCLUDE_RE = re.compile(r'^\s*#\s*include\s*[<"]([^>"]+)[>"]', re.MULTILINE)
+
+
+def _component_files(component_dir: Path) -> List[Path]:
+    return sorted(p for p in component_dir.rglob("*") if p.is_file())
+
+
+def header_index(components_dir: Path = COMPONENTS_DIR) -> Dict[str, str]:
+    """Map public header names (e.g. "gpio_event_ring.h") to component names."""
+    index: Dict[str, str] = {}
+    if not components_dir.is_dir():
+        return index
+    for component_dir in sorted(p for p in components_dir.iterdir() if p.is_dir()):
+        include_dir = component_dir / "include"
+        if include_dir.is_dir():
+            for header in include_dir.rglob("*.h"):
+                index[header.relative_to(include_dir).as_posix()] = component_dir.name
+    return index
+
+
+def required_components(code: str, components_dir: Path = COMPONENTS_DIR) -> List[str]:
+    """Resolve the bundled components (transitively) included by code."""
+    index = header_index(components_dir)
+    required: List[str] = []
+    pending = [code]
+    while pending:
+        for include in _INCLUDE_RE.findall(pending.pop()):
+            name = index.get(include)
+            if name and name not in required:
+                required.append(name)
+                pending.extend(
+                    p.read_text(encoding="utf-8")
+                    for p in _component_files(components_dir / name)
+                    if p.suffix in (".c", ".h")
+                )
+    return sorted(required)
+
+
+def component_artifacts(code: str, components_dir: Path = COMPONENTS_DIR) -> List[dict]:
+    """Artifacts (components/<name>/...) for every bundled component code needs."""
+    artifacts: List[dict] = []
+    for name in required_components(code, components_dir):
+        component_dir = components_dir / name
+        for path in _component_files(component_dir):
+            if path.name == COMPONENT_SDKCONFIG:
+                continue
+            artifacts.append({
+                "path": f"components/{name}/{path.relative_to(component_dir).as_posix()}",
+                "content": path.read_text(encoding="utf-8"),
+                "role": "component",
+            })
+    return artifacts
+
+
+def component_sdkconfig(code: str, components_dir: Path = COMPONENTS_DIR) -> List[str]:
+    """sdkconfig options requested by the bundled components code needs."""
+    options: List[str] = []
+    for name in required_components(code, components_dir):
+        path = components_dir / name / COMPONENT_SDKCONFIG
+        if path.is_file():
+            for line in path.read_text(encoding="utf-8").splitlines():
+                line = line.strip()
+                if line and not line.startswith("#") and line not in options:
+                    options.append(line)
+    return options
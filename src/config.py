@@ -5,10 +5,13 @@ Configuration loading for embed-agent.
 from dataclasses import dataclass, field
 import os
 from pathlib import Path
-from typing import Optional
+from typing import Optional, Tuple
 
 import yaml
 
+from src.objects import STORE_MODES
+from src.profiles import PROFILES
+
 
 @dataclass(frozen=True)
 class InputConfig:
@@ -26,6 +29,35 @@ class ModelConfig:
     temperature: float = 0.0
     api_base: str = ""
     api_key_env: str = "OPENAI_API_KEY"
+    # Uncached LLM calls per minute toward api_base (0 = unlimited)
+    requests_per_min: int = 0
+
+
+@dataclass(frozen=True)
+class SchedulerConfig:
+    """LLM request policy: retries, hedging, fallback model (see src/scheduler.py)."""
+
+    max_retries: int = 3
+    backoff_base_s: float = 1.0
+    backoff_max_s: float = 30.0
+    # Per-request client timeout
+    timeout_s: float = 120.0
+    # Concurrent requests per endpoint (0 = unlimited)
+    max_in_flight: int = 0
+    # Duplicate requests slower than the model's observed p95 latency
+    hedge: bool = False
+    hedge_min_samples: int = 20
+    # Faster model tried once the primary's retries are exhausted ("" = none)
+    fallback_model: str = ""
+    fallback_api_base: str = ""
+
+
+@dataclass(frozen=True)
+class PromptCacheConfig:
+    """Provider prompt-cache hints for the coder system prompt."""
+
+    # auto: cache_control breakpoints for Claude models; always; never
+    hints: str = "auto"
 
 
 @dataclass(frozen=True)
@@ -33,6 +65,156 @@ class GraphConfig:
     """Graph-related runtime configuration."""
 
     enable_diagram: bool = False
+    streaming: bool = False
+
+
+@dataclass(frozen=True)
+class ManagerConfig:
+    """Manager (planning) node configuration."""
+
+    fast_path: bool = True
+    min_confidence: float = 0.75
+
+
+@dataclass(frozen=True)
+class SkillsConfig:
+    """Skill context injection configuration."""
+
+    retrieval: bool = True
+    top_k: int = 8
+    token_budget: int = 2000
+
+
+@dataclass(frozen=True)
+class BuildConfig:
+    """Compile-in-the-loop build verification configuration."""
+
+    enabled: bool = False
+    idf_target: str = "esp32s3"
+    cache_dir: str = ".cache/idf-build"
+    slots: int = 1
+    max_repairs: int = 2
+    timeout_s: int = 600
+
+
+@dataclass(frozen=True)
+class CandidatesConfig:
+    """Multi-candidate generation (count > 1 enables it, see src/candidates.py)."""
+
+    count: int = 1
+    temperatures: Tuple[float, ...] = (0.0, 0.4, 0.8)
+    vary_skills: bool = True
+
+
+@dataclass(frozen=True)
+class IncrementalConfig:
+    """Diff-based regeneration against the task's last successful run (see src/patch.py)."""
+
+    enabled: bool = False
+    # Requirements similarity (difflib ratio) below which the code is rewritten in full
+    min_similarity: float = 0.6
+
+
+@dataclass(frozen=True)
+class LintConfig:
+    """Interrupt-context lint of generated ESP-IDF code (see src/lint.py)."""
+
+    enabled: bool = True
+    max_repairs: int = 1
+
+
+@dataclass(frozen=True)
+class BenchmarkConfig:
+    """On-target timing benchmark configuration (requires build.enabled)."""
+
+    enabled: bool = False
+    port: str = ""
+    # Device pool: serial ports or glob patterns (default: just port)
+    ports: Tuple[str, ...] = ()
+    lock_dir: str = ".cache/devices"
+    max_failures: int = 3
+    baud: int = 115200
+    flash_baud: int = 921600
+    duration_s: int = 10
+    sample_us: int = 100
+    # Optional logic-analyzer command template ({output}, {duration_s})
+    analyzer_cmd: str = ""
+    # Optional current-logger command template ({duration_s}), mA per line
+    current_cmd: str = ""
+
+
+@dataclass(frozen=True)
+class FirmwareConfig:
+    """Generated firmware configuration (emitted sdkconfig.defaults)."""
+
+    # "auto" (pick from requirements), "none", or a name from src/profiles.py
+    profile: str = "auto"
+    # Have the coder weave the isr_probe component into ISRs and consumer tasks
+    instrument: bool = False
+
+
+@dataclass(frozen=True)
+class CacheConfig:
+    """LLM response cache configuration (temperature-0 calls only)."""
+
+    enabled: bool = True
+    dir: str = ".cache/llm"
+
+
+@dataclass(frozen=True)
+class BatchConfig:
+    """Batch (task x prompt matrix) runtime configuration."""
+
+    concurrency: int = 4
+
+
+@dataclass(frozen=True)
+class ServerConfig:
+    """Long-running agent server (python main.py --serve, see src/server.py)."""
+
+    host: str = "127.0.0.1"
+    port: int = 8765
+    # Concurrent graph runs
+    workers: int = 2
+    # Queued jobs beyond which new submissions are rejected (HTTP 503)
+    queue_size: int = 16
+    # Finished jobs kept for GET /jobs/<id>
+    history: int = 256
+    # Directory every submitted task_dir must be inside
+    tasks_root: str = "tasks"
+
+
+@dataclass(frozen=True)
+class SuiteConfig:
+    """Regression benchmark suite (python main.py --suite, see src/suite.py)."""
+
+    tasks: Tuple[str, ...] = ("tasks/*",)
+    prompts: Tuple[str, ...] = ("prompt.txt",)
+    results_dir: str = "suite/results"
+    baseline: str = "suite/baseline.json"
+    # Relative change beyond which a worse metric is reported as a regression
+    tolerance_pct: float = 10.0
+    # USD (or any unit) per million tokens, for the cost columns
+    prompt_cost_per_mtok: float = 0.0
+    completion_cost_per_mtok: float = 0.0
+
+
+@dataclass(frozen=True)
+class DebugConfig:
+    """Per-run debug log (see src/debuglog.py)."""
+
+    # Also write the consolidated debug.json (full contents) after persist/build/benchmark
+    export_json: bool = True
+    # Input/output strings of at least this many chars are stored once under blobs/
+    blob_min_chars: int = 512
+
+
+@dataclass(frozen=True)
+class StoreConfig:
+    """Content-addressed artifact store under tasks/.objects (see src/objects.py)."""
+
+    # off: plain files in output/; link: hardlinks to the store; ref: manifest references only
+    mode: str = "off"
 
 
 @dataclass(frozen=True)
@@ -41,7 +223,23 @@ class AppConfig:
 
     input: InputConfig = field(default_factory=InputConfig)
     model: ModelConfig = field(default_factory=ModelConfig)
+    scheduler: SchedulerConfig = field(default_factory=SchedulerConfig)
+    prompt_cache: PromptCacheConfig = field(default_factory=PromptCacheConfig)
     graph: GraphConfig = field(default_factory=GraphConfig)
+    batch: BatchConfig = field(default_factory=BatchConfig)
+    server: ServerConfig = field(default_factory=ServerConfig)
+    suite: SuiteConfig = field(default_factory=SuiteConfig)
+    cache: CacheConfig = field(default_factory=CacheConfig)
+    debug: DebugConfig = field(default_factory=DebugConfig)
+    store: StoreConfig = field(default_factory=StoreConfig)
+    manager: ManagerConfig = field(default_factory=ManagerConfig)
+    skills: SkillsConfig = field(default_factory=SkillsConfig)
+    candidates: CandidatesConfig = field(default_factory=CandidatesConfig)
+    incremental: IncrementalConfig = field(default_factory=IncrementalConfig)
+    lint: LintConfig = field(default_factory=LintConfig)
+    build: BuildConfig = field(default_factory=BuildConfig)
+    firmware: FirmwareConfig = field(default_factory=FirmwareConfig)
+    benchmark: BenchmarkConfig = field(default_factory=BenchmarkConfig)
 
 
 def load_config(config_path: str | Path = "config.yaml") -> AppConfig:
@@ -101,6 +299,46 @@ def load_config(config_path: str | Path = "config.yaml") -> AppConfig:
     if not isinstance(api_key_env, str) or not api_key_env.strip():
         raise ValueError("Invalid config value: 'model.api_key_env' must be non-empty string.")
 
+    requests_per_min = model_cfg.get("requests_per_min", 0)
+    if not isinstance(requests_per_min, int) or isinstance(requests_per_min, bool) or requests_per_min < 0:
+        raise ValueError("Invalid config value: 'model.requests_per_min' must be an integer >= 0.")
+
+    prompt_cache_cfg = raw.get("prompt_cache", {})
+    if prompt_cache_cfg is None:
+        prompt_cache_cfg = {}
+    if not isinstance(prompt_cache_cfg, dict):
+        raise ValueError("Invalid config format: 'prompt_cache' must be a mapping.")
+
+    cache_hints = prompt_cache_cfg.get("hints", "auto")
+    if cache_hints not in ("auto", "always", "never"):
+        raise ValueError("Invalid config value: 'prompt_cache.hints' must be one of auto, always, never.")
+
+    scheduler_cfg = raw.get("scheduler", {})
+    if scheduler_cfg is None:
+        scheduler_cfg = {}
+    if not isinstance(scheduler_cfg, dict):
+        raise ValueError("Invalid config format: 'scheduler' must be a mapping.")
+
+    scheduler_values = {}
+    for key, default in (("max_retries", 3), ("max_in_flight", 0), ("hedge_min_samples", 20)):
+        value = scheduler_cfg.get(key, default)
+        if not isinstance(value, int) or isinstance(value, bool) or value < 0:
+            raise ValueError(f"Invalid config value: 'scheduler.{key}' must be an integer >= 0.")
+        scheduler_values[key] = value
+    for key, default in (("backoff_base_s", 1.0), ("backoff_max_s", 30.0), ("timeout_s", 120.0)):
+        value = scheduler_cfg.get(key, default)
+        if not isinstance(value, (int, float)) or isinstance(value, bool) or value <= 0:
+            raise ValueError(f"Invalid config value: 'scheduler.{key}' must be a positive number.")
+        scheduler_values[key] = float(value)
+    hedge = scheduler_cfg.get("hedge", False)
+    if not isinstance(hedge, bool):
+        raise ValueError("Invalid config value: 'scheduler.hedge' must be boolean.")
+    for key in ("fallback_model", "fallback_api_base"):
+        value = scheduler_cfg.get(key, "") or ""
+        if not isinstance(value, str):
+            raise ValueError(f"Invalid config value: 'scheduler.{key}' must be a string.")
+        scheduler_values[key] = value.strip()
+
     graph_cfg = raw.get("graph", {})
     if graph_cfg is None:
         graph_cfg = {}
@@ -111,6 +349,272 @@ def load_config(config_path: str | Path = "config.yaml") -> AppConfig:
     if not isinstance(enable_diagram, bool):
         raise ValueError("Invalid config value: 'graph.enable_diagram' must be boolean.")
 
+    streaming = graph_cfg.get("streaming", False)
+    if not isinstance(streaming, bool):
+        raise ValueError("Invalid config value: 'graph.streaming' must be boolean.")
+
+    batch_cfg = raw.get("batch", {})
+    if batch_cfg is None:
+        batch_cfg = {}
+    if not isinstance(batch_cfg, dict):
+        raise ValueError("Invalid config format: 'batch' must be a mapping.")
+
+    concurrency = batch_cfg.get("concurrency", 4)
+    if not isinstance(concurrency, int) or isinstance(concurrency, bool) or concurrency < 1:
+        raise ValueError("Invalid config value: 'batch.concurrency' must be a positive integer.")
+
+    server_cfg = raw.get("server", {})
+    if server_cfg is None:
+        server_cfg = {}
+    if not isinstance(server_cfg, dict):
+        raise ValueError("Invalid config format: 'server' must be a mapping.")
+
+    server_host = server_cfg.get("host", "127.0.0.1")
+    if not isinstance(server_host, str) or not server_host.strip():
+        raise ValueError("Invalid config value: 'server.host' must be non-empty string.")
+
+    server_tasks_root = server_cfg.get("tasks_root", "tasks")
+    if not isinstance(server_tasks_root, str) or not server_tasks_root.strip():
+        raise ValueError("Invalid config value: 'server.tasks_root' must be non-empty string.")
+
+    server_ints = {}
+    for key, default, minimum in (("port", 8765, 1), ("workers", 2, 1), ("queue_size", 16, 1), ("history", 256, 1)):
+        value = server_cfg.get(key, default)
+        if not isinstance(value, int) or isinstance(value, bool) or value < minimum:
+            raise ValueError(f"Invalid config value: 'server.{key}' must be a positive integer.")
+        server_ints[key] = value
+
+    suite_cfg = raw.get("suite", {})
+    if suite_cfg is None:
+        suite_cfg = {}
+    if not isinstance(suite_cfg, dict):
+        raise ValueError("Invalid config format: 'suite' must be a mapping.")
+
+    suite_globs = {}
+    for key, default in (("tasks", ["tasks/*"]), ("prompts", ["prompt.txt"])):
+        value = suite_cfg.get(key, default)
+        if not isinstance(value, list) or not value or not all(isinstance(v, str) and v for v in value):
+            raise ValueError(f"Invalid config value: 'suite.{key}' must be a non-empty list of glob strings.")
+        suite_globs[key] = tuple(value)
+
+    suite_paths = {}
+    for key, default in (("results_dir", "suite/results"), ("baseline", "suite/baseline.json")):
+        value = suite_cfg.get(key, default)
+        if not isinstance(value, str) or not value.strip():
+            raise ValueError(f"Invalid config value: 'suite.{key}' must be a non-empty string.")
+        suite_paths[key] = value
+
+    suite_numbers = {}
+    for key, default in (("tolerance_pct", 10.0), ("prompt_cost_per_mtok", 0.0), ("completion_cost_per_mtok", 0.0)):
+        value = suite_cfg.get(key, default)
+        if not isinstance(value, (int, float)) or isinstance(value, bool) or value < 0:
+            raise ValueError(f"Invalid config value: 'suite.{key}' must be a number >= 0.")
+        suite_numbers[key] = float(value)
+
+    cache_cfg = raw.get("cache", {})
+    if cache_cfg is None:
+        cache_cfg = {}
+    if not isinstance(cache_cfg, dict):
+        raise ValueError("Invalid config format: 'cache' must be a mapping.")
+
+    cache_enabled = cache_cfg.get("enabled", True)
+    if not isinstance(cache_enabled, bool):
+        raise ValueError("Invalid config value: 'cache.enabled' must be boolean.")
+
+    cache_dir = cache_cfg.get("dir", ".cache/llm")
+    if not isinstance(cache_dir, str) or not cache_dir.strip():
+        raise ValueError("Invalid config value: 'cache.dir' must be non-empty string.")
+
+    debug_cfg = raw.get("debug", {})
+    if debug_cfg is None:
+        debug_cfg = {}
+    if not isinstance(debug_cfg, dict):
+        raise ValueError("Invalid config format: 'debug' must be a mapping.")
+
+    export_debug_json = debug_cfg.get("export_json", True)
+    if not isinstance(export_debug_json, bool):
+        raise ValueError("Invalid config value: 'debug.export_json' must be boolean.")
+
+    blob_min_chars = debug_cfg.get("blob_min_chars", 512)
+    if not isinstance(blob_min_chars, int) or isinstance(blob_min_chars, bool) or blob_min_chars < 1:
+        raise ValueError("Invalid config value: 'debug.blob_min_chars' must be a positive integer.")
+
+    store_cfg = raw.get("store", {})
+    if store_cfg is None:
+        store_cfg = {}
+    if not isinstance(store_cfg, dict):
+        raise ValueError("Invalid config format: 'store' must be a mapping.")
+
+    store_mode = store_cfg.get("mode", "off")
+    if store_mode not in STORE_MODES:
+        raise ValueError(f"Invalid config value: 'store.mode' must be one of {', '.join(STORE_MODES)}.")
+
+    manager_cfg = raw.get("manager", {})
+    if manager_cfg is None:
+        manager_cfg = {}
+    if not isinstance(manager_cfg, dict):
+        raise ValueError("Invalid config format: 'manager' must be a mapping.")
+
+    fast_path = manager_cfg.get("fast_path", True)
+    if not isinstance(fast_path, bool):
+        raise ValueError("Invalid config value: 'manager.fast_path' must be boolean.")
+
+    min_confidence = manager_cfg.get("min_confidence", 0.75)
+    if (
+        not isinstance(min_confidence, (int, float))
+        or isinstance(min_confidence, bool)
+        or not 0.0 <= min_confidence <= 1.0
+    ):
+        raise ValueError("Invalid config value: 'manager.min_confidence' must be in [0, 1].")
+
+    skills_cfg = raw.get("skills", {})
+    if skills_cfg is None:
+        skills_cfg = {}
+    if not isinstance(skills_cfg, dict):
+        raise ValueError("Invalid config format: 'skills' must be a mapping.")
+
+    retrieval = skills_cfg.get("retrieval", True)
+    if not isinstance(retrieval, bool):
+        raise ValueError("Invalid config value: 'skills.retrieval' must be boolean.")
+
+    top_k = skills_cfg.get("top_k", 8)
+    if not isinstance(top_k, int) or isinstance(top_k, bool) or top_k < 1:
+        raise ValueError("Invalid config value: 'skills.top_k' must be a positive integer.")
+
+    token_budget = skills_cfg.get("token_budget", 2000)
+    if not isinstance(token_budget, int) or isinstance(token_budget, bool) or token_budget < 1:
+        raise ValueError("Invalid config value: 'skills.token_budget' must be a positive integer.")
+
+    candidates_cfg = raw.get("candidates", {})
+    if candidates_cfg is None:
+        candidates_cfg = {}
+    if not isinstance(candidates_cfg, dict):
+        raise ValueError("Invalid config format: 'candidates' must be a mapping.")
+
+    candidate_count = candidates_cfg.get("count", 1)
+    if not isinstance(candidate_count, int) or isinstance(candidate_count, bool) or candidate_count < 1:
+        raise ValueError("Invalid config value: 'candidates.count' must be a positive integer.")
+
+    temperatures = candidates_cfg.get("temperatures", [0.0, 0.4, 0.8])
+    if (
+        not isinstance(temperatures, list)
+        or not temperatures
+        or not all(isinstance(t, (int, float)) and not isinstance(t, bool) and t >= 0 for t in temperatures)
+    ):
+        raise ValueError("Invalid config value: 'candidates.temperatures' must be a non-empty list of numbers >= 0.")
+
+    vary_skills = candidates_cfg.get("vary_skills", True)
+    if not isinstance(vary_skills, bool):
+        raise ValueError("Invalid config value: 'candidates.vary_skills' must be boolean.")
+
+    incremental_cfg = raw.get("incremental", {})
+    if incremental_cfg is None:
+        incremental_cfg = {}
+    if not isinstance(incremental_cfg, dict):
+        raise ValueError("Invalid config format: 'incremental' must be a mapping.")
+
+    incremental_enabled = incremental_cfg.get("enabled", False)
+    if not isinstance(incremental_enabled, bool):
+        raise ValueError("Invalid config value: 'incremental.enabled' must be boolean.")
+
+    min_similarity = incremental_cfg.get("min_similarity", 0.6)
+    if not isinstance(min_similarity, (int, float)) or isinstance(min_similarity, bool) or not 0 <= min_similarity <= 1:
+        raise ValueError("Invalid config value: 'incremental.min_similarity' must be a number between 0 and 1.")
+
+    lint_cfg = raw.get("lint", {})
+    if lint_cfg is None:
+        lint_cfg = {}
+    if not isinstance(lint_cfg, dict):
+        raise ValueError("Invalid config format: 'lint' must be a mapping.")
+
+    lint_enabled = lint_cfg.get("enabled", True)
+    if not isinstance(lint_enabled, bool):
+        raise ValueError("Invalid config value: 'lint.enabled' must be boolean.")
+
+    lint_max_repairs = lint_cfg.get("max_repairs", 1)
+    if not isinstance(lint_max_repairs, int) or isinstance(lint_max_repairs, bool) or lint_max_repairs < 0:
+        raise ValueError("Invalid config value: 'lint.max_repairs' must be an integer >= 0.")
+
+    build_cfg = raw.get("build", {})
+    if build_cfg is None:
+        build_cfg = {}
+    if not isinstance(build_cfg, dict):
+        raise ValueError("Invalid config format: 'build' must be a mapping.")
+
+    build_enabled = build_cfg.get("enabled", False)
+    if not isinstance(build_enabled, bool):
+        raise ValueError("Invalid config value: 'build.enabled' must be boolean.")
+
+    idf_target = build_cfg.get("idf_target", "esp32s3")
+    if not isinstance(idf_target, str) or not idf_target.strip():
+        raise ValueError("Invalid config value: 'build.idf_target' must be non-empty string.")
+
+    build_cache_dir = build_cfg.get("cache_dir", ".cache/idf-build")
+    if not isinstance(build_cache_dir, str) or not build_cache_dir.strip():
+        raise ValueError("Invalid config value: 'build.cache_dir' must be non-empty string.")
+
+    build_ints = {}
+    for key, default, minimum in (("slots", 1, 1), ("max_repairs", 2, 0), ("timeout_s", 600, 1)):
+        value = build_cfg.get(key, default)
+        if not isinstance(value, int) or isinstance(value, bool) or value < minimum:
+            raise ValueError(f"Invalid config value: 'build.{key}' must be an integer >= {minimum}.")
+        build_ints[key] = value
+
+    firmware_cfg = raw.get("firmware", {})
+    if firmware_cfg is None:
+        firmware_cfg = {}
+    if not isinstance(firmware_cfg, dict):
+        raise ValueError("Invalid config format: 'firmware' must be a mapping.")
+
+    profile = firmware_cfg.get("profile", "auto")
+    valid_profiles = ["auto", "none", *PROFILES]
+    if profile not in valid_profiles:
+        raise ValueError(
+            f"Invalid config value: 'firmware.profile' must be one of {valid_profiles}."
+        )
+
+    instrument = firmware_cfg.get("instrument", False)
+    if not isinstance(instrument, bool):
+        raise ValueError("Invalid config value: 'firmware.instrument' must be boolean.")
+
+    benchmark_cfg = raw.get("benchmark", {})
+    if benchmark_cfg is None:
+        benchmark_cfg = {}
+    if not isinstance(benchmark_cfg, dict):
+        raise ValueError("Invalid config format: 'benchmark' must be a mapping.")
+
+    benchmark_enabled = benchmark_cfg.get("enabled", False)
+    if not isinstance(benchmark_enabled, bool):
+        raise ValueError("Invalid config value: 'benchmark.enabled' must be boolean.")
+    if benchmark_enabled and not build_enabled:
+        raise ValueError("Invalid config value: 'benchmark.enabled' requires 'build.enabled'.")
+
+    benchmark_strings = {}
+    for key in ("port", "analyzer_cmd", "current_cmd", "lock_dir"):
+        value = benchmark_cfg.get(key, ".cache/devices" if key == "lock_dir" else "")
+        if value is None:
+            value = ""
+        if not isinstance(value, str):
+            raise ValueError(f"Invalid config value: 'benchmark.{key}' must be string.")
+        benchmark_strings[key] = value
+    if not benchmark_strings["lock_dir"].strip():
+        raise ValueError("Invalid config value: 'benchmark.lock_dir' must be non-empty string.")
+
+    benchmark_ports = benchmark_cfg.get("ports", [])
+    if benchmark_ports is None:
+        benchmark_ports = []
+    if not isinstance(benchmark_ports, list) or not all(isinstance(p, str) and p for p in benchmark_ports):
+        raise ValueError("Invalid config value: 'benchmark.ports' must be a list of non-empty strings.")
+
+    benchmark_ints = {}
+    for key, default in (
+        ("baud", 115200), ("flash_baud", 921600), ("duration_s", 10), ("sample_us", 100), ("max_failures", 3),
+    ):
+        value = benchmark_cfg.get(key, default)
+        if not isinstance(value, int) or isinstance(value, bool) or value < 1:
+            raise ValueError(f"Invalid config value: 'benchmark.{key}' must be a positive integer.")
+        benchmark_ints[key] = value
+
     return AppConfig(
         input=InputConfig(
             task_dir=task_dir,
@@ -121,6 +625,37 @@ def load_config(config_path: str | Path = "config.yaml") -> AppConfig:
             temperature=float(temperature),
             api_base=api_base,
             api_key_env=api_key_env,
+            requests_per_min=requests_per_min,
+        ),
+        scheduler=SchedulerConfig(hedge=hedge, **scheduler_values),
+        prompt_cache=PromptCacheConfig(hints=cache_hints),
+        graph=GraphConfig(enable_diagram=enable_diagram, streaming=streaming),
+        batch=BatchConfig(concurrency=concurrency),
+        server=ServerConfig(host=server_host, tasks_root=server_tasks_root, **server_ints),
+        suite=SuiteConfig(**suite_globs, **suite_paths, **suite_numbers),
+        cache=CacheConfig(enabled=cache_enabled, dir=cache_dir),
+        store=StoreConfig(mode=store_mode),
+        debug=DebugConfig(export_json=export_debug_json, blob_min_chars=blob_min_chars),
+        manager=ManagerConfig(fast_path=fast_path, min_confidence=float(min_confidence)),
+        skills=SkillsConfig(retrieval=retrieval, top_k=top_k, token_budget=token_budget),
+        candidates=CandidatesConfig(
+            count=candidate_count,
+            temperatures=tuple(float(t) for t in temperatures),
+            vary_skills=vary_skills,
+        ),
+        incremental=IncrementalConfig(enabled=incremental_enabled, min_similarity=float(min_similarity)),
+        lint=LintConfig(enabled=lint_enabled, max_repairs=lint_max_repairs),
+        build=BuildConfig(
+            enabled=build_enabled,
+            idf_target=idf_target,
+            cache_dir=build_cache_dir,
+            **build_ints,
+        ),
+        firmware=FirmwareConfig(profile=profile, instrument=instrument),
+        benchmark=BenchmarkConfig(
+            enabled=benchmark_enabled,
+            ports=tuple(benchmark_ports),
+            **benchmark_strings,
+            **benchmark_ints,
         ),
-        graph=GraphConfig(enable_diagram=enable_diagram),
     )
@@ -0,0 +1,116 @@
+"""
+Streaming debug log: an append-only JSONL file per run with content-addressed bodies.
+
+Every node's debug entries are appended to <run_dir>/debug.jsonl as soon as
+the node finishes (see nodes.with_debug_sink), so a crashed run keeps
+everything up to the failing node. Strings of at least blob_min_chars chars
+(system prompts, skill context, raw LLM outputs) are written once to
+<run_dir>/blobs/<sha256>.txt and replaced in the entry by
+
+    {"$blob": "<sha256>", "chars": <length>}
+
+so a system prompt repeated by every repair iteration or candidate is stored
+once. The compacted entry is also what stays in the graph state, which keeps
+the operator.add-reduced debug_logs list small. export_json() rebuilds the
+old debug.json (full contents) from the JSONL when wanted.
+"""
+
+import hashlib
+import json
+import threading
+from pathlib import Path
+from typing import Any, Iterable, List
+
+DEBUG_JSONL = "debug.jsonl"
+BLOBS_DIR = "blobs"
+
+# Concurrent nodes (diagram/coder, candidates, batch jobs) append from several threads
+_lock = threading.Lock()
+
+
+def _compact(value: Any, blobs_dir: Path, min_chars: int) -> Any:
+    """Replace long strings in value with blob references, writing each blob once."""
+    if isinstance(value, str):
+        if len(value) < min_chars:
+            return value
+        digest = hashlib.sha256(value.encode("utf-8")).hexdigest()
+        path = blobs_dir / f"{digest}.txt"
+        if not path.exists():
+            blobs_dir.mkdir(parents=True, exist_ok=True)
+            path.write_text(value, encoding="utf-8")
+        return {"$blob": digest, "chars": len(value)}
+    if isinstance(value, dict):
+        return {k: _compact(v, blobs_dir, min_chars) for k, v in value.items()}
+    if isinstance(value, (list, tuple)):
+        return [_compact(v, blobs_dir, min_chars) for v in value]
+    if value is None or isinstance(value, (bool, int, float)):
+        return value
+    return _compact(str(getattr(value, "content", value)), blobs_dir, min_chars)
+
+
+def append_entries(run_path: Path, entries: Iterable[dict], blob_min_chars: int = 512) -> List[dict]:
+    """
+    Append debug entries to the run's debug.jsonl.
+
+    Returns:
+        The compacted entries (long input/output strings replaced by blob references)
+    """
+    blobs_dir = run_path / BLOBS_DIR
+    compacted = []
+    with _lock:
+        run_path.mkdir(parents=True, exist_ok=True)
+        with open(run_path / DEBUG_JSONL, "a", encoding="utf-8") as f:
+            for entry in entries:
+                entry = {
+                    **entry,
+                    "input": _compact(entry.get("input"), blobs_dir, blob_min_chars),
+                    "output": _compact(entry.get("output"), blobs_dir, blob_min_chars),
+                }
+                f.write(json.dumps(entry, default=str) + "\n")
+                compacted.append(entry)
+    return compacted
+
+
+def _resolve(value: Any, blobs_dir: Path) -> Any:
+    """Inverse of _compact: inline blob references again."""
+    if isinstance(value, dict):
+        if set(value) == {"$blob", "chars"}:
+            try:
+                return (blobs_dir / f"{value['$blob']}.txt").read_text(encoding="utf-8")
+            except OSError:
+                return value
+        return {k: _resolve(v, blobs_dir) for k, v in value.items()}
+    if isinstance(value, list):
+        return [_resolve(v, blobs_dir) for v in value]
+    return value
+
+
+def read_entries(run_path: Path, resolve: bool = True) -> List[dict]:
+    """Debug entries of a run in append order (a truncated last line is skipped)."""
+    try:
+        lines = (run_path / DEBUG_JSONL).read_text(encoding="utf-8").splitlines()
+    except OSError:
+        return []
+
+    entries = []
+    for line in lines:
+        try:
+            entries.append(json.loads(line))
+        except ValueError:
+            continue
+    if resolve:
+        entries = [_resolve(e, run_path / BLOBS_DIR) for e in entries]
+    return entries
+
+
+def export_json(run_path: Path, pending: Iterable[dict] = ()) -> Path:
+    """
+    Write the consolidated debug.json (full contents) from debug.jsonl.
+
+    Args:
+        pending: entries of the calling node, not yet appended
+    """
+    entries = [*read_entries(run_path), *pending]
+    path = run_path / "debug.json"
+    path.write_text(json.dumps(entries, indent=2, default=str), encoding="utf-8")
+    return path
@@ -0,0 +1,219 @@
+"""
+Hardware-in-the-loop device pool: many boards, one benchmark per board at a time.
+
+Boards are discovered by serial port from benchmark.ports (explicit ports or
+glob patterns, e.g. "/dev/serial/by-id/usb-Espressif*", re-globbed on every
+lease so hot-plugged boards join the pool) or the single benchmark.port.
+A benchmark leases a free board through a lock file per port under
+benchmark.lock_dir (like the warm build trees, see src/build.py), so
+candidates, batch jobs, server workers and separate processes benchmark on
+different boards in parallel and only wait when every board is busy.
+
+Flashing (flash_images) writes with compressed transfer at flash_baud and
+skips unchanged images: the sha256 of every image last written to a port is
+kept in <lock_dir>/<port>.json, images whose hash matches are confirmed
+on-chip with one esptool verify_flash (MD5 of the flash region) and only
+the rest - usually just the app - is written. A board whose flashing or
+serial connection fails max_failures times in a row is left out of the pool
+until it succeeds again (or every board is failing).
+"""
+
+import glob
+import hashlib
+import json
+import re
+import shlex
+import subprocess
+import sys
+import threading
+import time
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Dict, Iterator, List, Optional, Sequence, Tuple
+
+from src.locks import lease_any
+
+
+class NoDevicesError(RuntimeError):
+    """No board found for the configured ports."""
+
+
+class DeviceError(RuntimeError):
+    """esptool could not flash or verify the board."""
+
+
+def discover_ports(patterns: Sequence[str]) -> List[str]:
+    """Serial ports matching patterns (glob patterns or plain paths), sorted."""
+    ports = set()
+    for pattern in patterns:
+        if glob.has_magic(pattern):
+            ports.update(glob.glob(pattern))
+        elif pattern:
+            ports.add(pattern)
+    return sorted(ports)
+
+
+def _port_key(port: str) -> str:
+    return re.sub(r"[^A-Za-z0-9_.-]", "_", port.strip("/"))
+
+
+class DevicePool:
+    """Boards reachable by serial port, leased one run at a time (see module docstring)."""
+
+    def __init__(self, patterns: Sequence[str], lock_dir: Path, max_failures: int = 3):
+        self.patterns = list(patterns)
+        self.lock_dir = Path(lock_dir)
+        self.max_failures = max_failures
+        self._failures: Dict[str, int] = {}
+        self._lock = threading.Lock()
+
+    def lock_path(self, port: str) -> Path:
+        return self.lock_dir / f"{_port_key(port)}.lock"
+
+    def state_path(self, port: str) -> Path:
+        """Record of the images last flashed to port."""
+        return self.lock_dir / f"{_port_key(port)}.json"
+
+    def ports(self) -> List[str]:
+        """Discovered ports, without boards over max_failures (unless all are)."""
+        ports = discover_ports(self.patterns)
+        with self._lock:
+            healthy = [p for p in ports if self._failures.get(p, 0) < self.max_failures]
+        return healthy or ports
+
+    @contextmanager
+    def lease(self, key: str = "") -> Iterator[str]:
+        """
+        Hold a free board for the duration of the block and yield its port.
+
+        Blocks (on the board picked by key) when every board is busy.
+
+        Raises:
+            NoDevicesError: no port matches benchmark.ports / benchmark.port
+        """
+        ports = self.ports()
+        if not ports:
+            raise NoDevicesError(f"No board found for {', '.join(self.patterns) or 'benchmark.ports'}")
+        with lease_any([self.lock_path(p) for p in ports], fallback_index=hash(key)) as index:
+            yield ports[index]
+
+    def report(self, port: str, ok: bool) -> None:
+        """Record a benchmark outcome on port (hardware/connection errors count as failures)."""
+        with self._lock:
+            self._failures[port] = 0 if ok else self._failures.get(port, 0) + 1
+
+    def status(self) -> List[dict]:
+        """Discovered boards with their failure counts and last flashed images."""
+        boards = []
+        for port in discover_ports(self.patterns):
+            try:
+                flashed = json.loads(self.state_path(port).read_text(encoding="utf-8"))
+            except (OSError, ValueError):
+                flashed = None
+            with self._lock:
+                failures = self._failures.get(port, 0)
+            boards.append({"port": port, "failures": failures, "flashed": flashed})
+        return boards
+
+
+def parse_flash_args(firmware_dir: Path) -> Tuple[List[str], List[Tuple[str, str]]]:
+    """
+    Options and (offset, image) pairs of a build's flash_args file.
+
+    Raises:
+        ValueError: missing or empty flash_args
+    """
+    try:
+        tokens = shlex.split((firmware_dir / "flash_args").read_text(encoding="utf-8"))
+    except OSError as e:
+        raise ValueError(f"No flash_args in {firmware_dir}") from e
+
+    options: List[str] = []
+    images: List[Tuple[str, str]] = []
+    i = 0
+    while i < len(tokens):
+        token = tokens[i]
+        if token.startswith("--"):
+            options.append(token)
+            if i + 1 < len(tokens) and not tokens[i + 1].startswith("--") and not tokens[i + 1].startswith("0x"):
+                options.append(tokens[i + 1])
+                i += 1
+        elif i + 1 < len(tokens):
+            images.append((token, tokens[i + 1]))
+            i += 1
+        i += 1
+    if not images:
+        raise ValueError(f"No images in {firmware_dir / 'flash_args'}")
+    return options, images
+
+
+def _esptool(port: str, chip: str, baud: int, after: str, command: List[str], cwd: Path) -> subprocess.CompletedProcess:
+    cmd = [
+        sys.executable, "-m", "esptool",
+        "--chip", chip, "-p", port, "-b", str(baud),
+        "--before", "default_reset", "--after", after,
+        *command,
+    ]
+    return subprocess.run(cmd, cwd=cwd, capture_output=True, text=True, check=False)
+
+
+def flash_images(
+    port: str,
+    firmware_dir: Path,
+    chip: str = "esp32s3",
+    baud: int = 921600,
+    state_path: Optional[Path] = None,
+) -> dict:
+    """
+    Flash a build's images (per its flash_args), skipping images already on the board.
+
+    Args:
+        port: Serial port of the board
+        firmware_dir: <run_dir>/firmware from build_verify
+        chip: esptool chip name
+        baud: Flashing baud rate
+        state_path: Record of the images last flashed to this port (None: write everything)
+
+    Returns:
+        {"written": [images], "skipped": [images], "bytes_written", "elapsed_ms"}
+
+    Raises:
+        DeviceError: esptool failed
+    """
+    start_time = time.time()
+    options, images = parse_flash_args(firmware_dir)
+    digests = {offset: hashlib.sha256((firmware_dir / image).read_bytes()).hexdigest() for offset, image in images}
+
+    previous = {}
+    if state_path is not None:
+        try:
+            record = json.loads(state_path.read_text(encoding="utf-8"))
+            previous = record.get("images", {}) if record.get("chip") == chip else {}
+        except (OSError, ValueError):
+            previous = {}
+
+    unchanged = [(offset, image) for offset, image in images if previous.get(offset) == digests[offset]]
+    if unchanged:
+        verify = _esptool(port, chip, baud, "no_reset",
+                          ["verify_flash", *options, *[arg for pair in unchanged for arg in pair]], firmware_dir)
+        if verify.returncode != 0:
+            unchanged = []
+    changed = [pair for pair in images if pair not in unchanged]
+
+    if state_path is not None:
+        state_path.unlink(missing_ok=True)  # flash contents unknown until the write succeeds
+    if changed:
+        proc = _esptool(port, chip, baud, "hard_reset",
+                        ["write_flash", "-z", *options, *[arg for pair in changed for arg in pair]], firmware_dir)
+        if proc.returncode != 0:
+            raise DeviceError(f"esptool write_flash failed: {proc.stderr.strip() or proc.stdout.strip()}")
+    if state_path is not None:
+        state_path.parent.mkdir(parents=True, exist_ok=True)
+        state_path.write_text(json.dumps({"chip": chip, "images": digests}, indent=2), encoding="utf-8")
+
+    return {
+        "written": [image for _, image in changed],
+        "skipped": [image for _, image in unchanged],
+        "bytes_written": sum((firmware_dir / image).stat().st_size for _, image in changed),
+        "elapsed_ms": round((time.time() - start_time) * 1000, 2),
+    }
@@ -0,0 +1,133 @@
+"""
+Host-side decoder for the dlog firmware component (firmware/components/dlog).
+
+dlog records carry the addresses of the tag and format string instead of
+text, so decoding needs the firmware ELF; run_build keeps it as
+<run_dir>/firmware/embed_agent_app.elf. Non-dlog lines pass through.
+
+Usage:
+    python -m src.dlog <firmware.elf> [capture.log]   # reads stdin by default
+"""
+
+import re
+import struct
+import sys
+from pathlib import Path
+from typing import Iterable, Iterator, List, Optional, Tuple
+
+LEVEL_LETTERS = {1: "E", 2: "W", 3: "I", 4: "D", 5: "V"}
+
+_CONVERSION_RE = re.compile(r"%([-+ #0]*)(\d*)(?:\.(\d+))?(hh|h|ll|l|z|j|t|L)?([diouxXcspfFeEgGaA%])")
+
+SHF_ALLOC = 0x2
+SHT_NOBITS = 8
+
+
+class ElfImage:
+    """Minimal little-endian ELF32 reader: allocated sections by address."""
+
+    def __init__(self, path: Path):
+        self.path = Path(path)
+        data = self.path.read_bytes()
+        if data[:4] != b"\x7fELF" or data[4] != 1 or data[5] != 1:
+            raise ValueError(f"{path}: not a little-endian ELF32 file")
+
+        shoff, = struct.unpack_from("<I", data, 0x20)
+        shentsize, shnum = struct.unpack_from("<HH", data, 0x2E)
+
+        self._sections: List[Tuple[int, int, bytes]] = []
+        for i in range(shnum):
+            _, sh_type, flags, addr, offset, size = struct.unpack_from("<IIIIII", data, shoff + i * shentsize)
+            if flags & SHF_ALLOC and sh_type != SHT_NOBITS and addr and size:
+                self._sections.append((addr, size, data[offset:offset + size]))
+
+    def read_cstring(self, address: int) -> Optional[str]:
+        """Return the NUL-terminated string at a target address, if it is in the image."""
+        for addr, size, blob in self._sections:
+            if addr <= address < addr + size:
+                start = address - addr
+                end = blob.find(b"\0", start)
+                return blob[start:end if end >= 0 else size].decode("utf-8", errors="replace")
+        return None
+
+
+def _take(words: List[int], count: int) -> int:
+    value = 0
+    for shift in range(count):
+        value |= (words.pop(0) if words else 0) << (32 * shift)
+    return value
+
+
+def format_message(fmt: str, words: List[int], elf: ElfImage) -> str:
+    """Apply a printf format to recorded argument words (one per argument, two for 64-bit and double; see dlog.h DLOG_LAYOUT)."""
+    words = list(words)
+
+    def render(match: re.Match) -> str:
+        flags, width, precision, length, conv = match.groups()
+        if conv == "%":
+            return "%"
+
+        spec = f"%{flags}{width}" + (f".{precision}" if precision is not None else "")
+        if conv in "fFeEgGaA":
+            value = struct.unpack("<d", struct.pack("<Q", _take(words, 2)))[0]
+            return (spec + ("e" if conv in "aA" else conv)) % value
+
+        wide = length in ("ll", "j")
+        raw = _take(words, 2 if wide else 1)
+        bits = 64 if wide else 32
+        if conv == "s":
+            text = elf.read_cstring(raw)
+            return (spec + "s") % (text if text is not None else f"<str@0x{raw:08x}>")
+        if conv == "p":
+            return f"0x{raw:x}"
+        if conv == "c":
+            return (spec + "c") % chr(raw & 0xFF)
+        if conv in "di" and raw >= 1 << (bits - 1):
+            raw -= 1 << bits
+        return (spec + ("d" if conv in "diu" else conv)) % raw
+
+    return _CONVERSION_RE.sub(render, fmt)
+
+
+def decode_line(line: str, elf: ElfImage) -> str:
+    """Decode one @DL record (ESP_LOG style); other lines are returned unchanged."""
+    if not line.startswith("@DL,"):
+        return line
+
+    fields = line.strip().split(",")
+    if fields[1] == "O":
+        return f"W dlog: {fields[2]} records dropped (ring full)"
+
+    try:
+        core, t_us, level = int(fields[1]), int(fields[2]), int(fields[3])
+        tag_addr, fmt_addr = int(fields[4], 16), int(fields[5], 16)
+        words = [int(w, 16) for w in fields[6:]]
+    except (IndexError, ValueError):
+        return line
+
+    tag = elf.read_cstring(tag_addr) or f"0x{tag_addr:08x}"
+    fmt = elf.read_cstring(fmt_addr)
+    message = format_message(fmt, words, elf) if fmt is not None else f"<fmt@0x{fmt_addr:08x}> {words}"
+    return f"{LEVEL_LETTERS.get(level, '?')} ({t_us // 1000}) {tag}: {message} [core {core}]"
+
+
+def decode_lines(lines: Iterable[str], elf: ElfImage) -> Iterator[str]:
+    for line in lines:
+        yield decode_line(line.rstrip("\r\n"), elf)
+
+
+def main(argv: List[str]) -> int:
+    if not argv or len(argv) > 2:
+        print(__doc__.strip().splitlines()[-1].strip(), file=sys.stderr)
+        return 2
+
+    elf = ElfImage(Path(argv[0]))
+    source = Path(argv[1]).open(encoding="utf-8", errors="replace") if len(argv) > 1 else sys.stdin
+    with source:
+        for decoded in decode_lines(source, elf):
+            print(decoded)
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main(sys.argv[1:]))
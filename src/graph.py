@@ -2,36 +2,88 @@
 LangGraph workflow definition for the embedded code generation agent.
 
 Graph structure:
-    manager -> prepare_workspace -> coder -> assemble_artifacts -> persist -> END
+    manager -> prepare_workspace -> coder -> assemble_artifacts -> lint_firmware -> persist -> END
 
-Diagram support is kept behind a switch so it can be re-enabled without
-changing node implementations.
+lint_firmware loops back to coder with interrupt-context violations for a
+bounded number of repair iterations (lint.max_repairs):
+    lint_firmware -> (coder | persist)
+
+With incremental mode, assemble_artifacts applies the coder's diff against the
+last successful run and goes back to coder for one full rewrite if it does
+not apply:
+    assemble_artifacts -> (coder | lint_firmware)
+
+With enable_build, persist is followed by build_verify, which loops back to
+coder with compiler diagnostics for a bounded number of repair iterations:
+    persist -> build_verify -> (coder | END)
+
+With enable_benchmark (requires enable_build), a successful build is flashed
+and measured on the board before the run ends:
+    build_verify -> benchmark -> END
+
+With enable_diagram, prepare_workspace also fans out to diagram, which runs
+in the same superstep as coder (concurrently), and both fan in at
+assemble_artifacts.
+
+With candidates > 1, prepare_workspace instead fans out one candidate node
+per variant (LangGraph Send, run concurrently); each generates, lints, builds
+and benchmarks its own code, and select_candidate keeps the best one:
+    prepare_workspace -> candidate x N -> select_candidate -> persist -> END
+
+Every node is wrapped with with_debug_sink, which streams its debug entries to
+<run_dir>/debug.jsonl as it finishes.
+
+With streaming enabled, the LLM nodes use their async astream variants; the
+compiled graph must then be driven via ainvoke/astream.
 """
 
 from langgraph.graph import END, StateGraph
 
 from src.nodes import (
+    acoder_node,
+    adiagram_node,
+    amanager_node,
     assemble_artifacts_node,
+    benchmark_node,
+    build_verify_node,
+    candidate_node,
     coder_node,
     diagram_node,
+    fan_out_candidates,
+    lint_firmware_node,
     manager_node,
     persist_node,
     prepare_workspace_node,
+    route_after_assemble,
+    route_after_build,
+    route_after_lint,
+    select_candidate_node,
+    with_debug_sink,
 )
 from src.state import AgentState
 
 
-def build_graph(enable_diagram: bool = False):
+def build_graph(
+    enable_diagram: bool = False,
+    streaming: bool = False,
+    enable_build: bool = False,
+    enable_benchmark: bool = False,
+    candidates: int = 1,
+):
     """Build and compile the agent workflow graph."""
+    if candidates > 1:
+        return _build_candidates_graph(enable_diagram, streaming)
+
     workflow = StateGraph(AgentState)
 
     # Add nodes
-    workflow.add_node("manager", manager_node)
-    workflow.add_node("prepare_workspace", prepare_workspace_node)
-    workflow.add_node("coder", coder_node)
-    workflow.add_node("diagram", diagram_node)
-    workflow.add_node("assemble_artifacts", assemble_artifacts_node)
-    workflow.add_node("persist", persist_node)
+    workflow.add_node("manager", with_debug_sink(amanager_node if streaming else manager_node))
+    workflow.add_node("prepare_workspace", with_debug_sink(prepare_workspace_node))
+    workflow.add_node("coder", with_debug_sink(acoder_node if streaming else coder_node))
+    workflow.add_node("diagram", with_debug_sink(adiagram_node if streaming else diagram_node))
+    workflow.add_node("assemble_artifacts", with_debug_sink(assemble_artifacts_node))
+    workflow.add_node("lint_firmware", with_debug_sink(lint_firmware_node))
+    workflow.add_node("persist", with_debug_sink(persist_node))
 
     # Entry point
     workflow.set_entry_point("manager")
@@ -46,9 +98,58 @@ def build_graph(enable_diagram: bool = False):
         workflow.add_edge("prepare_workspace", "diagram")
         workflow.add_edge("diagram", "assemble_artifacts")
 
-    workflow.add_edge("assemble_artifacts", "persist")
+    workflow.add_conditional_edges(
+        "assemble_artifacts",
+        route_after_assemble,
+        {"repair": "coder", "lint": "lint_firmware"},
+    )
+    workflow.add_conditional_edges(
+        "lint_firmware",
+        route_after_lint,
+        {"repair": "coder", "done": "persist"},
+    )
+
+    if enable_build:
+        workflow.add_node("build_verify", with_debug_sink(build_verify_node))
+        workflow.add_edge("persist", "build_verify")
+        done = END
+        if enable_benchmark:
+            workflow.add_node("benchmark", with_debug_sink(benchmark_node))
+            workflow.add_edge("benchmark", END)
+            done = "benchmark"
+        workflow.add_conditional_edges(
+            "build_verify",
+            route_after_build,
+            {"repair": "coder", "done": done},
+        )
+    else:
+        # End
+        workflow.add_edge("persist", END)
+
+    return workflow.compile()
+
+
+def _build_candidates_graph(enable_diagram: bool, streaming: bool):
+    """Multi-candidate variant: build/benchmark happen inside each candidate."""
+    workflow = StateGraph(AgentState)
+
+    workflow.add_node("manager", with_debug_sink(amanager_node if streaming else manager_node))
+    workflow.add_node("prepare_workspace", with_debug_sink(prepare_workspace_node))
+    workflow.add_node("candidate", with_debug_sink(candidate_node))
+    workflow.add_node("select_candidate", with_debug_sink(select_candidate_node))
+    workflow.add_node("persist", with_debug_sink(persist_node))
+
+    workflow.set_entry_point("manager")
+    workflow.add_edge("manager", "prepare_workspace")
+    workflow.add_conditional_edges("prepare_workspace", fan_out_candidates, ["candidate"])
+    workflow.add_edge("candidate", "select_candidate")
+
+    if enable_diagram:
+        workflow.add_node("diagram", with_debug_sink(adiagram_node if streaming else diagram_node))
+        workflow.add_edge("prepare_workspace", "diagram")
+        workflow.add_edge("diagram", "select_candidate")
 
-    # End
+    workflow.add_edge("select_candidate", "persist")
     workflow.add_edge("persist", END)
 
-    return workflow.compile()
\ No newline at end of file
+    return workflow.compile()
@@ -0,0 +1,461 @@
+"""
+Static checks for the interrupt-context code of generated ESP-IDF firmware.
+
+lint_c() parses main.c with tree-sitter (the tree-sitter and tree-sitter-c
+packages, imported lazily; the check is skipped when they are missing) and
+collects the functions that run in interrupt context: IRAM_ATTR functions,
+handlers registered with gpio_isr_handler_add()/esp_intr_alloc()/
+periodic_timer_init()/timer_wheel_channel_init(), gptimer/RMT/PCNT event callbacks and ESP_TIMER_ISR
+esp_timer callbacks, plus every function of the file they call.
+
+Rules (severity error unless noted):
+    nonsafe-call         FreeRTOS API without FromISR, heap allocation or a
+                         blocking driver call
+    logging              ESP_LOGx/printf family
+    float                float/double types or literals (Xtensa ISRs must not
+                         touch the FPU)
+    non-iram-callee      call to a function of the file that is not IRAM_ATTR
+                         (warning for inline helpers)
+    isr-not-iram         registered handler without IRAM_ATTR (warning unless
+                         the file allocates interrupts with ESP_INTR_FLAG_IRAM)
+    missing-yield        ...FromISR() with a NULL woken flag, or a woken flag
+                         never passed to portYIELD_FROM_ISR() nor returned
+    shared-not-volatile  file-scope variable written in interrupt context and
+                         read by task code without volatile/_Atomic/__atomic
+
+The ATTR macros are blanked out (same length, so offsets and line numbers are
+kept) before parsing, as tree-sitter does not expand macros.
+"""
+
+import re
+import time
+from dataclasses import asdict, dataclass, field
+from functools import lru_cache
+from typing import Dict, List, Optional, Set
+
+_ATTR_RE = re.compile(r"\b(?:IRAM_ATTR|DRAM_ATTR|FORCE_INLINE_ATTR|NOINLINE_ATTR|RTC_\w*ATTR|EXT_RAM_\w*ATTR)\b")
+_FREERTOS_RE = re.compile(r"^(?:x|v|ul|ux|pc|e)(?:Queue|Semaphore|Task|EventGroup|Timer|StreamBuffer|MessageBuffer)[A-Z]\w*$")
+_FLOAT_LITERAL_RE = re.compile(r"^(?:\d+\.\d*|\.\d+|\d+[eE][-+]?\d+|\d+(?:\.\d*)?[eE]?[-+]?\d*[fF])$")
+
+# ISR registration calls: function name -> index of the handler argument.
+ISR_REGISTRARS = {
+    "gpio_isr_handler_add": 1,
+    "gpio_isr_register": 0,
+    "esp_intr_alloc": 2,
+    "esp_intr_alloc_intrstatus": 4,
+    "periodic_timer_init": 1,
+    "timer_wheel_channel_init": 1,
+}
+
+# Driver event-callback struct fields invoked from the driver's ISR.
+ISR_CALLBACK_FIELDS = {
+    "on_alarm",        # gptimer
+    "on_trans_done",   # rmt tx
+    "on_recv_done",    # rmt rx
+    "on_reach",        # pcnt
+    "on_full",         # mcpwm/capture
+    "on_empty",
+    "on_cap",
+}
+
+# FromISR calls whose last argument is the pxHigherPriorityTaskWoken flag.
+WOKEN_FLAG_CALLS = {
+    "xQueueSendFromISR",
+    "xQueueSendToBackFromISR",
+    "xQueueSendToFrontFromISR",
+    "xQueueOverwriteFromISR",
+    "xQueueReceiveFromISR",
+    "xSemaphoreGiveFromISR",
+    "xSemaphoreTakeFromISR",
+    "vTaskNotifyGiveFromISR",
+    "xTaskNotifyFromISR",
+    "xTaskNotifyAndQueryFromISR",
+    "xEventGroupSetBitsFromISR",
+    "xStreamBufferSendFromISR",
+    "xMessageBufferSendFromISR",
+    "xTimerStartFromISR",
+    "xTimerResetFromISR",
+}
+
+YIELD_CALLS = {"portYIELD_FROM_ISR", "portEND_SWITCHING_ISR", "portYIELD_FROM_ISR_ARG"}
+
+# Name -> fix hint for calls that must not run in interrupt context.
+NONSAFE_CALLS = {
+    "xTaskGetHandle": "it walks every task list comparing names; store the TaskHandle_t in a static variable when the task is created",
+    "vTaskDelay": "an ISR cannot block; move the delay into a task or use a one-shot timer",
+    "vTaskDelayUntil": "an ISR cannot block; move the delay into a task",
+    "malloc": "allocate the buffer statically (or once at init) instead",
+    "calloc": "allocate the buffer statically (or once at init) instead",
+    "realloc": "allocate the buffer statically (or once at init) instead",
+    "free": "free buffers from a task, never from an ISR",
+    "heap_caps_malloc": "allocate the buffer statically (or once at init) instead",
+    "heap_caps_calloc": "allocate the buffer statically (or once at init) instead",
+    "heap_caps_free": "free buffers from a task, never from an ISR",
+    "strdup": "copy into a static buffer instead",
+    "gpio_config": "configure pins once at init, then use gpio_set_level()",
+    "gpio_install_isr_service": "install the ISR service once at init from a task",
+    "gpio_isr_handler_add": "register handlers once at init from a task",
+    "esp_timer_create": "create timers once at init",
+    "gptimer_new_timer": "create timers once at init",
+    "vTaskSuspend": "use xTaskResumeFromISR()/task notifications from the ISR",
+}
+NONSAFE_PREFIXES = ("uart_", "i2c_", "spi_device_", "nvs_", "esp_wifi_", "esp_http_", "esp_mqtt_")
+
+LOGGING_CALLS = {"printf", "fprintf", "vprintf", "puts", "putchar", "fputs", "ESP_LOGE", "ESP_LOGW", "ESP_LOGI", "ESP_LOGD", "ESP_LOGV"}
+
+MAX_FINDINGS = 30
+
+
+@dataclass
+class LintResult:
+    """Outcome of the interrupt-context lint."""
+
+    status: str = "skipped"  # ok | failed | skipped
+    reason: str = ""
+    duration_ms: float = 0.0
+    isr_functions: List[str] = field(default_factory=list)
+    findings: List[dict] = field(default_factory=list)
+
+    @property
+    def errors(self) -> List[dict]:
+        return [f for f in self.findings if f["severity"] == "error"]
+
+    def to_dict(self) -> dict:
+        return asdict(self)
+
+
+@lru_cache(maxsize=1)
+def _parser():
+    """Return a tree-sitter C parser, or None when tree-sitter is not installed."""
+    try:
+        import tree_sitter_c  # pylint: disable=import-outside-toplevel
+        from tree_sitter import Language, Parser  # pylint: disable=import-outside-toplevel
+    except ImportError:
+        return None
+    return Parser(Language(tree_sitter_c.language()))
+
+
+def _text(node) -> str:
+    return node.text.decode("utf-8", errors="replace")
+
+
+def _line(node) -> int:
+    return node.start_point[0] + 1
+
+
+def _walk(node):
+    """Yield node and all of its descendants (depth first)."""
+    stack = [node]
+    while stack:
+        current = stack.pop()
+        yield current
+        stack.extend(reversed(current.children))
+
+
+def _declarator_name(node) -> Optional[str]:
+    """Identifier declared by a (possibly nested) declarator."""
+    while node is not None:
+        if node.type in ("identifier", "field_identifier"):
+            return _text(node)
+        node = node.child_by_field_name("declarator")
+    return None
+
+
+def _is_function_declarator(node) -> bool:
+    while node is not None:
+        if node.type == "function_declarator":
+            return True
+        node = node.child_by_field_name("declarator")
+    return False
+
+
+def _call_name(call) -> Optional[str]:
+    function = call.child_by_field_name("function")
+    return _text(function) if function is not None and function.type == "identifier" else None
+
+
+def _call_args(call) -> list:
+    args = call.child_by_field_name("arguments")
+    return [child for child in args.named_children if child.type != "comment"] if args is not None else []
+
+
+def _base_identifier(node) -> Optional[str]:
+    """Variable written by an lvalue such as x, x.f, x[i] or (x)."""
+    while node is not None:
+        if node.type == "identifier":
+            return _text(node)
+        if node.type in ("field_expression", "subscript_expression"):
+            node = node.child_by_field_name("argument")
+        elif node.type == "parenthesized_expression":
+            node = node.named_children[0] if node.named_children else None
+        else:
+            return None
+    return None
+
+
+class _Unit:
+    """Function/global index of one parsed translation unit."""
+
+    def __init__(self, root, attr_spans: Dict[int, str]):
+        self.functions = {}  # name -> function_definition node
+        self.iram: Set[str] = set()
+        self.inline: Set[str] = set()
+        self.globals = {}  # name -> declaration node
+
+        def attrs_in(start: int, end: int) -> Set[str]:
+            return {name for offset, name in attr_spans.items() if start <= offset < end}
+
+        for node in root.named_children:
+            if node.type == "function_definition":
+                name = _declarator_name(node.child_by_field_name("declarator"))
+                if not name:
+                    continue
+                body = node.child_by_field_name("body")
+                header_end = body.start_byte if body is not None else node.end_byte
+                attrs = attrs_in(node.start_byte, header_end)
+                header = _text(node)[: header_end - node.start_byte]
+                self.functions[name] = node
+                if "IRAM_ATTR" in attrs:
+                    self.iram.add(name)
+                if "FORCE_INLINE_ATTR" in attrs or re.search(r"\binline\b", header):
+                    self.inline.add(name)
+            elif node.type == "declaration":
+                for declarator in node.children_by_field_name("declarator"):
+                    name = _declarator_name(declarator)
+                    if not name:
+                        continue
+                    if _is_function_declarator(declarator):
+                        if "IRAM_ATTR" in attrs_in(node.start_byte, node.end_byte):
+                            self.iram.add(name)
+                    elif declarator.type != "array_declarator" and (
+                        declarator.type != "init_declarator"
+                        or declarator.child_by_field_name("declarator").type != "array_declarator"
+                    ):
+                        self.globals[name] = node
+
+    def calls(self, name: str):
+        for node in _walk(self.functions[name]):
+            if node.type == "call_expression":
+                yield node, _call_name(node)
+
+
+def _registered_handlers(root) -> Dict[str, int]:
+    """Functions handed to an ISR registration API -> line of registration."""
+    handlers = {}
+    for node in _walk(root):
+        if node.type == "call_expression":
+            index = ISR_REGISTRARS.get(_call_name(node))
+            args = _call_args(node)
+            if index is not None and index < len(args) and args[index].type == "identifier":
+                handlers.setdefault(_text(args[index]), _line(node))
+        elif node.type == "initializer_list":
+            pairs = {}
+            for pair in node.named_children:
+                if pair.type != "initializer_pair":
+                    continue
+                designator = pair.child_by_field_name("designator")
+                value = pair.child_by_field_name("value")
+                if designator is not None and value is not None:
+                    pairs[_text(designator).lstrip(".")] = value
+            for key, value in pairs.items():
+                is_isr_field = key in ISR_CALLBACK_FIELDS or (
+                    key == "callback" and _text(pairs.get("dispatch_method", value)) == "ESP_TIMER_ISR"
+                )
+                if is_isr_field and value.type == "identifier":
+                    handlers.setdefault(_text(value), _line(value))
+        elif node.type == "assignment_expression":
+            left = node.child_by_field_name("left")
+            right = node.child_by_field_name("right")
+            if (
+                left is not None and left.type == "field_expression"
+                and right is not None and right.type == "identifier"
+            ):
+                field_node = left.child_by_field_name("field")
+                if field_node is not None and _text(field_node) in ISR_CALLBACK_FIELDS:
+                    handlers.setdefault(_text(right), _line(node))
+    return handlers
+
+
+def _finding(rule: str, severity: str, function: str, node, message: str) -> dict:
+    return {"rule": rule, "severity": severity, "function": function, "line": _line(node), "message": message}
+
+
+def _check_function(unit: _Unit, name: str) -> List[dict]:
+    findings = []
+    node = unit.functions[name]
+
+    woken_flags = {}
+    yields = False
+    float_node = None
+    returned = " ".join(_text(n) for n in _walk(node) if n.type == "return_statement")
+
+    for child in _walk(node):
+        if child.type == "primitive_type" and _text(child) in ("float", "double"):
+            float_node = float_node or child
+        elif child.type == "number_literal" and _FLOAT_LITERAL_RE.match(_text(child)):
+            float_node = float_node or child
+
+    for call, callee in unit.calls(name):
+        if not callee:
+            continue
+        if callee in YIELD_CALLS:
+            yields = True
+        elif callee in NONSAFE_CALLS:
+            findings.append(_finding(
+                "nonsafe-call", "error", name, call,
+                f"{callee}() is not ISR-safe: {NONSAFE_CALLS[callee]}",
+            ))
+        elif _FREERTOS_RE.match(callee) and not callee.endswith("FromISR"):
+            findings.append(_finding(
+                "nonsafe-call", "error", name, call,
+                f"{callee}() must not be called from an ISR; use its FromISR variant "
+                "(or a task notification) with a woken flag",
+            ))
+        elif callee.startswith(NONSAFE_PREFIXES):
+            findings.append(_finding(
+                "nonsafe-call", "error", name, call,
+                f"{callee}() takes driver locks or blocks; hand the work to a task via a queue/notification",
+            ))
+        elif callee in LOGGING_CALLS:
+            findings.append(_finding(
+                "logging", "error", name, call,
+                f"{callee}() in interrupt context; use DLOGx() (dlog component) or ESP_DRAM_LOGx(), "
+                "or log from the consumer task",
+            ))
+
+        if callee in WOKEN_FLAG_CALLS:
+            args = _call_args(call)
+            flag = args[-1] if args else None
+            flag_text = _text(flag) if flag is not None else ""
+            if flag_text in ("NULL", "0", "nullptr"):
+                findings.append(_finding(
+                    "missing-yield", "error", name, call,
+                    f"{callee}() with a NULL woken flag: the woken task waits for the next tick; pass "
+                    "&woken and end the ISR with portYIELD_FROM_ISR(woken)",
+                ))
+            elif flag_text.startswith("&"):
+                woken_flags.setdefault(flag_text[1:].strip(), call)
+
+        if callee in unit.functions and callee not in unit.iram:
+            inline = callee in unit.inline
+            findings.append(_finding(
+                "non-iram-callee", "warning" if inline else "error", name, call,
+                f"{callee}() is called from interrupt context but is not IRAM_ATTR"
+                + (" (inline is only a hint)" if inline else "")
+                + "; mark it IRAM_ATTR",
+            ))
+
+    if not yields:
+        for flag, call in woken_flags.items():
+            if not re.search(rf"\b{re.escape(flag)}\b", returned):
+                findings.append(_finding(
+                    "missing-yield", "error", name, call,
+                    f"woken flag '{flag}' is never yielded on; end the ISR with portYIELD_FROM_ISR({flag}) "
+                    "(driver callbacks: return it)",
+                ))
+
+    if float_node is not None:
+        findings.append(_finding(
+            "float", "error", name, float_node,
+            "floating point in interrupt context (the FPU is not saved for ISRs); use integer/fixed-point "
+            "math or defer the computation to a task",
+        ))
+
+    return findings
+
+
+def _check_shared(unit: _Unit, isr: Set[str], source: str) -> List[dict]:
+    """Globals written in interrupt context and read by task code without volatile/atomics."""
+    atomic_vars = set(re.findall(r"\b(?:__atomic_\w+|atomic_\w+)\s*\(\s*&\s*(\w+)", source))
+    written = {}
+    for name in isr:
+        for node in _walk(unit.functions[name]):
+            target = None
+            if node.type == "assignment_expression":
+                target = node.child_by_field_name("left")
+            elif node.type == "update_expression":
+                target = node.child_by_field_name("argument")
+            var = _base_identifier(target) if target is not None else None
+            if var in unit.globals:
+                written.setdefault(var, (name, node))
+
+    findings = []
+    for var, (isr_name, node) in sorted(written.items()):
+        declaration = _text(unit.globals[var])
+        if re.search(r"\b(?:volatile|_Atomic|const)\b|\bstd::atomic\b", declaration) or var in atomic_vars:
+            continue
+        readers = [
+            name for name, fn in unit.functions.items()
+            if name not in isr and any(n.type == "identifier" and _text(n) == var for n in _walk(fn))
+        ]
+        if readers:
+            findings.append(_finding(
+                "shared-not-volatile", "error", isr_name, node,
+                f"'{var}' is written here and read by {', '.join(sorted(readers))}() but is not volatile; "
+                "declare it volatile (or use __atomic_* / a queue)",
+            ))
+    return findings
+
+
+def lint_c(source: str) -> LintResult:
+    """
+    Lint the interrupt-context code of one C translation unit.
+
+    Returns:
+        LintResult: "ok" (warnings only), "failed" (errors found) or "skipped"
+        (tree-sitter not installed).
+    """
+    start_time = time.time()
+    parser = _parser()
+    if parser is None:
+        return LintResult(status="skipped", reason="tree-sitter / tree-sitter-c not installed")
+
+    attr_spans = {match.start(): match.group(0) for match in _ATTR_RE.finditer(source)}
+    masked = _ATTR_RE.sub(lambda m: " " * len(m.group(0)), source)
+    root = parser.parse(masked.encode("utf-8")).root_node
+    unit = _Unit(root, {len(masked[:offset].encode("utf-8")): name for offset, name in attr_spans.items()})
+
+    handlers = {name: line for name, line in _registered_handlers(root).items() if name in unit.functions}
+    wanted = [*handlers, *(name for name in unit.iram if name in unit.functions)]
+    isr: Set[str] = set()
+    while wanted:
+        name = wanted.pop()
+        if name in isr:
+            continue
+        isr.add(name)
+        wanted.extend(callee for _, callee in unit.calls(name) if callee in unit.functions)
+
+    findings = []
+    iram_intr = "ESP_INTR_FLAG_IRAM" in source
+    for name, line in sorted(handlers.items()):
+        if name not in unit.iram:
+            findings.append({
+                "rule": "isr-not-iram",
+                "severity": "error" if iram_intr else "warning",
+                "function": name,
+                "line": line,
+                "message": f"{name}() is registered as an interrupt handler but is not IRAM_ATTR "
+                "(it faults while the flash cache is disabled)",
+            })
+    for name in sorted(isr):
+        findings.extend(_check_function(unit, name))
+    findings.extend(_check_shared(unit, isr, source))
+    findings.sort(key=lambda f: (f["severity"] != "error", f["line"]))
+
+    result = LintResult(
+        status="failed" if any(f["severity"] == "error" for f in findings) else "ok",
+        isr_functions=sorted(isr),
+        findings=findings[:MAX_FINDINGS],
+    )
+    if len(findings) > MAX_FINDINGS:
+        result.reason = f"{len(findings) - MAX_FINDINGS} further findings omitted"
+    result.duration_ms = round((time.time() - start_time) * 1000, 2)
+    return result
+
+
+def render_findings(findings: List[dict], path: str = "main/main.c") -> str:
+    """Render findings as repair hints for the coder prompt."""
+    return "\n".join(
+        f"{path}:{f['line']}: {f['severity']} [{f['rule']}] in {f['function']}(): {f['message']}"
+        for f in findings
+    )
@@ -1,8 +1,69 @@
+import json
+import math
+import os
+import re
+import tempfile
+import threading
 from pathlib import Path
-from typing import Dict, Optional
+from typing import Dict, List, Optional
 
 import yaml
 
+INDEX_VERSION = 2
+
+# Rough chars-per-token ratio used for prompt budgeting (no tokenizer dependency).
+CHARS_PER_TOKEN = 4
+
+_STOPWORDS = {
+    "a", "an", "and", "are", "as", "at", "be", "by", "can", "do", "each", "for",
+    "from", "help", "how", "if", "in", "is", "it", "its", "me", "must", "not", "of",
+    "on", "or", "should", "so", "that", "the", "then", "this", "to", "using", "when",
+    "will", "with", "write", "you", "your",
+}
+
+
+def estimate_tokens(text: str) -> int:
+    """Estimate the token count of text."""
+    return math.ceil(len(text) / CHARS_PER_TOKEN)
+
+
+def _tokenize(text: str) -> List[str]:
+    """Lowercase word tokens without stopwords."""
+    return [
+        t for t in re.findall(r"[a-z0-9_]+", text.lower())
+        if len(t) > 1 and t not in _STOPWORDS
+    ]
+
+
+def split_sections(body: str) -> List[dict]:
+    """
+    Split a skill body into sections at markdown headings.
+
+    Returns:
+        List of {"heading": str, "text": str}; text includes the heading line.
+        Content before the first heading becomes a section with an empty heading.
+    """
+    sections: List[dict] = []
+    heading = ""
+    lines: List[str] = []
+
+    def flush() -> None:
+        text = "\n".join(lines).strip()
+        # Skip heading-only sections (e.g. an empty "# Hardware Specifications")
+        if text and text != heading:
+            sections.append({"heading": heading, "text": text})
+
+    for line in body.splitlines():
+        if re.match(r"^#{1,6}\s", line):
+            flush()
+            heading = line.strip()
+            lines = [line]
+        else:
+            lines.append(line)
+    flush()
+
+    return sections
+
 
 class SkillRegistry:
     """
@@ -11,13 +72,27 @@ class SkillRegistry:
     Skills follow a format inspired by Claude Code's skill system:
     - Each skill lives in its own directory under skills_dir
     - Contains a SKILL.md file with YAML frontmatter (name, description)
+    - Optional frontmatter for local selection: keywords (list) and group
+      (skills in the same group are mutually exclusive, e.g. "framework")
+    - Optional frontmatter for retrieval: pinned (list of section headings
+      that are always injected, e.g. general coding rules)
     - The markdown body contains instructions/standards for the LLM
+
+    Parsed metadata, bodies and heading-level sections are kept in a
+    persistent JSON index keyed by relative path + mtime + size, so only
+    changed SKILL.md files are re-read.
+    The index is rewritten atomically and is safe to share between concurrent
+    runs and processes (a lost race just means one extra re-parse).
     """
 
-    def __init__(self, skills_dir: str = "./skills"):
+    def __init__(self, skills_dir: str = "./skills", index_path: Optional[str] = ".cache/skills_index.json"):
         self.skills_dir = Path(skills_dir)
+        self.index_path = Path(index_path) if index_path else None
         self.descriptions: Dict[str, str] = {}
-        self._cache: Dict[str, str] = {}
+        self.metadata: Dict[str, dict] = {}
+        self._entries: Dict[str, dict] = {}
+        self._index_stat: Optional[tuple] = None
+        self._lock = threading.Lock()
 
     def scan_skills(self) -> str:
         """
@@ -27,28 +102,127 @@ class SkillRegistry:
             Formatted string of skills for LLM context:
             "- skill_name: description\\n- skill_name2: description2"
         """
-        self.descriptions.clear()
+        with self._lock:
+            self._refresh()
+            descriptions = dict(self.descriptions)
+
+        return "\n".join(f"- {name}: {desc}" for name, desc in descriptions.items())
+
+    def _refresh(self) -> None:
+        """Bring the in-memory index up to date with the skills tree (lock held)."""
+        entries = self._load_index()
+        fresh: Dict[str, dict] = {}
+        changed = False
+
+        for skill_path in sorted(self.skills_dir.rglob("SKILL.md")):
+            rel_path = skill_path.relative_to(self.skills_dir).as_posix()
+            stat = skill_path.stat()
+            entry = entries.get(rel_path)
+
+            if entry and entry["mtime_ns"] == stat.st_mtime_ns and entry["size"] == stat.st_size:
+                fresh[rel_path] = entry
+                continue
+
+            meta, body = self._parse_skill_file(skill_path)
+            fresh[rel_path] = {
+                "mtime_ns": stat.st_mtime_ns,
+                "size": stat.st_size,
+                "dir_name": skill_path.parent.name,
+                "meta": meta,
+                "body": body,
+                "sections": split_sections(body),
+            }
+            changed = True
+
+        if changed or fresh.keys() != entries.keys():
+            self._save_index(fresh)
+
+        # Swap in fresh dicts so concurrent readers never see a half-built registry.
+        self._entries = fresh
+        self.metadata = {
+            entry["meta"]["name"]: entry["meta"]
+            for entry in fresh.values() if entry["meta"]
+        }
+        self.descriptions = {name: meta["description"] for name, meta in self.metadata.items()}
+
+    def _load_index(self) -> Dict[str, dict]:
+        """Return index entries, re-reading the sidecar only if another writer changed it."""
+        if not self.index_path:
+            return self._entries
+
+        try:
+            stat = self.index_path.stat()
+        except OSError:
+            return self._entries
+
+        index_stat = (stat.st_mtime_ns, stat.st_size)
+        if index_stat == self._index_stat:
+            return self._entries
+
+        try:
+            raw = json.loads(self.index_path.read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            return self._entries
 
-        for skill_path in self.skills_dir.rglob("SKILL.md"):
-            self._parse_skill_metadata(skill_path)
+        if raw.get("version") != INDEX_VERSION or raw.get("skills_dir") != str(self.skills_dir.resolve()):
+            return self._entries
 
-        return "\n".join(f"- {name}: {desc}" for name, desc in self.descriptions.items())
+        self._index_stat = index_stat
+        return raw.get("entries", {})
 
-    def _parse_skill_metadata(self, path: Path) -> None:
-        """Parse YAML frontmatter from a SKILL.md file."""
+    def _save_index(self, entries: Dict[str, dict]) -> None:
+        """Atomically write the index sidecar."""
+        if not self.index_path:
+            return
+
+        payload = {
+            "version": INDEX_VERSION,
+            "skills_dir": str(self.skills_dir.resolve()),
+            "entries": entries,
+        }
+        try:
+            self.index_path.parent.mkdir(parents=True, exist_ok=True)
+            fd, tmp_name = tempfile.mkstemp(dir=self.index_path.parent, suffix=".tmp")
+            with os.fdopen(fd, "w", encoding="utf-8") as tmp_file:
+                json.dump(payload, tmp_file)
+            os.replace(tmp_name, self.index_path)
+            stat = self.index_path.stat()
+            self._index_stat = (stat.st_mtime_ns, stat.st_size)
+        except OSError as e:
+            print(f"Warning: Failed to write skill index {self.index_path}: {e}")
+
+    def _parse_skill_file(self, path: Path) -> tuple[Optional[dict], str]:
+        """
+        Parse a SKILL.md file.
+
+        Returns:
+            (frontmatter metadata or None, markdown body without frontmatter)
+        """
+        meta = None
+        body = ""
         try:
             content = path.read_text()
             parts = content.split("---", 2)
 
+            # Return only the body (after frontmatter)
+            body = parts[-1].strip() if len(parts) >= 3 else content.strip()
+
             if len(parts) >= 3:
-                meta = yaml.safe_load(parts[1])
-                name = meta.get("name", path.parent.name)
-                desc = meta.get("description", "No description")
-                self.descriptions[name] = desc
+                raw_meta = yaml.safe_load(parts[1]) or {}
+                keywords: List[str] = raw_meta.get("keywords") or []
+                meta = {
+                    "name": raw_meta.get("name", path.parent.name),
+                    "description": raw_meta.get("description", "No description"),
+                    "keywords": [str(k) for k in keywords],
+                    "group": raw_meta.get("group"),
+                    "pinned": [str(h) for h in raw_meta.get("pinned") or []],
+                }
 
         except Exception as e:
             print(f"Warning: Failed to parse skill at {path}: {e}")
 
+        return meta, body
+
     def load_skill_content(self, skill_name: str) -> Optional[str]:
         """
         Load the markdown body content for a specific skill.
@@ -59,22 +233,161 @@ class SkillRegistry:
         Returns:
             The skill's instruction content (without frontmatter), or None if not found
         """
-        if skill_name in self._cache:
-            return self._cache[skill_name]
+        with self._lock:
+            self._refresh()
+            entries = list(self._entries.values())
+
+        entry = self._find_entry(entries, skill_name)
+        return entry["body"] if entry else None
+
+    @staticmethod
+    def _find_entry(entries: List[dict], skill_name: str) -> Optional[dict]:
+        """Find an index entry by frontmatter name, then by directory name."""
+        for entry in entries:
+            if entry["meta"] and entry["meta"]["name"] == skill_name:
+                return entry
+
+        for entry in entries:
+            if entry["dir_name"] == skill_name:
+                return entry
+
+        return None
+
+    def retrieve_skill_content(
+        self,
+        skill_names: list[str],
+        query: str,
+        top_k: int = 8,
+        token_budget: int = 2000,
+    ) -> tuple[str, str, dict]:
+        """
+        Inject only the skill sections most relevant to a query.
+
+        If all sections of the selected skills fit the token budget they are
+        injected unchanged. Otherwise pinned sections are injected first and
+        the remaining sections are ranked with BM25 against the query
+        (heading words weighted double); the best top_k that fit the budget
+        are added. Both parts keep the original document order.
+
+        The static part (every section, or only the pinned ones when ranking)
+        depends on the skill selection alone, so prompts can cache it across
+        tasks; the retrieved part depends on the query.
+
+        Args:
+            skill_names: Selected skill names
+            query: Requirements text
+            top_k: Maximum number of sections to inject
+            token_budget: Maximum estimated tokens of injected skill text
+
+        Returns:
+            (static skill content, retrieved skill content, retrieval stats); both contents with headers
+        """
+        with self._lock:
+            self._refresh()
+            entries = list(self._entries.values())
+
+        candidates = []  # (skill_name, position, section, terms)
+        pinned = set()
+        for name in skill_names:
+            entry = self._find_entry(entries, name)
+            if not entry:
+                continue
+            pinned_headings = set((entry["meta"] or {}).get("pinned", []))
+            for position, section in enumerate(entry.get("sections", [])):
+                terms = _tokenize(section["text"]) + _tokenize(section["heading"])
+                if section["heading"].lstrip("#").strip() in pinned_headings:
+                    pinned.add(len(candidates))
+                candidates.append((name, position, section, terms))
+
+        tokens_available = sum(estimate_tokens(c[2]["text"]) for c in candidates)
+        if tokens_available <= token_budget:
+            mode = "full"
+            chosen = set(range(len(candidates)))
+        else:
+            mode = "retrieval"
+            chosen = self._rank_sections(candidates, pinned, query, top_k, token_budget)
+
+        static = chosen if mode == "full" else chosen & pinned
+        content = self._join_sections(candidates, static)
+        retrieved = self._join_sections(candidates, chosen - static)
+
+        stats = {
+            "mode": mode,
+            "sections_total": len(candidates),
+            "sections_injected": len(chosen),
+            "sections_retrieved": len(chosen - static),
+            "tokens_available": tokens_available,
+            "tokens_injected": estimate_tokens(content) + estimate_tokens(retrieved),
+            "top_k": top_k,
+            "token_budget": token_budget,
+        }
+        return content, retrieved, stats
+
+    @staticmethod
+    def _join_sections(candidates: List[tuple], indices: set) -> str:
+        """Sections at indices in document order, grouped under their skill headers."""
+        grouped: Dict[str, List[str]] = {}
+        for index in sorted(indices):
+            name, _, section, _ = candidates[index]
+            grouped.setdefault(name, []).append(section["text"])
+        return "\n\n".join(
+            f"=== SKILL: {name} ===\n" + "\n\n".join(texts)
+            for name, texts in grouped.items()
+        )
+
+    @staticmethod
+    def _rank_sections(
+        candidates: List[tuple],
+        pinned: set,
+        query: str,
+        top_k: int,
+        token_budget: int,
+    ) -> set:
+        """Pick pinned sections plus the top_k BM25 matches that fit the budget."""
+        query_terms = set(_tokenize(query))
+        doc_freq: Dict[str, int] = {}
+        for *_, terms in candidates:
+            for term in set(terms):
+                doc_freq[term] = doc_freq.get(term, 0) + 1
 
-        skill_path = self.skills_dir / skill_name / "SKILL.md"
+        total = len(candidates)
+        avg_len = sum(len(c[3]) for c in candidates) / total if total else 0.0
+        k1, b = 1.2, 0.75
 
-        if not skill_path.exists():
-            return None
+        scored = []
+        for index, (*_, terms) in enumerate(candidates):
+            score = 0.0
+            for term in query_terms:
+                tf = terms.count(term)
+                if not tf:
+                    continue
+                idf = math.log(1 + (total - doc_freq[term] + 0.5) / (doc_freq[term] + 0.5))
+                score += idf * tf * (k1 + 1) / (tf + k1 * (1 - b + b * len(terms) / (avg_len or 1)))
+            if score > 0:
+                scored.append((score, index))
 
-        content = skill_path.read_text()
-        parts = content.split("---", 2)
+        chosen = set()
+        used_tokens = 0
+        for index in sorted(pinned):
+            tokens = estimate_tokens(candidates[index][2]["text"])
+            if used_tokens + tokens <= token_budget:
+                chosen.add(index)
+                used_tokens += tokens
 
-        # Return only the body (after frontmatter)
-        body = parts[-1].strip() if len(parts) >= 3 else content.strip()
-        self._cache[skill_name] = body
+        ranked = 0
+        for _, index in sorted(scored, key=lambda item: (-item[0], item[1])):
+            if ranked >= top_k:
+                break
+            if index in chosen:
+                continue
+            tokens = estimate_tokens(candidates[index][2]["text"])
+            if used_tokens + tokens > token_budget:
+                continue
+            chosen.add(index)
+            used_tokens += tokens
+            ranked += 1
 
-        return body
+        return chosen
 
     def get_combined_skill_content(self, skill_names: list[str]) -> str:
         """
@@ -0,0 +1,99 @@
+"""
+Inter-process file locks shared by build trees and other pooled resources.
+
+Uses fcntl.flock where available; on platforms without fcntl the locks fall
+back to in-process locking only.
+"""
+
+import threading
+from contextlib import contextmanager
+from pathlib import Path
+from typing import Dict, Iterator, List, Optional
+
+try:
+    import fcntl
+except ImportError:  # pragma: no cover - non-POSIX platforms
+    fcntl = None
+
+_process_locks: Dict[str, threading.Lock] = {}
+_process_locks_guard = threading.Lock()
+
+
+def _process_lock(path: Path) -> threading.Lock:
+    key = str(path.resolve())
+    with _process_locks_guard:
+        return _process_locks.setdefault(key, threading.Lock())
+
+
+class FileLock:
+    """An exclusive lock on a lock file, held until release()."""
+
+    def __init__(self, path: Path):
+        self.path = Path(path)
+        self.path.parent.mkdir(parents=True, exist_ok=True)
+        self._thread_lock = _process_lock(self.path)
+        self._file = None
+
+    def acquire(self, blocking: bool = True) -> bool:
+        """Acquire the lock; with blocking=False return False if it is held."""
+        if not self._thread_lock.acquire(blocking):
+            return False
+
+        if fcntl is None:
+            return True
+
+        self._file = self.path.open("a+")
+        flags = fcntl.LOCK_EX if blocking else fcntl.LOCK_EX | fcntl.LOCK_NB
+        try:
+            fcntl.flock(self._file.fileno(), flags)
+        except OSError:
+            self._file.close()
+            self._file = None
+            self._thread_lock.release()
+            return False
+        return True
+
+    def release(self) -> None:
+        if self._file is not None:
+            fcntl.flock(self._file.fileno(), fcntl.LOCK_UN)
+            self._file.close()
+            self._file = None
+        self._thread_lock.release()
+
+
+@contextmanager
+def lock_file(path: Path) -> Iterator[None]:
+    """Hold an exclusive lock on path for the duration of the block."""
+    lock = FileLock(path)
+    lock.acquire()
+    try:
+        yield
+    finally:
+        lock.release()
+
+
+@contextmanager
+def lease_any(paths: List[Path], fallback_index: int = 0) -> Iterator[int]:
+    """
+    Lock the first free path of a pool and yield its index.
+
+    Tries every path without blocking first; if all are busy, blocks on
+    paths[fallback_index % len(paths)].
+    """
+    lock: Optional[FileLock] = None
+    index = -1
+    for i, path in enumerate(paths):
+        candidate = FileLock(path)
+        if candidate.acquire(blocking=False):
+            lock, index = candidate, i
+            break
+
+    if lock is None:
+        index = fallback_index % len(paths)
+        lock = FileLock(paths[index])
+        lock.acquire()
+
+    try:
+        yield index
+    finally:
+        lock.release()
@@ -2,37 +2,107 @@
 Node implementations for the embedded code generation workflow.
 
 Nodes:
-- manager_node: Plans the project and selects relevant skills
+- manager_node / amanager_node: Plans the project and selects relevant skills
 - prepare_workspace_node: Prepares output directories before code generation
-- coder_node: Generates the main code file
-- diagram_node: Placeholder for future diagram generation
+- coder_node / acoder_node: Generates the main code file
+- diagram_node / adiagram_node: Generates a Wokwi wiring diagram (parallel to coder)
 - assemble_artifacts_node: Converts generated outputs into artifact list
+- lint_firmware_node: Checks interrupt-context code and requests repairs on violations
 - persist_node: Persists artifacts and run metadata to disk
+- build_verify_node: Compiles the persisted project and requests repairs on errors
+- benchmark_node: Flashes the build and measures it on the board
+- candidate_node / select_candidate_node: Multi-candidate generation (fan-out via fan_out_candidates)
 """
 
+import asyncio
+import difflib
+import functools
 import hashlib
 import json
 import os
 import re
 import time
-from datetime import datetime
+from datetime import datetime, timedelta
 from functools import lru_cache
 from pathlib import Path
-from typing import Any, List
+from typing import Any, Callable, List, Optional
 
+from langchain_core.messages import AIMessage
 from langchain_core.output_parsers import PydanticOutputParser
 from langchain_core.prompts import ChatPromptTemplate
 from langchain_openai import ChatOpenAI
+from langgraph.types import Send
 from pydantic import BaseModel, Field
 
-from src.loader import SkillRegistry
+from src.benchmark import instrument_artifacts, load_spec, run_benchmark
+from src.build import BuildResult, run_build
+from src.cache import ResponseCache
+from src.candidates import candidate_variants, rank_key, select, summarize
+from src.components import component_artifacts, component_sdkconfig
+from src.config import (
+    BenchmarkConfig,
+    BuildConfig,
+    CandidatesConfig,
+    DebugConfig,
+    IncrementalConfig,
+    LintConfig,
+    PromptCacheConfig,
+    SchedulerConfig,
+    StoreConfig,
+)
+from src.debuglog import append_entries, export_json
+from src.devices import DeviceError, DevicePool, NoDevicesError
+from src.lint import LintResult, lint_c, render_findings
+from src.loader import SkillRegistry, estimate_tokens
+from src.objects import ObjectStore, store_root
+from src.patch import PatchError, apply_unified_diff, extract_diff
+from src.placement import (
+    TaskPlacement,
+    apply_measured_stacks,
+    cores_for_target,
+    local_placement,
+    render_placement,
+    resolve_placement,
+)
+from src.profiles import PROFILES, render_sdkconfig_defaults, select_profile
+from src.scheduler import Scheduler, Target
+from src.runs import latest_benchmark, latest_successful_run
+from src.selector import select_skills
 from src.state import AgentState, Artifact, WorkspaceInfo
 
 registry = SkillRegistry()
+response_cache = ResponseCache()
 MODEL_NAME = "anthropic/claude-4.5-sonnet"
 MODEL_TEMPERATURE = 0.0
 MODEL_API_BASE = "https://openrouter.ai/api/v1"
 MODEL_API_KEY_ENV = "OPENAI_API_KEY"
+SCHEDULER_CONFIG = SchedulerConfig()
+PROMPT_CACHE_CONFIG = PromptCacheConfig()
+SCHEDULER = Scheduler()
+MANAGER_FAST_PATH = True
+MANAGER_MIN_CONFIDENCE = 0.75
+SKILL_RETRIEVAL = True
+SKILL_TOP_K = 8
+SKILL_TOKEN_BUDGET = 2000
+LINT_CONFIG = LintConfig()
+BUILD_CONFIG = BuildConfig()
+BENCHMARK_CONFIG = BenchmarkConfig()
+FIRMWARE_PROFILE = "auto"
+FIRMWARE_INSTRUMENT = False
+CANDIDATES_CONFIG = CandidatesConfig()
+INCREMENTAL_CONFIG = IncrementalConfig()
+DEBUG_CONFIG = DebugConfig()
+STORE_CONFIG = StoreConfig()
+
+# Boards for benchmarks; concurrent runs lease different boards.
+DEVICE_POOL = DevicePool([], BENCHMARK_CONFIG.lock_dir)
+
+INSTRUMENT_INSTRUCTIONS = (
+    "Instrumentation (mandatory): #include \"isr_probe.h\". Register one probe per interrupt handler "
+    "at init (int id = isr_probe_register(\"name\")), call isr_probe_enter(id) first and isr_probe_exit(id) "
+    "last in the handler, isr_probe_wake(id) in the consumer task right after its wait returns, and "
+    "isr_probe_start(1000) once at startup."
+)
 
 
 def configure_model(
@@ -52,11 +122,127 @@ def configure_model(
     MODEL_API_BASE = api_base
     MODEL_API_KEY_ENV = api_key_env
     get_model.cache_clear()
+    _fallback_model.cache_clear()
+
+
+def configure_prompt_cache(prompt_cache_config: PromptCacheConfig) -> None:
+    """Configure provider prompt-cache hints on the coder system prompt."""
+    global PROMPT_CACHE_CONFIG  # pylint: disable=global-statement
+    PROMPT_CACHE_CONFIG = prompt_cache_config
+
+
+def configure_scheduler(scheduler_config: SchedulerConfig, requests_per_min: int = 0) -> None:
+    """
+    Configure the LLM request scheduler (see src/scheduler.py).
+
+    requests_per_min > 0 rate-limits uncached LLM calls per endpoint.
+    """
+    global SCHEDULER_CONFIG, SCHEDULER  # pylint: disable=global-statement
+    SCHEDULER_CONFIG = scheduler_config
+    SCHEDULER = Scheduler(
+        requests_per_min=requests_per_min,
+        max_in_flight=scheduler_config.max_in_flight,
+        max_retries=scheduler_config.max_retries,
+        backoff_base_s=scheduler_config.backoff_base_s,
+        backoff_max_s=scheduler_config.backoff_max_s,
+        hedge=scheduler_config.hedge,
+        hedge_min_samples=scheduler_config.hedge_min_samples,
+    )
+    get_model.cache_clear()
+    _fallback_model.cache_clear()
+
+
+def configure_manager(fast_path: bool = True, min_confidence: float = 0.75) -> None:
+    """Configure the manager's local skill-selection fast path."""
+    global MANAGER_FAST_PATH, MANAGER_MIN_CONFIDENCE  # pylint: disable=global-statement
+    MANAGER_FAST_PATH = fast_path
+    MANAGER_MIN_CONFIDENCE = min_confidence
+
+
+def configure_skills(retrieval: bool = True, top_k: int = 8, token_budget: int = 2000) -> None:
+    """Configure how selected skill content is injected into the coder prompt."""
+    global SKILL_RETRIEVAL, SKILL_TOP_K, SKILL_TOKEN_BUDGET  # pylint: disable=global-statement
+    SKILL_RETRIEVAL = retrieval
+    SKILL_TOP_K = top_k
+    SKILL_TOKEN_BUDGET = token_budget
+
+
+def configure_debug(debug_config: DebugConfig) -> None:
+    """Configure the streaming debug log (debug.jsonl + blobs, optional debug.json export)."""
+    global DEBUG_CONFIG  # pylint: disable=global-statement
+    DEBUG_CONFIG = debug_config
+
+
+def configure_store(store_config: StoreConfig) -> None:
+    """Configure the content-addressed artifact store (tasks/.objects)."""
+    global STORE_CONFIG  # pylint: disable=global-statement
+    STORE_CONFIG = store_config
+
+
+def _object_store(state: AgentState) -> Optional[ObjectStore]:
+    """The run's object store, or None when disabled or the run has no task directory."""
+    if STORE_CONFIG.mode == "off" or not state.get("task_dir"):
+        return None
+    return ObjectStore(store_root(Path(state["task_dir"])))
+
+
+def configure_incremental(incremental_config: IncrementalConfig) -> None:
+    """Configure incremental (diff-based) regeneration against the last successful run."""
+    global INCREMENTAL_CONFIG  # pylint: disable=global-statement
+    INCREMENTAL_CONFIG = incremental_config
+
+
+def configure_lint(lint_config: LintConfig) -> None:
+    """Configure the interrupt-context lint (enable, repair budget)."""
+    global LINT_CONFIG  # pylint: disable=global-statement
+    LINT_CONFIG = lint_config
+
+
+def configure_candidates(candidates_config: CandidatesConfig) -> None:
+    """Configure multi-candidate generation (count, temperatures, skill variants)."""
+    global CANDIDATES_CONFIG  # pylint: disable=global-statement
+    CANDIDATES_CONFIG = candidates_config
+
+
+def configure_build(build_config: BuildConfig) -> None:
+    """Configure build verification (warm trees, repair budget)."""
+    global BUILD_CONFIG  # pylint: disable=global-statement
+    BUILD_CONFIG = build_config
+
+
+def configure_benchmark(benchmark_config: BenchmarkConfig) -> None:
+    """Configure the on-target benchmark (device pool, capture length, resolution)."""
+    global BENCHMARK_CONFIG, DEVICE_POOL  # pylint: disable=global-statement
+    BENCHMARK_CONFIG = benchmark_config
+    patterns = list(benchmark_config.ports) or ([benchmark_config.port] if benchmark_config.port else [])
+    DEVICE_POOL = DevicePool(patterns, Path(benchmark_config.lock_dir), max_failures=benchmark_config.max_failures)
+
+
+def configure_firmware(profile: str = "auto", instrument: bool = False) -> None:
+    """Configure the sdkconfig.defaults profile and isr_probe instrumentation of ESP-IDF projects."""
+    global FIRMWARE_PROFILE, FIRMWARE_INSTRUMENT  # pylint: disable=global-statement
+    FIRMWARE_PROFILE = profile
+    FIRMWARE_INSTRUMENT = instrument
+
+
+def configure_cache(enabled: bool = True, cache_dir: str = ".cache/llm") -> None:
+    """Configure the on-disk LLM response cache used by all LLM nodes."""
+    global response_cache  # pylint: disable=global-statement
+    response_cache = ResponseCache(cache_dir=cache_dir, enabled=enabled)
 
 
 @lru_cache(maxsize=1)
 def get_model() -> ChatOpenAI:
     """Return a cached LLM instance configured from runtime settings."""
+    return _create_model(MODEL_TEMPERATURE)
+
+
+def _create_model(temperature: float, model_name: Optional[str] = None, api_base: Optional[str] = None) -> ChatOpenAI:
+    """
+    Create an LLM instance from runtime settings at the given temperature.
+
+    Retries are left to the scheduler (max_retries=0 on the client).
+    """
     api_key = os.environ.get(MODEL_API_KEY_ENV) or os.environ.get("OPENROUTER_API_KEY")
     if not api_key:
         raise ValueError(
@@ -64,29 +250,233 @@ def get_model() -> ChatOpenAI:
         )
 
     return ChatOpenAI(
-        model=MODEL_NAME,
+        model=model_name or MODEL_NAME,
         openai_api_key=api_key,
-        openai_api_base=MODEL_API_BASE,
-        temperature=MODEL_TEMPERATURE,
+        openai_api_base=api_base or MODEL_API_BASE,
+        temperature=temperature,
+        stream_usage=True,
+        max_retries=0,
+        timeout=SCHEDULER_CONFIG.timeout_s,
     )
 
 
+@lru_cache(maxsize=4)
+def _fallback_model(temperature: float) -> Optional[ChatOpenAI]:
+    """The scheduler's fallback model at the given temperature, if configured."""
+    if not SCHEDULER_CONFIG.fallback_model:
+        return None
+    return _create_model(temperature, SCHEDULER_CONFIG.fallback_model, SCHEDULER_CONFIG.fallback_api_base or None)
+
+
+def _targets(llm: ChatOpenAI) -> List[Target]:
+    """Scheduler targets for a call: the model itself, then the fallback model."""
+    targets = [Target(llm.model_name, getattr(llm, "openai_api_base", None) or MODEL_API_BASE, llm)]
+    fallback = _fallback_model(llm.temperature)
+    if fallback is not None and fallback.model_name != llm.model_name:
+        targets.append(Target(fallback.model_name, fallback.openai_api_base or MODEL_API_BASE, fallback))
+    return targets
+
+
 def create_debug_log(
     node: str,
     input_messages: Any,
     output: Any,
     duration_ms: float,
     metadata: dict = None,
+    metrics: dict = None,
 ) -> dict:
     """Create a debug log entry for an LLM call."""
+    finished_at = datetime.now()
     return {
         "node": node,
-        "timestamp": datetime.now().isoformat(),
+        "started_at": (finished_at - timedelta(milliseconds=duration_ms)).isoformat(),
+        "timestamp": finished_at.isoformat(),
         "duration_ms": round(duration_ms, 2),
         "input": input_messages,
         "output": output,
         "metadata": metadata or {},
+        "metrics": metrics or {},
+    }
+
+
+def _sink_update(state: AgentState, update: Any) -> Any:
+    """Append a node update's debug entries to the run's debug.jsonl; keep the compacted ones in state."""
+    if isinstance(update, dict) and update.get("debug_logs"):
+        run_path = Path(state.get("run_dir", "./output"))
+        update = {**update, "debug_logs": append_entries(run_path, update["debug_logs"], DEBUG_CONFIG.blob_min_chars)}
+    return update
+
+
+def with_debug_sink(node: Callable) -> Callable:
+    """
+    Wrap a graph node so its debug entries are streamed to disk as soon as it finishes.
+
+    See src/debuglog.py; works for sync and async nodes. Updates that are not
+    plain dicts (e.g. Send lists) pass through unchanged.
+    """
+    if asyncio.iscoroutinefunction(node):
+        @functools.wraps(node)
+        async def async_wrapper(state: AgentState):
+            return _sink_update(state, await node(state))
+        return async_wrapper
+
+    @functools.wraps(node)
+    def wrapper(state: AgentState):
+        return _sink_update(state, node(state))
+    return wrapper
+
+
+def _usage_metrics(message: Any) -> dict:
+    """Extract prompt/completion (and prompt-cache) token counts from an AI message, if reported."""
+    usage = getattr(message, "usage_metadata", None) or {}
+    details = usage.get("input_token_details") or {}
+    return {
+        "prompt_tokens": usage.get("input_tokens"),
+        "completion_tokens": usage.get("output_tokens"),
+        # Provider prompt-cache reads/writes (subset of prompt_tokens), when reported
+        "cached_tokens": details.get("cache_read"),
+        "cache_creation_tokens": details.get("cache_creation"),
+    }
+
+
+def _cache_lookup(llm: ChatOpenAI, messages: Any) -> tuple[Optional[str], Optional[tuple[Any, dict]]]:
+    """
+    Look up a response in the cache.
+
+    Returns:
+        (cache key or None if uncacheable, (message, metrics) on hit else None)
+    """
+    key = response_cache.make_key(llm.model_name, llm.temperature, messages)
+    if key is None:
+        return None, None
+
+    record = response_cache.get(key)
+    if record is None:
+        return key, None
+
+    usage = record.get("usage", {})
+    metrics = {
+        "prompt_tokens": usage.get("prompt_tokens"),
+        "completion_tokens": usage.get("completion_tokens"),
+        "cache": "hit",
+        "cache_key": key,
     }
+    return key, (AIMessage(content=record["content"]), metrics)
+
+
+def _cache_store(key: Optional[str], response: Any, metrics: dict) -> None:
+    """Store a fresh response in the cache and tag the metrics."""
+    if key is None:
+        metrics["cache"] = "off"
+        return
+
+    response_cache.put(
+        key,
+        response.content,
+        usage={
+            "prompt_tokens": metrics.get("prompt_tokens"),
+            "completion_tokens": metrics.get("completion_tokens"),
+        },
+    )
+    metrics["cache"] = "miss"
+    metrics["cache_key"] = key
+
+
+def _scheduled_metrics(metrics: dict, target: Target, events: List[dict]) -> dict:
+    """Record which model answered and the scheduler's decisions."""
+    metrics["model"] = target.model
+    metrics["scheduler"] = events
+    return metrics
+
+
+def invoke_llm(llm: ChatOpenAI, messages: Any) -> tuple[Any, dict]:
+    """
+    Invoke the LLM synchronously, serving deterministic calls from the cache.
+
+    Uncached calls go through the scheduler (rate limit, retries, hedging,
+    fallback model); fallback answers are not cached under the primary key.
+
+    Returns:
+        (response message, metrics dict with token counts, cache status and scheduler events)
+    """
+    key, cached = _cache_lookup(llm, messages)
+    if cached:
+        return cached
+
+    response, target, events = SCHEDULER.invoke(_targets(llm), lambda model: model.invoke(messages))
+    metrics = _scheduled_metrics(_usage_metrics(response), target, events)
+    _cache_store(key if target.llm is llm else None, response, metrics)
+    return response, metrics
+
+
+async def astream_llm(
+    llm: ChatOpenAI,
+    messages: Any,
+    on_token: Optional[Callable[[str], None]] = None,
+) -> tuple[Any, dict]:
+    """
+    Stream an LLM response and measure time-to-first-token and generation speed.
+
+    Deterministic calls are served from the cache; on a hit the whole cached
+    response is delivered to on_token at once. Uncached streams are opened
+    through the scheduler (see invoke_llm); ttft_ms includes its waits.
+
+    Args:
+        llm: Chat model
+        messages: Prompt messages
+        on_token: Optional callback receiving each non-empty content delta
+
+    Returns:
+        (aggregated response message, metrics dict)
+    """
+    key, cached = _cache_lookup(llm, messages)
+    if cached:
+        if on_token and cached[0].content:
+            on_token(cached[0].content)
+        return cached
+
+    start_time = time.perf_counter()
+    first_token_time = None
+    response = None
+
+    prefix, stream, target, events = await SCHEDULER.astream(_targets(llm), lambda model: model.astream(messages))
+    try:
+        if prefix is not None:
+            response = prefix
+            if prefix.content:
+                first_token_time = time.perf_counter()
+                if on_token:
+                    on_token(prefix.content)
+        async for chunk in stream:
+            response = chunk if response is None else response + chunk
+            if chunk.content:
+                if first_token_time is None:
+                    first_token_time = time.perf_counter()
+                if on_token:
+                    on_token(chunk.content)
+    finally:
+        SCHEDULER.finish(target)
+
+    end_time = time.perf_counter()
+    if response is None:
+        raise ValueError("LLM stream returned no chunks.")
+
+    metrics = _scheduled_metrics(_usage_metrics(response), target, events)
+    first_token_time = first_token_time or end_time
+    generation_s = end_time - first_token_time
+    completion_tokens = metrics.get("completion_tokens")
+
+    metrics.update({
+        "streamed": True,
+        "ttft_ms": round((first_token_time - start_time) * 1000, 2),
+        "generation_ms": round(generation_s * 1000, 2),
+        "tokens_per_s": (
+            round(completion_tokens / generation_s, 2)
+            if completion_tokens and generation_s > 0 else None
+        ),
+    })
+    _cache_store(key if target.llm is llm else None, response, metrics)
+    return response, metrics
 
 
 def extract_clean_code(raw_text: str) -> str:
@@ -139,19 +529,88 @@ class ProjectPlan(BaseModel):
     selected_skills: List[str] = Field(
         ..., description="List of relevant skill names (e.g., ['esp-idf', 'arduino'])"
     )
+    task_placement: Optional[TaskPlacement] = Field(
+        None, description="FreeRTOS task-to-core placement (ESP-IDF projects only)"
+    )
 
 
 # --- Nodes ---
 
 
-def manager_node(state: AgentState) -> dict:
+def _skill_context(skill_names: List[str], requirements: str) -> tuple[str, str, dict]:
     """
-    Plan the project by analyzing requirements and selecting skills.
+    Build the skill blocks for the coder prompt, with injected-token stats (skills in name order).
 
-    Reads: requirements
-    Writes: project_name, active_skills, active_skill_content, debug_logs
+    Returns (static content, requirement-specific retrieved content, stats).
     """
-    llm = get_model()
+    skill_names = sorted(skill_names)
+    if SKILL_RETRIEVAL:
+        return registry.retrieve_skill_content(
+            skill_names, requirements, top_k=SKILL_TOP_K, token_budget=SKILL_TOKEN_BUDGET
+        )
+
+    content = registry.get_combined_skill_content(skill_names)
+    return content, "", {"mode": "combined", "tokens_injected": estimate_tokens(content)}
+
+
+def _local_plan(state: AgentState) -> tuple[Optional[dict], dict]:
+    """
+    Try the local keyword selector before calling the LLM planner.
+
+    Returns:
+        (state update if confident enough else None, selection info for logging)
+    """
+    if not MANAGER_FAST_PATH:
+        return None, {"path": "llm"}
+
+    start_time = time.time()
+    registry.scan_skills()
+    selection = select_skills(
+        state["requirements"], registry.metadata, task_name=state.get("task_name")
+    )
+    duration_ms = (time.time() - start_time) * 1000
+
+    info = {
+        "local_confidence": selection.confidence,
+        "local_scores": selection.scores,
+        "min_confidence": MANAGER_MIN_CONFIDENCE,
+    }
+    if selection.confidence < MANAGER_MIN_CONFIDENCE:
+        return None, {"path": "llm", **info}
+
+    skill_content, retrieved_content, skill_stats = _skill_context(selection.skills, state["requirements"])
+
+    # The planner would declare a placement for ESP-IDF projects; derive one locally.
+    task_placement = None
+    if "arduino" not in selection.skills:
+        placement = local_placement(state["requirements"], cores_for_target(BUILD_CONFIG.idf_target))
+        task_placement = {**placement.model_dump(), "source": "local"}
+
+    debug_log = create_debug_log(
+        node="manager",
+        input_messages={"user": state["requirements"]},
+        output={
+            "project_name": selection.project_name,
+            "selected_skills": selection.skills,
+            "task_placement": task_placement,
+        },
+        duration_ms=duration_ms,
+        metadata={"path": "local", **info, "skill_context": skill_stats},
+    )
+
+    return {
+        "project_name": selection.project_name,
+        "active_skills": selection.skills,
+        "task_placement": task_placement,
+        "active_skill_content": skill_content,
+        "retrieved_skill_content": retrieved_content,
+        "skill_context_stats": skill_stats,
+        "debug_logs": [debug_log],
+    }, info
+
+
+def _build_manager_request(state: AgentState) -> tuple[ChatPromptTemplate, PydanticOutputParser, dict, str]:
+    """Build the planner prompt, parser and input variables for the manager."""
     available_skills = registry.scan_skills()
 
     parser = PydanticOutputParser(pydantic_object=ProjectPlan)
@@ -162,7 +621,10 @@ def manager_node(state: AgentState) -> dict:
                 "system",
                 "You are a Project Planner. Analyze the request and output a JSON plan.\n"
                 "1. Use snake_case for the project_name.\n"
-                "2. Select relevant skills ONLY from the AVAILABLE SKILLS list.\n\n"
+                "2. Select relevant skills ONLY from the AVAILABLE SKILLS list.\n"
+                "3. For ESP-IDF projects, declare task_placement: the GPIO ISR service and "
+                "time-critical event consumers pinned to isr_core (1), logging/network/"
+                "housekeeping tasks on core 0, time-critical tasks at higher priorities.\n\n"
                 "AVAILABLE SKILLS:\n{skills}\n\n"
                 "{format_instructions}",
             ),
@@ -170,66 +632,167 @@ def manager_node(state: AgentState) -> dict:
         ]
     )
 
-    chain = prompt | llm | parser
-
     input_data = {
         "skills": available_skills,
         "format_instructions": parser.get_format_instructions(),
         "request": state["requirements"],
     }
 
+    return prompt, parser, input_data, available_skills
+
+
+def _parse_plan(parser: PydanticOutputParser, response: Any, metrics: dict) -> ProjectPlan:
+    """Parse the planner output, evicting unparseable responses from the cache."""
+    try:
+        return parser.parse(response.content)
+    except Exception:
+        response_cache.evict(metrics.get("cache_key"))
+        raise
+
+
+def _manager_result(
+    state: AgentState,
+    prompt: ChatPromptTemplate,
+    available_skills: str,
+    plan: ProjectPlan,
+    duration_ms: float,
+    metrics: dict = None,
+    selection_info: dict = None,
+) -> dict:
+    """Build the manager state update for a successful plan."""
+    skill_content, retrieved_content, skill_stats = _skill_context(plan.selected_skills, state["requirements"])
+
+    debug_log = create_debug_log(
+        node="manager",
+        input_messages={
+            "system": prompt.messages[0].prompt.template,
+            "user": state["requirements"],
+            "available_skills": available_skills,
+        },
+        output=plan.model_dump(),
+        duration_ms=duration_ms,
+        metadata={
+            "parser": "PydanticOutputParser",
+            "schema": "ProjectPlan",
+            **(selection_info or {"path": "llm"}),
+            "skill_context": skill_stats,
+        },
+        metrics=metrics,
+    )
+
+    return {
+        "project_name": plan.project_name,
+        "active_skills": plan.selected_skills,
+        "task_placement": plan.task_placement.model_dump() if plan.task_placement else None,
+        "active_skill_content": skill_content,
+        "retrieved_skill_content": retrieved_content,
+        "skill_context_stats": skill_stats,
+        "debug_logs": [debug_log],
+    }
+
+
+def _manager_fallback(
+    state: AgentState,
+    error: Exception,
+    duration_ms: float,
+    selection_info: dict = None,
+) -> dict:
+    """Build the manager state update used when planning fails."""
+    debug_log = create_debug_log(
+        node="manager",
+        input_messages={"request": state["requirements"]},
+        output={"error": str(error)},
+        duration_ms=duration_ms,
+        metadata={"status": "fallback", **(selection_info or {"path": "llm"})},
+    )
+
+    return {
+        "project_name": "esp32_fallback",
+        "active_skills": ["esp-idf"],
+        "active_skill_content": "Use standard ESP-IDF best practices.",
+        "retrieved_skill_content": None,
+        "debug_logs": [debug_log],
+    }
+
+
+def manager_node(state: AgentState) -> dict:
+    """
+    Plan the project by analyzing requirements and selecting skills.
+
+    Confident local keyword matches skip the LLM round-trip entirely; the
+    task placement is then derived locally (source "local").
+
+    Reads: requirements, task_name
+    Writes: project_name, active_skills, task_placement, active_skill_content, retrieved_skill_content,
+        debug_logs
+    """
+    local_result, selection_info = _local_plan(state)
+    if local_result:
+        return local_result
+
+    llm = get_model()
+    prompt, parser, input_data, available_skills = _build_manager_request(state)
+
     start_time = time.time()
 
     try:
-        plan: ProjectPlan = chain.invoke(input_data)
+        response, metrics = invoke_llm(llm, prompt.format_messages(**input_data))
+        plan = _parse_plan(parser, response, metrics)
         duration_ms = (time.time() - start_time) * 1000
 
-        skill_content = registry.get_combined_skill_content(plan.selected_skills)
-
-        debug_log = create_debug_log(
-            node="manager",
-            input_messages={
-                "system": prompt.messages[0].prompt.template,
-                "user": state["requirements"],
-                "available_skills": available_skills,
-            },
-            output=plan.model_dump(),
-            duration_ms=duration_ms,
-            metadata={"parser": "PydanticOutputParser", "schema": "ProjectPlan"},
+        return _manager_result(
+            state, prompt, available_skills, plan, duration_ms, metrics, selection_info
         )
 
-        return {
-            "project_name": plan.project_name,
-            "active_skills": plan.selected_skills,
-            "active_skill_content": skill_content,
-            "debug_logs": [debug_log],
-        }
-
     except Exception as e:
         duration_ms = (time.time() - start_time) * 1000
+        return _manager_fallback(state, e, duration_ms, selection_info)
+
 
-        debug_log = create_debug_log(
-            node="manager",
-            input_messages={"request": state["requirements"]},
-            output={"error": str(e)},
-            duration_ms=duration_ms,
-            metadata={"status": "fallback"},
+async def amanager_node(state: AgentState) -> dict:
+    """
+    Async, streaming variant of manager_node.
+
+    Reads: requirements, task_name
+    Writes: project_name, active_skills, active_skill_content, retrieved_skill_content, debug_logs
+    """
+    local_result, selection_info = _local_plan(state)
+    if local_result:
+        return local_result
+
+    llm = get_model()
+    prompt, parser, input_data, available_skills = _build_manager_request(state)
+
+    start_time = time.time()
+
+    try:
+        response, metrics = await astream_llm(llm, prompt.format_messages(**input_data))
+        plan = _parse_plan(parser, response, metrics)
+        duration_ms = (time.time() - start_time) * 1000
+
+        return _manager_result(
+            state, prompt, available_skills, plan, duration_ms, metrics, selection_info
         )
 
-        return {
-            "project_name": "esp32_fallback",
-            "active_skills": ["esp-idf"],
-            "active_skill_content": "Use standard ESP-IDF best practices.",
-            "debug_logs": [debug_log],
-        }
+    except Exception as e:
+        duration_ms = (time.time() - start_time) * 1000
+        return _manager_fallback(state, e, duration_ms, selection_info)
 
 
 def prepare_workspace_node(state: AgentState) -> dict:
     """
     Prepare output folders and target code file path before code generation.
 
-    Reads: run_dir, project_name, active_skills
-    Writes: prepared_output_dir, prepared_code_path, active_platform
+    Also validates the manager's task placement plan (default plan if missing
+    or invalid) so the coder only ever sees a consistent one. With the static
+    profile, planned stacks are resized from the task's last benchmark.
+
+    With incremental mode, the newest successful run of the task becomes the
+    base_run the coder edits, unless its requirements differ too much.
+
+    Reads: run_dir, task_dir, project_name, active_skills, requirements, task_placement
+    Writes: prepared_output_dir, prepared_code_path, active_platform, firmware_profile,
+        task_placement, workspace, base_run
     """
     project_name = state.get("project_name", "embedded_project")
     active_skills = state.get("active_skills", [])
@@ -242,11 +805,25 @@ def prepare_workspace_node(state: AgentState) -> dict:
     if "arduino" in active_skills:
         code_path = output_dir / f"{project_name}.ino"
         active_platform = "arduino"
+        firmware_profile = None
+        task_placement = None
     else:
         main_dir = output_dir / "main"
         main_dir.mkdir(parents=True, exist_ok=True)
         code_path = main_dir / "main.c"
         active_platform = "esp-idf"
+        firmware_profile = select_profile(state.get("requirements", ""), FIRMWARE_PROFILE)
+        placement, issues = resolve_placement(
+            state.get("task_placement"), cores_for_target(BUILD_CONFIG.idf_target)
+        )
+        task_placement = {**placement, "issues": issues}
+
+        # Static allocation: size stacks from the last measured high-water marks.
+        if firmware_profile == "static" and state.get("task_dir"):
+            measured = latest_benchmark(Path(state["task_dir"]), "stack", exclude=run_path)
+            if measured:
+                task_placement, resized = apply_measured_stacks(task_placement, measured["stack"])
+                task_placement["measured_stacks"] = resized
 
     workspace: WorkspaceInfo = {
         "output_root": str(output_dir),
@@ -254,74 +831,400 @@ def prepare_workspace_node(state: AgentState) -> dict:
         "project_name": project_name,
     }
 
+    # Incremental mode: edit the last successful run's code if the prompt is close enough.
+    base_run = None
+    if INCREMENTAL_CONFIG.enabled and CANDIDATES_CONFIG.count == 1 and state.get("task_dir"):
+        base_run = latest_successful_run(Path(state["task_dir"]), active_platform, exclude=run_path)
+        if base_run:
+            similarity = difflib.SequenceMatcher(
+                None, base_run["requirements"], state.get("requirements", "")
+            ).ratio()
+            base_run["similarity"] = round(similarity, 4)
+            if similarity < INCREMENTAL_CONFIG.min_similarity:
+                base_run = None
+
     return {
         "prepared_output_dir": str(output_dir),
         "prepared_code_path": str(code_path),
         "active_platform": active_platform,
+        "firmware_profile": firmware_profile,
+        "task_placement": task_placement,
         "workspace": workspace,
+        "base_run": base_run,
     }
 
 
-def coder_node(state: AgentState) -> dict:
+def _system_message(prefix: str, suffix: str) -> tuple:
     """
-    Generate the main code file based on requirements and skill standards.
+    System message whose static prefix is marked for provider prompt caching.
 
-    Reads: requirements, project_name, active_skill_content
-    Writes: code_content, messages, active_skills, debug_logs
+    With hints enabled (prompt_cache.hints; "auto" = Claude models) the content
+    is sent as two text blocks, the first carrying an Anthropic-style
+    cache_control breakpoint, which OpenAI-compatible gateways such as
+    LiteLLM pass through; otherwise it is one string (providers with
+    automatic prefix caching still reuse the stable prefix).
     """
-    llm = get_model()
+    hints = PROMPT_CACHE_CONFIG.hints
+    if hints == "never" or (hints == "auto" and not re.search(r"claude|anthropic", MODEL_NAME, re.IGNORECASE)):
+        return ("system", f"{prefix}\n{suffix}")
+    return (
+        "system",
+        [
+            {"type": "text", "text": prefix, "cache_control": {"type": "ephemeral"}},
+            {"type": "text", "text": suffix},
+        ],
+    )
+
 
+def _build_coder_messages(state: AgentState) -> tuple[str, list]:
+    """
+    Build the coder system prompt and message list.
+
+    The system prompt is laid out for provider prompt caching: role, rules and
+    the static skill block (all sections of the selected skills, or only their
+    pinned sections when retrieval ranks them; skills ordered by name) form a
+    prefix shared by every run with the same skill selection. The sections
+    retrieved for this task's requirements, project, profile, placement and
+    the output format follow it (see _system_message).
+    """
     skill_instructions = state.get("active_skill_content") or "No specific standards."
+    retrieved = state.get("retrieved_skill_content")
+    retrieved_block = (
+        f"=== RELEVANT SKILL SECTIONS ===\n{retrieved}\n============================\n\n" if retrieved else ""
+    )
     project_name = state.get("project_name", "embedded_project")
-    active_skills = state.get("active_skills", [])
+    profile = state.get("firmware_profile")
+    profile_line = f"\nBuild profile: {profile} ({PROFILES[profile]['summary']})\n" if profile else ""
+    if profile and PROFILES[profile].get("instructions"):
+        profile_line += f"{PROFILES[profile]['instructions']}\n"
+    if FIRMWARE_INSTRUMENT and _get_workspace(state)["target"] == "esp-idf":
+        profile_line += f"{INSTRUMENT_INSTRUCTIONS}\n"
+    placement = state.get("task_placement")
+    placement_block = f"\n{render_placement(placement, profile)}\n" if placement else ""
+
+    feedback = state.get("repair_feedback")
+    base_run = state.get("base_run")
+    incremental = bool(base_run) and not feedback
+    if incremental:
+        output_rule = (
+            f"Output ONLY a unified diff of {base_run['path']} (inside ```diff wrapper): "
+            "--- / +++ headers and @@ hunks with 3 lines of unchanged context; do not repeat unchanged code."
+        )
+    else:
+        output_rule = "Output ONLY the code block (inside ```c wrapper)."
 
-    system_prompt = f"""You are an expert Embedded Engineer. Generate ONLY the code for main.c or *.ino file.
+    # Static prefix first (identical across tasks that share a skill selection), per-task parts after it.
+    prefix = f"""You are an expert Embedded Engineer. Generate ONLY the code for main.c or *.ino file.
 
-Target Project: {project_name}
+RULES:
+1. Do NOT ask clarifying questions. Make reasonable engineering assumptions.
+2. Include all necessary headers based on the requirements.
+3. Use reasonable GPIO pins if not specified.
 
 === APPLICABLE STANDARDS ===
 {skill_instructions}
 ============================
-
+"""
+    suffix = f"""{retrieved_block}Target Project: {project_name}
+{profile_line}{placement_block}
 Task: Write the main C/C++ code file.
+Output: {output_rule}"""
+    system_prompt = f"{prefix}\n{suffix}"
+    system_message = _system_message(prefix, suffix)
+
+    if incremental:
+        requirements_diff = "\n".join(difflib.unified_diff(
+            base_run["requirements"].splitlines(),
+            state["requirements"].splitlines(),
+            "previous requirements",
+            "current requirements",
+            lineterm="",
+        ))
+        return system_prompt, [
+            system_message,
+            (
+                "user",
+                f"Current requirements:\n{state['requirements']}\n\n"
+                f"They changed from the previous, verified version as follows:\n{requirements_diff}\n\n"
+                f"Previous {base_run['path']}:\n```c\n{base_run['code']}\n```\n\n"
+                "Update the code for the requirement changes with a minimal diff.",
+            ),
+        ]
 
-RULES:
-1. Do NOT ask clarifying questions. Make reasonable engineering assumptions.
-2. Output ONLY the code block (inside ```c wrapper).
-3. Include all necessary headers based on the requirements.
-4. Use reasonable GPIO pins if not specified."""
+    messages = [system_message, ("user", state["requirements"])]
 
-    messages = [("system", system_prompt), ("user", state["requirements"])]
+    # Repair iteration: show the previous attempt and what was wrong with it.
+    if feedback and state.get("code_content"):
+        messages.append(("assistant", state["code_content"]))
+        messages.append((
+            "user",
+            "The previous code failed verification:\n\n"
+            f"{feedback}\n\n"
+            "Fix every issue and output the complete corrected file.",
+        ))
 
-    start_time = time.time()
-    response = llm.invoke(messages)
-    duration_ms = (time.time() - start_time) * 1000
+    return system_prompt, messages
+
+
+def _coder_result(
+    state: AgentState,
+    system_prompt: str,
+    response: Any,
+    duration_ms: float,
+    metrics: dict = None,
+) -> dict:
+    """Build the coder state update from an LLM response."""
+    project_name = state.get("project_name", "embedded_project")
+    active_skills = state.get("active_skills", [])
+
+    input_messages = {
+        "system": system_prompt,
+        "user": state["requirements"],
+    }
+    if state.get("repair_feedback"):
+        input_messages["repair_feedback"] = state["repair_feedback"]
+    mode = "diff" if state.get("base_run") and not state.get("repair_feedback") else "full"
 
     debug_log = create_debug_log(
         node="coder",
-        input_messages={
-            "system": system_prompt,
-            "user": state["requirements"],
-        },
+        input_messages=input_messages,
         output=response.content,
         duration_ms=duration_ms,
         metadata={
             "project_name": project_name,
             "active_skills": active_skills,
+            "skill_tokens": (state.get("skill_context_stats") or {}).get("tokens_injected"),
+            "repair_attempt": state.get("repair_attempts", 0),
+            "mode": mode,
         },
+        metrics=metrics,
     )
 
     return {
-        "code_content": response.content,
+        "code_content": None if mode == "diff" else response.content,
+        "code_patch": response.content if mode == "diff" else None,
         "messages": [response],
         "active_skills": active_skills,
+        "repair_feedback": None,
         "debug_logs": [debug_log],
     }
 
 
-def diagram_node(state: AgentState) -> dict:  # noqa: ARG001  # pylint: disable=unused-argument
-    """Placeholder for future diagram generation."""
-    return {"diagram_content": ""}
+def _reuse_base_run(state: AgentState) -> Optional[dict]:
+    """Coder result reusing the base run's code unchanged when the requirements did not change."""
+    base_run = state.get("base_run")
+    if not base_run or state.get("repair_feedback") or base_run["requirements"].strip() != state["requirements"].strip():
+        return None
+
+    debug_log = create_debug_log(
+        node="coder",
+        input_messages={"base_run": base_run["run_dir"]},
+        output=base_run["code"],
+        duration_ms=0.0,
+        metadata={"mode": "reuse", "base_sha256": base_run["sha256"]},
+    )
+    return {
+        "code_content": f"```c\n{base_run['code']}\n```",
+        "code_patch": None,
+        "active_skills": state.get("active_skills", []),
+        "repair_feedback": None,
+        "debug_logs": [debug_log],
+    }
+
+
+def coder_node(state: AgentState) -> dict:
+    """
+    Generate the main code file based on requirements and skill standards.
+
+    With a base_run (incremental mode) the response is a diff (code_patch),
+    applied by assemble_artifacts; unchanged requirements reuse its code as-is.
+
+    Reads: requirements, project_name, active_skill_content, retrieved_skill_content, repair_feedback, base_run
+    Writes: code_content, code_patch, messages, active_skills, repair_feedback, debug_logs
+    """
+    reused = _reuse_base_run(state)
+    if reused:
+        return reused
+
+    llm = get_model()
+    system_prompt, messages = _build_coder_messages(state)
+
+    start_time = time.time()
+    response, metrics = invoke_llm(llm, messages)
+    duration_ms = (time.time() - start_time) * 1000
+
+    return _coder_result(state, system_prompt, response, duration_ms, metrics)
+
+
+async def acoder_node(state: AgentState) -> dict:
+    """
+    Async, streaming variant of coder_node.
+
+    Tokens are appended to "<prepared_code_path>.partial" as they arrive so a
+    long generation can be inspected (or salvaged) before it completes. The
+    partial file is removed once the full response has been received.
+
+    Reads: requirements, project_name, active_skill_content, retrieved_skill_content, prepared_code_path,
+        repair_feedback, base_run
+    Writes: code_content, code_patch, messages, active_skills, repair_feedback, debug_logs
+    """
+    reused = _reuse_base_run(state)
+    if reused:
+        return reused
+
+    llm = get_model()
+    system_prompt, messages = _build_coder_messages(state)
+
+    partial_path = None
+    if state.get("prepared_code_path"):
+        partial_path = Path(f"{state['prepared_code_path']}.partial")
+        partial_path.parent.mkdir(parents=True, exist_ok=True)
+
+    start_time = time.time()
+    if partial_path:
+        with partial_path.open("w", encoding="utf-8") as partial_file:
+            def write_token(token: str) -> None:
+                partial_file.write(token)
+                partial_file.flush()
+
+            response, metrics = await astream_llm(llm, messages, on_token=write_token)
+        partial_path.unlink(missing_ok=True)
+    else:
+        response, metrics = await astream_llm(llm, messages)
+    duration_ms = (time.time() - start_time) * 1000
+
+    return _coder_result(state, system_prompt, response, duration_ms, metrics)
+
+
+def extract_diagram_json(raw_text: str) -> str:
+    """
+    Extract and validate a Wokwi diagram.json document from an LLM response.
+
+    Returns:
+        Pretty-printed JSON string
+
+    Raises:
+        ValueError: If no valid diagram with a parts list is found
+    """
+    match = re.search(r"```(?:json)?\n(.*?)```", raw_text, re.DOTALL)
+    if match:
+        candidate = match.group(1)
+    else:
+        start, end = raw_text.find("{"), raw_text.rfind("}")
+        candidate = raw_text[start:end + 1] if start != -1 and end > start else raw_text
+
+    diagram = json.loads(candidate)
+    if not isinstance(diagram, dict) or not isinstance(diagram.get("parts"), list):
+        raise ValueError("Diagram JSON must be an object with a 'parts' list.")
+    diagram.setdefault("connections", [])
+
+    return json.dumps(diagram, indent=2)
+
+
+def _build_diagram_messages(state: AgentState) -> tuple[str, list]:
+    """Build the diagram system prompt and message list."""
+    active_skills = state.get("active_skills", [])
+    board = "board-esp32-s3-devkitc-1" if "esp32-s3" in active_skills else "board-esp32-devkit-c-v4"
+
+    system_prompt = f"""You are an expert at Wokwi circuit simulation. Generate ONLY the Wokwi diagram.json for the circuit in the request.
+
+Target board part: {board} (id "esp")
+
+FORMAT:
+{{"version": 1, "author": "embed-agent", "editor": "wokwi",
+ "parts": [{{"type": "{board}", "id": "esp", "top": 0, "left": 0, "attrs": {{}}}}, ...],
+ "connections": [["esp:13", "led1:A", "green", []], ...]}}
+
+PARTS AND PINS:
+- wokwi-led: A (anode), C (cathode); attrs {{"color": "red"}}
+- wokwi-resistor: 1, 2; attrs {{"value": "220"}}
+- wokwi-pushbutton: 1.l, 1.r, 2.l, 2.r
+- wokwi-buzzer: 1 (negative), 2 (positive)
+- Board pins: "esp:<gpio number>", "esp:GND.1", "esp:3V3.1"
+
+RULES:
+1. Do NOT ask clarifying questions. Use the GPIO numbers given in the request.
+2. Put a series resistor on every LED; honor stated pull-up/pull-down wiring.
+3. Connect the serial monitor: ["esp:TX", "$serialMonitor:RX", "", []] and ["esp:RX", "$serialMonitor:TX", "", []].
+4. Output ONLY the JSON (inside ```json wrapper)."""
+
+    messages = [("system", system_prompt), ("user", state["requirements"])]
+    return system_prompt, messages
+
+
+def _diagram_result(
+    state: AgentState,
+    system_prompt: str,
+    response: Any,
+    duration_ms: float,
+    metrics: dict = None,
+    error: Exception = None,
+) -> dict:
+    """Build the diagram state update. Invalid diagrams are logged and dropped."""
+    diagram_content = ""
+    output = response.content if response is not None else None
+    if error is None:
+        try:
+            diagram_content = extract_diagram_json(response.content)
+        except ValueError as e:
+            error = e
+
+    debug_log = create_debug_log(
+        node="diagram",
+        input_messages={
+            "system": system_prompt,
+            "user": state["requirements"],
+        },
+        output=output if error is None else {"error": str(error), "raw": output},
+        duration_ms=duration_ms,
+        metadata={"status": "ok" if error is None else "failed"},
+        metrics=metrics,
+    )
+
+    return {
+        "diagram_content": diagram_content,
+        "debug_logs": [debug_log],
+    }
+
+
+def diagram_node(state: AgentState) -> dict:
+    """
+    Generate a Wokwi wiring diagram for the requirements.
+
+    Runs as a parallel branch next to coder; failures never abort the run.
+
+    Reads: requirements, active_skills
+    Writes: diagram_content, debug_logs
+    """
+    system_prompt, messages = _build_diagram_messages(state)
+
+    start_time = time.time()
+    try:
+        response, metrics = invoke_llm(get_model(), messages)
+    except Exception as e:  # pylint: disable=broad-except
+        return _diagram_result(state, system_prompt, None, (time.time() - start_time) * 1000, error=e)
+    duration_ms = (time.time() - start_time) * 1000
+
+    return _diagram_result(state, system_prompt, response, duration_ms, metrics)
+
+
+async def adiagram_node(state: AgentState) -> dict:
+    """
+    Async, streaming variant of diagram_node.
+
+    Reads: requirements, active_skills
+    Writes: diagram_content, debug_logs
+    """
+    system_prompt, messages = _build_diagram_messages(state)
+
+    start_time = time.time()
+    try:
+        response, metrics = await astream_llm(get_model(), messages)
+    except Exception as e:  # pylint: disable=broad-except
+        return _diagram_result(state, system_prompt, None, (time.time() - start_time) * 1000, error=e)
+    duration_ms = (time.time() - start_time) * 1000
+
+    return _diagram_result(state, system_prompt, response, duration_ms, metrics)
 
 
 def _get_workspace(state: AgentState) -> WorkspaceInfo:
@@ -349,10 +1252,37 @@ def _get_workspace(state: AgentState) -> WorkspaceInfo:
 def assemble_artifacts_node(state: AgentState) -> dict:
     """
     Convert generated outputs into file artifacts without touching disk.
+
+    A code_patch (incremental mode) is applied to the base run's code first;
+    if it does not apply, the base code is assembled and coder is asked for
+    the complete file instead (see route_after_assemble).
     """
     workspace = _get_workspace(state)
-    raw_code = state.get("code_content", "")
-    clean_code = extract_clean_code(raw_code)
+    update: dict = {}
+    base_run = state.get("base_run")
+    if state.get("code_patch") and base_run:
+        incremental = {"base_run": base_run["run_dir"], "similarity": base_run.get("similarity"), "mode": "diff"}
+        try:
+            clean_code = apply_unified_diff(base_run["code"], extract_diff(state["code_patch"])).strip()
+            incremental["patch"] = "applied"
+            update["code_content"] = f"```c\n{clean_code}\n```"
+        except PatchError as e:
+            clean_code = base_run["code"].strip()
+            incremental["patch"] = f"failed: {e}"
+            update["code_content"] = f"```c\n{clean_code}\n```"
+            update["repair_feedback"] = (
+                f"Your diff against this code did not apply ({e}). "
+                "Output the complete updated file implementing the current requirements instead."
+            )
+        update["code_patch"] = None
+        update["incremental"] = incremental
+    else:
+        clean_code = extract_clean_code(state.get("code_content") or "")
+        if base_run:
+            update["incremental"] = {
+                **(state.get("incremental") or {"base_run": base_run["run_dir"], "similarity": base_run.get("similarity")}),
+                "mode": "reuse" if not state.get("incremental") and clean_code == base_run["code"].strip() else "full",
+            }
     diagram_content = (state.get("diagram_content") or "").strip()
 
     artifacts: List[Artifact] = []
@@ -385,6 +1315,22 @@ def assemble_artifacts_node(state: AgentState) -> dict:
             "content": 'idf_component_register(SRCS "main.c" INCLUDE_DIRS ".")',
             "role": "meta",
         })
+        artifacts.extend(component_artifacts(clean_code))
+
+        profile = state.get("firmware_profile")
+        component_options = component_sdkconfig(clean_code)
+        if profile:
+            artifacts.append({
+                "path": "sdkconfig.defaults",
+                "content": render_sdkconfig_defaults(profile, component_options),
+                "role": "config",
+            })
+        elif component_options:
+            artifacts.append({
+                "path": "sdkconfig.defaults",
+                "content": "# bundled component options\n" + "\n".join(component_options) + "\n",
+                "role": "config",
+            })
 
     if diagram_content:
         artifacts.append({
@@ -394,11 +1340,80 @@ def assemble_artifacts_node(state: AgentState) -> dict:
         })
 
     return {
+        **update,
         "workspace": workspace,
         "artifacts": artifacts,
     }
 
 
+def route_after_assemble(state: AgentState) -> str:
+    """Route back to coder when an incremental patch did not apply."""
+    return "repair" if state.get("repair_feedback") else "lint"
+
+
+def _lint_artifacts(state: AgentState, artifacts: List[Artifact]) -> LintResult:
+    """Lint the code artifact of an ESP-IDF project."""
+    workspace = _get_workspace(state)
+    code = next((a for a in artifacts if a.get("role") == "code"), None)
+    if not LINT_CONFIG.enabled:
+        return LintResult(reason="lint.enabled is false")
+    if workspace["target"] != "esp-idf" or code is None:
+        return LintResult(reason=f"target '{workspace['target']}' is not linted")
+    return lint_c(code["content"])
+
+
+def lint_firmware_node(state: AgentState) -> dict:
+    """
+    Lint the interrupt-context code of the assembled main.c (see src/lint.py).
+
+    Error findings are handed back to coder as repair hints until
+    lint.max_repairs lint repairs have been used; the run then continues
+    to persist with the findings recorded.
+
+    Reads: artifacts, workspace, lint_repairs
+    Writes: lint_result, repair_feedback, lint_repairs, debug_logs
+    """
+    repairs = state.get("lint_repairs", 0)
+    code = next((a for a in state.get("artifacts", []) if a.get("role") == "code"), None)
+    result = _lint_artifacts(state, state.get("artifacts", []))
+
+    errors = result.errors
+    repair = bool(errors) and repairs < LINT_CONFIG.max_repairs
+
+    debug_log = create_debug_log(
+        node="lint_firmware",
+        input_messages={"path": code["path"] if code else None},
+        output=render_findings(result.findings) or result.reason,
+        duration_ms=result.duration_ms,
+        metadata={
+            "status": result.status,
+            "isr_functions": result.isr_functions,
+            "errors": len(errors),
+            "warnings": len(result.findings) - len(errors),
+            "repair_requested": repair,
+            "lint_repairs": repairs,
+        },
+    )
+
+    update = {
+        "lint_result": result.to_dict(),
+        "debug_logs": [debug_log],
+    }
+    if repair:
+        update["repair_feedback"] = (
+            "Interrupt-context violations (fix every error; keep the ISRs short, IRAM_ATTR, "
+            "and hand work to tasks):\n" + render_findings(errors, code["path"])
+        )
+        update["lint_repairs"] = repairs + 1
+
+    return update
+
+
+def route_after_lint(state: AgentState) -> str:
+    """Route back to coder when lint_firmware requested a repair."""
+    return "repair" if state.get("repair_feedback") else "done"
+
+
 def _validate_artifact_path(output_root: Path, rel_path: str) -> Path:
     """Validate artifact relative path and return resolved absolute path."""
     relative = Path(rel_path)
@@ -415,8 +1430,65 @@ def _validate_artifact_path(output_root: Path, rel_path: str) -> Path:
     return final_path
 
 
+def _branch_timings(debug_logs: List[dict], branches: tuple) -> dict:
+    """
+    Summarize start/end times of parallel branches and how much they overlapped.
+
+    Uses the last debug entry of each branch node.
+    """
+    spans = {}
+    for log in debug_logs:
+        if log.get("node") in branches and log.get("started_at"):
+            spans[log["node"]] = (
+                datetime.fromisoformat(log["started_at"]),
+                datetime.fromisoformat(log["timestamp"]),
+            )
+
+    timings = {
+        name: {
+            "started_at": start.isoformat(),
+            "finished_at": end.isoformat(),
+            "duration_ms": round((end - start).total_seconds() * 1000, 2),
+        }
+        for name, (start, end) in spans.items()
+    }
+
+    if len(spans) > 1:
+        latest_start = max(start for start, _ in spans.values())
+        earliest_end = min(end for _, end in spans.values())
+        first_start = min(start for start, _ in spans.values())
+        last_end = max(end for _, end in spans.values())
+        timings["overlap_ms"] = round(max(0.0, (earliest_end - latest_start).total_seconds() * 1000), 2)
+        timings["wall_ms"] = round((last_end - first_start).total_seconds() * 1000, 2)
+
+    return timings
+
+
+def _export_debug_logs(run_path: Path, pending: List[dict] = ()) -> None:
+    """Refresh the consolidated debug.json from debug.jsonl (plus the calling node's entries), if enabled."""
+    if DEBUG_CONFIG.export_json:
+        export_json(run_path, pending)
+
+
+def _update_metadata(run_path: Path, updates: dict) -> None:
+    """Merge post-persist results (e.g. build status) into metadata.json."""
+    metadata_path = run_path / "metadata.json"
+    try:
+        metadata = json.loads(metadata_path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        metadata = {}
+    metadata.update(updates)
+    metadata_path.write_text(json.dumps(metadata, indent=2), encoding="utf-8")
+
+
 def persist_node(state: AgentState) -> dict:
-    """Persist artifacts and run-level metadata to disk."""
+    """
+    Persist artifacts and run-level metadata to disk.
+
+    With the object store enabled, each artifact is written once to
+    tasks/.objects and hardlinked into output/ (store.mode "link") or only
+    referenced by its manifest sha256 (store.mode "ref"); see src/objects.py.
+    """
     workspace = _get_workspace(state)
     run_dir = state.get("run_dir", "./output")
     run_path = Path(run_dir)
@@ -426,6 +1498,7 @@ def persist_node(state: AgentState) -> dict:
     artifacts = state.get("artifacts", [])
     persisted_paths: List[str] = []
     manifest_artifacts: List[dict] = []
+    store = _object_store(state)
 
     for artifact in artifacts:
         rel_path = artifact.get("path", "")
@@ -434,9 +1507,15 @@ def persist_node(state: AgentState) -> dict:
 
         final_path = _validate_artifact_path(output_root, rel_path)
         final_path.parent.mkdir(parents=True, exist_ok=True)
-        final_path.write_text(content, encoding="utf-8")
-
         payload = content.encode("utf-8")
+        if store is None:
+            final_path.write_bytes(payload)
+        elif STORE_CONFIG.mode == "link":
+            store.link(store.put(payload), final_path)
+        else:
+            store.put(payload)
+            final_path.unlink(missing_ok=True)  # stale file from a previous repair iteration
+
         manifest_artifacts.append({
             "path": rel_path,
             "role": role,
@@ -453,15 +1532,18 @@ def persist_node(state: AgentState) -> dict:
         "project_name": project_name,
         "target": workspace["target"],
         "active_skills": active_skills,
+        "sdkconfig_profile": state.get("firmware_profile"),
         "timestamp": datetime.now().isoformat(),
+        "store": STORE_CONFIG.mode if store else "off",
         "artifacts": manifest_artifacts,
     }
     manifest_path = output_root / "manifest.lock.json"
     manifest_path.write_text(json.dumps(manifest, indent=2), encoding="utf-8")
 
     debug_logs = state.get("debug_logs", [])
-    debug_path = run_path / "debug.json"
-    debug_path.write_text(json.dumps(debug_logs, indent=2), encoding="utf-8")
+    branch_timings = _branch_timings(debug_logs, ("coder", "diagram"))
+    cache_statuses = [log.get("metrics", {}).get("cache") for log in debug_logs]
+    _export_debug_logs(run_path)
 
     metadata = {
         "task_name": state.get("task_name", "unknown"),
@@ -469,9 +1551,25 @@ def persist_node(state: AgentState) -> dict:
         "project_name": project_name,
         "active_skills": active_skills,
         "output_type": output_type,
+        "firmware_profile": state.get("firmware_profile"),
+        "task_placement": state.get("task_placement"),
+        "lint": state.get("lint_result"),
+        "incremental": state.get("incremental"),
         "timestamp": datetime.now().isoformat(),
         "requirements": state.get("requirements", ""),
+        "skill_context": state.get("skill_context_stats", {}),
+        "branch_timings": branch_timings,
+        "llm_cache": {
+            "hits": cache_statuses.count("hit"),
+            "misses": cache_statuses.count("miss"),
+        },
     }
+    if state.get("candidate_summary"):
+        # Multi-candidate runs are built/benchmarked before persisting.
+        metadata["candidates"] = state["candidate_summary"]
+        for key, value in (("build", state.get("build_result")), ("benchmark", state.get("benchmark_result"))):
+            if value:
+                metadata[key] = value
     metadata_path = run_path / "metadata.json"
     metadata_path.write_text(json.dumps(metadata, indent=2), encoding="utf-8")
 
@@ -479,4 +1577,266 @@ def persist_node(state: AgentState) -> dict:
         "manifest_path": str(manifest_path),
         "persisted_paths": persisted_paths,
         "status_msg": f"Project generated at {run_path}",
-    }
\ No newline at end of file
+    }
+
+
+def _build_artifacts(state: AgentState, artifacts: List[Artifact], run_path: Path) -> BuildResult:
+    """Build artifacts (instrumented for the benchmark when enabled) into run_path."""
+    workspace = _get_workspace(state)
+    if workspace["target"] != "esp-idf":
+        return BuildResult(status="skipped", reason=f"target '{workspace['target']}' is not built")
+
+    if BENCHMARK_CONFIG.enabled:
+        spec = load_spec(Path(state.get("task_dir", ".")), state.get("requirements", ""))
+        artifacts = instrument_artifacts(artifacts, spec, sample_us=BENCHMARK_CONFIG.sample_us)
+    result = run_build(
+        artifacts,
+        run_path,
+        target=BUILD_CONFIG.idf_target,
+        cache_dir=BUILD_CONFIG.cache_dir,
+        slots=BUILD_CONFIG.slots,
+        timeout_s=BUILD_CONFIG.timeout_s,
+    )
+    store = _object_store(state)
+    if store and result.firmware_dir:
+        result.extra["stored_firmware_files"] = store.absorb(Path(result.firmware_dir))
+    return result
+
+
+def build_verify_node(state: AgentState) -> dict:
+    """
+    Compile the persisted project in a warm ESP-IDF build tree.
+
+    On compiler/linker errors, hands the diagnostics back to coder until
+    build.max_repairs repair iterations have been used. With benchmark
+    enabled, the edge_trace component is built in so the collected firmware
+    can be benchmarked as-is.
+
+    Reads: artifacts, workspace, run_dir, repair_attempts, debug_logs
+    Writes: build_result, repair_feedback, repair_attempts, debug_logs
+    """
+    run_path = Path(state.get("run_dir", "./output"))
+    attempts = state.get("repair_attempts", 0)
+
+    result = _build_artifacts(state, state.get("artifacts", []), run_path)
+
+    repair = result.status == "failed" and attempts < BUILD_CONFIG.max_repairs
+
+    debug_log = create_debug_log(
+        node="build_verify",
+        input_messages={"tree": result.tree, "sdkconfig_hash": result.sdkconfig_hash},
+        output=result.diagnostics or result.reason,
+        duration_ms=result.duration_ms,
+        metadata={
+            "status": result.status,
+            "repair_requested": repair,
+            "repair_attempts": attempts,
+            "app_size": result.app_size,
+            **result.extra,
+        },
+    )
+
+    _export_debug_logs(run_path, [debug_log])
+    _update_metadata(run_path, {"build": result.to_dict(), "repair_attempts": attempts})
+
+    update = {
+        "build_result": result.to_dict(),
+        "debug_logs": [debug_log],
+    }
+    if repair:
+        update["repair_feedback"] = f"ESP-IDF build errors:\n{result.diagnostics}"
+        update["repair_attempts"] = attempts + 1
+
+    return update
+
+
+def route_after_build(state: AgentState) -> str:
+    """Route back to coder when build_verify requested a repair."""
+    return "repair" if state.get("repair_feedback") else "done"
+
+
+def _benchmark_build(state: AgentState, build: dict, run_path: Path, spec: dict) -> dict:
+    """Benchmark a build result on a board leased from the device pool."""
+    if build.get("status") != "ok":
+        return {"status": "skipped", "reason": f"build {build.get('status', 'missing')}"}
+    if not DEVICE_POOL.patterns:
+        return {"status": "skipped", "reason": "benchmark.port / benchmark.ports not configured"}
+
+    port = None
+    lease_start = time.time()
+    try:
+        with DEVICE_POOL.lease(key=build["firmware_dir"]) as port:
+            leased_at = time.time()
+            result = run_benchmark(
+                Path(build["firmware_dir"]),
+                run_path,
+                spec,
+                port=port,
+                chip=BUILD_CONFIG.idf_target,
+                baud=BENCHMARK_CONFIG.baud,
+                flash_baud=BENCHMARK_CONFIG.flash_baud,
+                duration_s=BENCHMARK_CONFIG.duration_s if "duration_s" not in spec else None,
+                analyzer_cmd=BENCHMARK_CONFIG.analyzer_cmd,
+                current_cmd=BENCHMARK_CONFIG.current_cmd,
+                placement=state.get("task_placement"),
+                flash_state=DEVICE_POOL.state_path(port),
+            )
+            DEVICE_POOL.report(port, ok=True)
+            return {**result, "lease_wait_ms": round((leased_at - lease_start) * 1000, 2)}
+    except NoDevicesError as e:
+        return {"status": "skipped", "reason": str(e)}
+    except Exception as e:  # pylint: disable=broad-exception-caught
+        if port is not None and isinstance(e, (DeviceError, OSError)):
+            DEVICE_POOL.report(port, ok=False)
+        return {"status": "failed", "port": port, "reason": str(e)}
+
+
+def benchmark_node(state: AgentState) -> dict:
+    """
+    Flash the instrumented firmware and measure GPIO timing on the board.
+
+    Skipped (not an error) when the build did not produce firmware or no
+    serial port is configured; hardware/capture errors are recorded as
+    status "failed".
+
+    Reads: build_result, task_dir, requirements, run_dir, task_placement, debug_logs
+    Writes: benchmark_result, debug_logs
+    """
+    run_path = Path(state.get("run_dir", "./output"))
+    build = state.get("build_result", {})
+    spec = load_spec(Path(state.get("task_dir", ".")), state.get("requirements", ""))
+
+    start_time = time.time()
+    result = _benchmark_build(state, build, run_path, spec)
+    duration_ms = (time.time() - start_time) * 1000
+
+    debug_log = create_debug_log(
+        node="benchmark",
+        input_messages={"port": result.get("port"), "pins": sorted(spec["pins"])},
+        output=json.dumps(result, indent=2),
+        duration_ms=duration_ms,
+        metadata={"status": result["status"], "spec_source": spec.get("source")},
+    )
+
+    _export_debug_logs(run_path, [debug_log])
+    _update_metadata(run_path, {"benchmark": result})
+
+    return {
+        "benchmark_result": result,
+        "debug_logs": [debug_log],
+    }
+
+
+def fan_out_candidates(state: AgentState) -> List[Send]:
+    """Send one candidate_node invocation per configured variant."""
+    variants = candidate_variants(
+        CANDIDATES_CONFIG.count,
+        list(CANDIDATES_CONFIG.temperatures),
+        vary_skills=CANDIDATES_CONFIG.vary_skills,
+    )
+    return [Send("candidate", {**state, "candidate": variant}) for variant in variants]
+
+
+def candidate_node(state: AgentState) -> dict:
+    """
+    Generate, lint, build and benchmark one candidate in <run_dir>/candidates/<index>/.
+
+    Candidates get no repair iterations; a failing candidate is ranked down
+    by select_candidate_node instead.
+
+    Reads: candidate (variant from fan_out_candidates) plus everything coder reads
+    Writes: candidates (one record), debug_logs
+    """
+    variant = state["candidate"]
+    run_path = Path(state.get("run_dir", "./output")) / "candidates" / str(variant["index"])
+    run_path.mkdir(parents=True, exist_ok=True)
+
+    candidate_state = {**state, "repair_feedback": None, "base_run": None}
+    if variant["skills"] == "full":
+        candidate_state["active_skill_content"] = registry.get_combined_skill_content(sorted(state.get("active_skills", [])))
+        candidate_state["retrieved_skill_content"] = None
+
+    llm = get_model() if variant["temperature"] == MODEL_TEMPERATURE else _create_model(variant["temperature"])
+    system_prompt, messages = _build_coder_messages(candidate_state)
+
+    record = {**variant, "dir": str(run_path)}
+    start_time = time.time()
+    try:
+        response, metrics = invoke_llm(llm, messages)
+    except Exception as e:  # pylint: disable=broad-exception-caught
+        record["error"] = str(e)
+        return {"candidates": [record]}
+    duration_ms = (time.time() - start_time) * 1000
+
+    candidate_state["code_content"] = response.content
+    artifacts = assemble_artifacts_node(candidate_state)["artifacts"]
+    code = artifacts[0]["content"]
+    record.update(
+        code_content=response.content,
+        artifacts=artifacts,
+        lines=len(code.splitlines()),
+        code_sha256=hashlib.sha256(code.encode("utf-8")).hexdigest(),
+        lint=_lint_artifacts(candidate_state, artifacts).to_dict(),
+    )
+
+    if BUILD_CONFIG.enabled:
+        build = _build_artifacts(candidate_state, artifacts, run_path).to_dict()
+        record["build"] = build
+        if BENCHMARK_CONFIG.enabled:
+            spec = load_spec(Path(state.get("task_dir", ".")), state.get("requirements", ""))
+            record["benchmark"] = _benchmark_build(candidate_state, build, run_path, spec)
+
+    debug_log = create_debug_log(
+        node="candidate",
+        input_messages={"system": system_prompt, "user": state["requirements"]},
+        output=response.content,
+        duration_ms=duration_ms,
+        metadata={
+            **variant,
+            "lint": record["lint"]["status"],
+            "build": (record.get("build") or {}).get("status"),
+            "benchmark": (record.get("benchmark") or {}).get("status"),
+        },
+        metrics=metrics,
+    )
+    return {"candidates": [record], "debug_logs": [debug_log]}
+
+
+def select_candidate_node(state: AgentState) -> dict:
+    """
+    Keep the best candidate (see src/candidates.py) as the run's result.
+
+    Reads: candidates
+    Writes: code_content, artifacts, workspace, lint_result, build_result,
+        benchmark_result, candidate_summary, debug_logs
+    """
+    ranked = select([c for c in state.get("candidates", []) if c.get("artifacts")])
+    summary = [summarize(c) for c in sorted(state.get("candidates", []), key=lambda c: c["index"])]
+    if not ranked:
+        raise RuntimeError(f"All {len(summary)} candidates failed: {[c.get('error') for c in summary]}")
+
+    winner = ranked[0]
+    for entry in summary:
+        entry["selected"] = entry["index"] == winner["index"]
+
+    debug_log = create_debug_log(
+        node="select_candidate",
+        input_messages={"candidates": len(summary)},
+        output=f"candidate {winner['index']}",
+        duration_ms=0.0,
+        metadata={"ranking": [[c["index"], [str(k) for k in rank_key(c)]] for c in ranked]},
+    )
+
+    update = {
+        "code_content": winner["code_content"],
+        "artifacts": winner["artifacts"],
+        "workspace": _get_workspace(state),
+        "lint_result": winner["lint"],
+        "candidate_summary": summary,
+        "debug_logs": [debug_log],
+    }
+    if "build" in winner:
+        update["build_result"] = winner["build"]
+    if "benchmark" in winner:
+        update["benchmark_result"] = winner["benchmark"]
+    return update
@@ -0,0 +1,144 @@
+"""
+Content-addressed object store shared by every run of every task.
+
+Layout:
+    tasks/.objects/<sha256>            # one read-only file per distinct content
+
+With store.mode "link", persist writes each artifact once into the store and
+hardlinks it into the run's output/ (and build_verify does the same for
+firmware/), so the near-identical CMakeLists.txt, sdkconfig.defaults,
+bundled components and bootloader/partition images of thousands of runs
+share one copy. Objects are read-only, so tools writing through a link fail
+instead of corrupting every run that shares it; when hardlinks are not
+possible (another filesystem) the file is copied. With mode "ref" output/
+only holds manifest.lock.json, whose sha256 entries reference the objects.
+
+materialize() checks out a run's output/ as plain writable files (for
+building or editing by hand):
+
+    python main.py --materialize tasks/<task>/runs/<ts> [DEST]
+"""
+
+import hashlib
+import json
+import os
+import shutil
+import stat
+import tempfile
+from pathlib import Path
+from typing import Optional
+
+OBJECTS_DIR = ".objects"
+STORE_MODES = ("off", "link", "ref")
+
+
+def store_root(task_dir: Path) -> Path:
+    """Object store shared by task_dir and its sibling tasks."""
+    return Path(task_dir).parent / OBJECTS_DIR
+
+
+class ObjectStore:
+    """Write-once blobs named by their sha256."""
+
+    def __init__(self, root: Path):
+        self.root = Path(root)
+
+    def path(self, sha256: str) -> Path:
+        return self.root / sha256
+
+    def put(self, data: bytes) -> str:
+        """Store data (no-op if present); returns its sha256."""
+        sha256 = hashlib.sha256(data).hexdigest()
+        path = self.path(sha256)
+        if path.exists():
+            return sha256
+
+        self.root.mkdir(parents=True, exist_ok=True)
+        fd, tmp = tempfile.mkstemp(dir=self.root, prefix=".tmp-")
+        try:
+            with os.fdopen(fd, "wb") as f:
+                f.write(data)
+            os.chmod(tmp, stat.S_IRUSR | stat.S_IRGRP | stat.S_IROTH)
+            os.replace(tmp, path)  # concurrent writers of the same content are harmless
+        except BaseException:
+            Path(tmp).unlink(missing_ok=True)
+            raise
+        return sha256
+
+    def get(self, sha256: str) -> bytes:
+        """Object content (OSError if missing)."""
+        return self.path(sha256).read_bytes()
+
+    def link(self, sha256: str, dest: Path) -> None:
+        """Place object sha256 at dest as a hardlink (copy across filesystems)."""
+        dest.parent.mkdir(parents=True, exist_ok=True)
+        dest.unlink(missing_ok=True)
+        try:
+            os.link(self.path(sha256), dest)
+        except OSError:
+            shutil.copyfile(self.path(sha256), dest)
+
+    def absorb(self, directory: Path) -> int:
+        """Replace every file under directory by a link to its stored object; returns the file count."""
+        count = 0
+        for path in sorted(Path(directory).rglob("*")):
+            if path.is_file() and not path.is_symlink():
+                self.link(self.put(path.read_bytes()), path)
+                count += 1
+        return count
+
+
+def read_artifact(output_root: Path, artifact: dict, store: Optional[ObjectStore] = None) -> bytes:
+    """
+    Content of a manifest artifact: the output/ file, else the stored object.
+
+    Raises:
+        OSError: neither exists
+    """
+    path = output_root / artifact["path"]
+    if path.is_file():
+        return path.read_bytes()
+    if store is None:
+        raise FileNotFoundError(path)
+    return store.get(artifact["sha256"])
+
+
+def materialize(run_dir: Path, dest: Optional[Path] = None, store: Optional[ObjectStore] = None) -> Path:
+    """
+    Check out a run's artifacts as plain, writable files.
+
+    Args:
+        run_dir: tasks/<task>/runs/<ts>
+        dest: Target directory (default: the run's own output/, links replaced by copies)
+        store: Object store (default: the one next to the run's task directory)
+
+    Returns:
+        The materialized directory
+
+    Raises:
+        ValueError: missing manifest, missing object or checksum mismatch
+    """
+    run_dir = Path(run_dir)
+    output_root = run_dir / "output"
+    store = store or ObjectStore(store_root(run_dir.parent.parent))
+    try:
+        manifest = json.loads((output_root / "manifest.lock.json").read_text(encoding="utf-8"))
+    except (OSError, ValueError) as e:
+        raise ValueError(f"No readable manifest.lock.json in {output_root}: {e}") from e
+
+    dest = Path(dest) if dest else output_root
+    for artifact in manifest.get("artifacts", []):
+        try:
+            data = read_artifact(output_root, artifact, store)
+        except OSError as e:
+            raise ValueError(f"Missing content for {artifact['path']} ({artifact['sha256'][:12]})") from e
+        if hashlib.sha256(data).hexdigest() != artifact["sha256"]:
+            raise ValueError(f"Checksum mismatch for {artifact['path']}")
+
+        target = dest / artifact["path"]
+        target.parent.mkdir(parents=True, exist_ok=True)
+        target.unlink(missing_ok=True)
+        target.write_bytes(data)
+    if dest != output_root:
+        shutil.copyfile(output_root / "manifest.lock.json", dest / "manifest.lock.json")
+    return dest
@@ -0,0 +1,106 @@
+"""
+Unified-diff application for incremental regeneration.
+
+LLM-written diffs usually get the @@ line counts wrong and sometimes drift in
+trailing whitespace, so hunks are located by their context and removed lines
+(compared with trailing whitespace stripped), starting at the hinted line and
+searching outwards, rather than trusted by position. Hunks must apply in
+order and without overlap; anything else is a PatchError.
+"""
+
+import re
+from typing import List, Optional, Tuple
+
+_FENCE_RE = re.compile(r"```(?:diff|patch|udiff)?\n(.*?)```", re.DOTALL)
+_HUNK_RE = re.compile(r"^@@ -(\d+)(?:,\d+)? \+\d+(?:,\d+)? @@")
+
+
+class PatchError(ValueError):
+    """The diff is malformed or does not match the original."""
+
+
+def extract_diff(raw_text: str) -> str:
+    """Diff text from an LLM response (```diff block or bare diff)."""
+    match = _FENCE_RE.search(raw_text)
+    return match.group(1) if match else raw_text
+
+
+def parse_hunks(diff: str) -> List[Tuple[Optional[int], List[Tuple[str, str]]]]:
+    """
+    Parse unified-diff hunks.
+
+    Returns:
+        [(hinted 0-based start line or None, [(op, text), ...]), ...] with op
+        " " (context), "-" (removed) or "+" (added)
+    """
+    hunks = []
+    current = None
+    for line in diff.splitlines():
+        if line.startswith(("--- ", "+++ ", "diff ", "index ")) and current is None:
+            continue
+        if line.startswith("@@"):
+            match = _HUNK_RE.match(line)
+            current = (max(0, int(match.group(1)) - 1) if match else None, [])
+            hunks.append(current)
+        elif current is None:
+            if line.strip():
+                raise PatchError(f"Unexpected line before the first hunk: {line!r}")
+        elif line.startswith("\\"):
+            continue  # "\ No newline at end of file"
+        elif line.startswith(("-", "+")):
+            current[1].append((line[0], line[1:]))
+        elif line.startswith(" "):
+            current[1].append((" ", line[1:]))
+        else:
+            current[1].append(("=", line))  # context whose leading space was lost
+    if not hunks:
+        raise PatchError("No hunks found in diff")
+    for _, ops in hunks:
+        while ops and ops[-1] == ("=", ""):
+            ops.pop()  # blank lines between the diff and the closing fence
+    return [(hint, [(" " if op == "=" else op, text) for op, text in ops]) for hint, ops in hunks]
+
+
+def _find(lines: List[str], block: List[str], start: int, hint: Optional[int]) -> int:
+    """Index >= start where block matches (nearest to hint), or -1."""
+    wanted = [l.rstrip() for l in block]
+    last = len(lines) - len(block)
+    origin = max(start, min(hint if hint is not None else start, max(start, last)))
+    for distance in range(0, max(origin - start, last - origin) + 1):
+        for index in (origin - distance, origin + distance):
+            if start <= index <= last and [l.rstrip() for l in lines[index:index + len(block)]] == wanted:
+                return index
+    return -1
+
+
+def apply_unified_diff(original: str, diff: str) -> str:
+    """
+    Apply a unified diff to original text.
+
+    Raises:
+        PatchError: malformed diff or a hunk that does not match
+    """
+    lines = original.splitlines()
+    output: List[str] = []
+    cursor = 0
+    for number, (hint, ops) in enumerate(parse_hunks(diff), 1):
+        old = [text for op, text in ops if op != "+"]
+        if old:
+            index = _find(lines, old, cursor, hint)
+            if index < 0:
+                raise PatchError(f"Hunk {number} does not match the original (first line: {old[0]!r})")
+        elif hint is not None and hint >= cursor:
+            index = min(hint, len(lines))
+        else:
+            raise PatchError(f"Hunk {number} has no context to anchor it")
+        output.extend(lines[cursor:index])
+        cursor = index
+        for op, text in ops:
+            if op == "+":
+                output.append(text)
+            else:
+                if op == " ":
+                    output.append(lines[cursor])  # keep the original's whitespace
+                cursor += 1
+    output.extend(lines[cursor:])
+    return "\n".join(output) + ("\n" if original.endswith("\n") else "")
@@ -0,0 +1,250 @@
+"""
+FreeRTOS task placement plans for generated ESP-IDF firmware.
+
+The manager declares which tasks the firmware runs, on which core and at
+which priority (ProjectPlan.task_placement); on its local fast path (no LLM
+call) the plan comes from local_placement() instead. prepare_workspace
+validates the plan against the rules below before the coder sees it,
+falling back to default_placement() when the plan is missing or broken:
+
+- The GPIO ISR service and time-critical consumers (isr_service/realtime
+  roles) share one core (isr_core); gpio_install_isr_service() allocates the
+  interrupt on the calling core, so it must be called from a task pinned
+  there.
+- Logging, network and housekeeping tasks live on the other core (core 0 is
+  also where the Wi-Fi/BT stacks and the esp_timer task run by default).
+- Time-critical tasks outrank everything on the housekeeping side.
+"""
+
+import re
+from typing import Dict, List, Literal, Optional, Tuple
+
+from pydantic import BaseModel, Field
+
+# FreeRTOS priorities usable by application tasks (configMAX_PRIORITIES = 25).
+MIN_PRIORITY = 1
+MAX_PRIORITY = 24
+MIN_STACK_BYTES = 2048
+
+# Measured stack use is scaled by STACK_HEADROOM plus STACK_MARGIN_BYTES and
+# rounded up to STACK_ROUND_BYTES when sizing stacks from a benchmark run.
+STACK_HEADROOM = 1.25
+STACK_MARGIN_BYTES = 512
+STACK_ROUND_BYTES = 256
+
+# FreeRTOS truncates task names to configMAX_TASK_NAME_LEN - 1 characters.
+TASK_NAME_LEN = 15
+
+# Targets with a single Xtensa/RISC-V core (everything is placed on core 0).
+SINGLE_CORE_TARGETS = {"esp32s2", "esp32c2", "esp32c3", "esp32c5", "esp32c6", "esp32c61", "esp32h2"}
+
+TIME_CRITICAL_ROLES = ("isr_service", "realtime")
+BACKGROUND_ROLES = ("logging", "network", "housekeeping")
+
+TaskRole = Literal["isr_service", "realtime", "logging", "network", "housekeeping"]
+
+
+class TaskSpec(BaseModel):
+    """One FreeRTOS task of the generated firmware."""
+
+    name: str = Field(..., description="Task function / pcName, e.g. 'button_task'")
+    role: TaskRole = Field(
+        ...,
+        description="isr_service (installs the GPIO ISR service), realtime (consumes ISR/timer events), "
+        "logging, network or housekeeping",
+    )
+    core: int = Field(..., description="Core the task is pinned to (0 or 1)")
+    priority: int = Field(..., description=f"FreeRTOS priority {MIN_PRIORITY}..{MAX_PRIORITY}")
+    stack_bytes: int = Field(4096, description="Stack size in bytes")
+
+
+class TaskPlacement(BaseModel):
+    """Task-to-core placement for dual-core ESP32 targets."""
+
+    isr_core: int = Field(1, description="Core running the GPIO ISR service and time-critical tasks")
+    tasks: List[TaskSpec] = Field(default_factory=list, description="Every task the firmware creates")
+
+
+def cores_for_target(idf_target: str) -> int:
+    return 1 if idf_target in SINGLE_CORE_TARGETS else 2
+
+
+def default_placement(num_cores: int = 2) -> TaskPlacement:
+    """Event consumer + ISR service on core 1, housekeeping/logging on core 0."""
+    isr_core = 1 if num_cores > 1 else 0
+    return TaskPlacement(
+        isr_core=isr_core,
+        tasks=[
+            TaskSpec(name="event_task", role="realtime", core=isr_core, priority=20, stack_bytes=4096),
+            TaskSpec(name="housekeeping_task", role="housekeeping", core=0, priority=2, stack_bytes=4096),
+        ],
+    )
+
+
+# Requirement keywords that call for a background task of a role (local_placement).
+_BACKGROUND_KEYWORDS = {
+    "network": re.compile(r"wi-?fi|bluetooth|\bble\b|mqtt|http|socket|network", re.IGNORECASE),
+    "logging": re.compile(r"\blog|print|report|serial monitor|uart output", re.IGNORECASE),
+}
+
+
+def local_placement(requirements: str, num_cores: int = 2) -> TaskPlacement:
+    """
+    Placement derived from the requirements without the LLM planner.
+
+    One realtime event task on isr_core consumes the ISR/timer events;
+    a network and/or logging task is added when the requirements mention
+    them, else one housekeeping task.
+    """
+    isr_core = 1 if num_cores > 1 else 0
+    tasks = [TaskSpec(name="event_task", role="realtime", core=isr_core, priority=20, stack_bytes=4096)]
+    for role, pattern in _BACKGROUND_KEYWORDS.items():
+        if pattern.search(requirements or ""):
+            tasks.append(TaskSpec(name=f"{role}_task", role=role, core=0, priority=3, stack_bytes=4096))
+    if len(tasks) == 1:
+        tasks.append(TaskSpec(name="housekeeping_task", role="housekeeping", core=0, priority=2, stack_bytes=4096))
+    return TaskPlacement(isr_core=isr_core, tasks=tasks)
+
+
+def validate_placement(plan: TaskPlacement, num_cores: int = 2) -> List[str]:
+    """Return rule violations of a placement plan (empty when valid)."""
+    issues: List[str] = []
+    if plan.isr_core not in range(num_cores):
+        issues.append(f"isr_core {plan.isr_core} does not exist on a {num_cores}-core target")
+
+    names = [task.name for task in plan.tasks]
+    if len(set(names)) != len(names):
+        issues.append("task names must be unique")
+    if not any(task.role in TIME_CRITICAL_ROLES for task in plan.tasks):
+        issues.append("no isr_service/realtime task declared")
+
+    for task in plan.tasks:
+        if task.core not in range(num_cores):
+            issues.append(f"{task.name}: core {task.core} does not exist")
+        if not MIN_PRIORITY <= task.priority <= MAX_PRIORITY:
+            issues.append(f"{task.name}: priority {task.priority} outside {MIN_PRIORITY}..{MAX_PRIORITY}")
+        if task.stack_bytes < MIN_STACK_BYTES:
+            issues.append(f"{task.name}: stack_bytes {task.stack_bytes} < {MIN_STACK_BYTES}")
+        if task.role in TIME_CRITICAL_ROLES and task.core != plan.isr_core:
+            issues.append(f"{task.name}: {task.role} task must run on isr_core {plan.isr_core}")
+        if num_cores > 1 and task.role in BACKGROUND_ROLES and task.core == plan.isr_core:
+            issues.append(f"{task.name}: {task.role} task must not share isr_core {plan.isr_core}")
+
+    critical = [t.priority for t in plan.tasks if t.role in TIME_CRITICAL_ROLES]
+    background = [t.priority for t in plan.tasks if t.role in BACKGROUND_ROLES]
+    if critical and background and min(critical) <= max(background):
+        issues.append("time-critical tasks must have higher priorities than background tasks")
+
+    return issues
+
+
+def resolve_placement(plan: Optional[dict], num_cores: int = 2) -> Tuple[dict, List[str]]:
+    """
+    Validate a manager placement plan, falling back to the default plan.
+
+    Returns:
+        (placement dict with a "source" key - the plan's own "source" ("local"
+         for the manager fast path), "manager", or "default" - and the issues
+         found in the plan)
+    """
+    if plan:
+        try:
+            parsed = TaskPlacement.model_validate(plan)
+        except ValueError as e:
+            issues = [f"invalid plan: {e}"]
+        else:
+            issues = validate_placement(parsed, num_cores)
+            if not issues:
+                return {**parsed.model_dump(), "source": plan.get("source", "manager")}, []
+    else:
+        issues = []
+
+    return {**default_placement(num_cores).model_dump(), "source": "default"}, issues
+
+
+def recommend_stack(used_bytes: int) -> int:
+    """Stack size for a measured peak use (see STACK_* constants)."""
+    size = int(used_bytes * STACK_HEADROOM) + STACK_MARGIN_BYTES
+    size = -(-size // STACK_ROUND_BYTES) * STACK_ROUND_BYTES
+    return max(MIN_STACK_BYTES, size)
+
+
+def stack_report(stack_free: Dict[str, int], placement: Optional[dict] = None) -> Dict[str, dict]:
+    """
+    Combine measured minimum free stack (bytes) per task with planned sizes.
+
+    Returns:
+        {task_name: {"free_min_bytes", ["declared_bytes", "used_bytes", "recommended_bytes"]}}
+    """
+    declared = {
+        task["name"][:TASK_NAME_LEN]: task["stack_bytes"]
+        for task in (placement or {}).get("tasks", [])
+    }
+    report = {}
+    for name, free_bytes in sorted(stack_free.items()):
+        entry = {"free_min_bytes": free_bytes}
+        if name in declared:
+            used = max(0, declared[name] - free_bytes)
+            entry.update(
+                declared_bytes=declared[name],
+                used_bytes=used,
+                recommended_bytes=recommend_stack(used),
+            )
+        report[name] = entry
+    return report
+
+
+def apply_measured_stacks(placement: dict, stack: Dict[str, dict]) -> Tuple[dict, Dict[str, int]]:
+    """
+    Resize planned stacks from a previous benchmark's stack report.
+
+    Returns:
+        (updated placement, {task_name: new_stack_bytes} for resized tasks)
+    """
+    resized = {}
+    tasks = []
+    for task in placement["tasks"]:
+        measured = stack.get(task["name"][:TASK_NAME_LEN], {})
+        if "recommended_bytes" in measured:
+            task = {**task, "stack_bytes": measured["recommended_bytes"]}
+            resized[task["name"]] = task["stack_bytes"]
+        tasks.append(task)
+    return {**placement, "tasks": tasks}, resized
+
+
+def render_placement(placement: dict, profile: Optional[str] = None) -> str:
+    """
+    Render the placement plan as mandatory instructions for the coder prompt.
+
+    Under the static profile tasks are created statically and interrupt/driver
+    setup on the ISR core must finish before app_main arms heap_guard.
+    """
+    if profile == "static":
+        create = (
+            "Create tasks only with xTaskCreateStaticPinnedToCore(fn, name, stack_bytes, arg, priority, "
+            "stack_buffer, &task_buffer, core),"
+        )
+    else:
+        create = "Create tasks only with xTaskCreatePinnedToCore(fn, name, stack_bytes, arg, priority, &handle, core),"
+    lines = [
+        f"Task placement (mandatory): the GPIO ISR service and time-critical tasks run on core {placement['isr_core']}.",
+        create,
+        "mapping every task you create onto one of these slots (skip slots the program does not need):",
+    ]
+    for task in placement["tasks"]:
+        lines.append(
+            f"- {task['name']}: role {task['role']}, core {task['core']}, "
+            f"priority {task['priority']}, stack {task['stack_bytes']} bytes"
+        )
+    lines.append(
+        "Interrupts are allocated on the core that installs them: call gpio_install_isr_service() and "
+        "set up gptimer/button_debounce/periodic_timer/timer_wheel from code running on core "
+        f"{placement['isr_core']} (e.g. at the start of the realtime/isr_service task), not from app_main."
+    )
+    if profile == "static":
+        lines.append(
+            "That setup allocates, so it must finish before heap_guard_arm(): the realtime task signals the end "
+            "of its init with xTaskNotifyGive() to app_main's handle, and app_main waits with "
+            "ulTaskNotifyTake(pdTRUE, portMAX_DELAY) before calling heap_guard_arm() as its last statement."
+        )
+    return "\n".join(lines)
@@ -0,0 +1,123 @@
+"""
+Performance profiles emitted as sdkconfig.defaults for ESP-IDF projects.
+
+The stock sdkconfig builds with -Og, a 100 Hz tick and INFO logging, which
+quantizes timing to 10 ms and keeps GPIO/GPTimer ISR paths in flash. Each
+profile below overrides those defaults for a class of task; a profile's
+optional "instructions" are added to the coder prompt.
+"""
+
+import re
+from typing import Dict, List, Optional
+
+DEFAULT_PROFILE = "latency"
+
+PROFILES: Dict[str, dict] = {
+    "latency": {
+        "summary": "fast, deterministic ISR/timer response: -O2, 1000 Hz tick, IRAM-resident GPIO/GPTimer ISRs, WARN logging",
+        "options": [
+            "CONFIG_COMPILER_OPTIMIZATION_PERF=y",
+            "CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ_240=y",
+            "CONFIG_FREERTOS_HZ=1000",
+            "CONFIG_GPIO_CTRL_FUNC_IN_IRAM=y",
+            "CONFIG_GPTIMER_ISR_IRAM_SAFE=y",
+            "CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM=y",
+            "CONFIG_ESP_TIMER_SUPPORTS_ISR_DISPATCH_METHOD=y",
+            "CONFIG_LOG_DEFAULT_LEVEL_WARN=y",
+            "CONFIG_BOOTLOADER_LOG_LEVEL_WARN=y",
+        ],
+    },
+    "throughput": {
+        "summary": "sustained processing speed: -O2, 240 MHz, 80 MHz flash, silent asserts, WARN logging",
+        "options": [
+            "CONFIG_COMPILER_OPTIMIZATION_PERF=y",
+            "CONFIG_COMPILER_OPTIMIZATION_ASSERTIONS_SILENT=y",
+            "CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ_240=y",
+            "CONFIG_ESPTOOLPY_FLASHFREQ_80M=y",
+            "CONFIG_FREERTOS_HZ=1000",
+            "CONFIG_LOG_DEFAULT_LEVEL_WARN=y",
+            "CONFIG_BOOTLOADER_LOG_LEVEL_WARN=y",
+        ],
+    },
+    "static": {
+        "summary": "deterministic memory: latency options, static allocation only, heap use after app_main is detected",
+        "options": [
+            "CONFIG_COMPILER_OPTIMIZATION_PERF=y",
+            "CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ_240=y",
+            "CONFIG_FREERTOS_HZ=1000",
+            "CONFIG_FREERTOS_SUPPORT_STATIC_ALLOCATION=y",
+            "CONFIG_GPIO_CTRL_FUNC_IN_IRAM=y",
+            "CONFIG_GPTIMER_ISR_IRAM_SAFE=y",
+            "CONFIG_GPTIMER_CTRL_FUNC_IN_IRAM=y",
+            "CONFIG_HEAP_USE_HOOKS=y",
+            "CONFIG_LOG_DEFAULT_LEVEL_WARN=y",
+            "CONFIG_BOOTLOADER_LOG_LEVEL_WARN=y",
+        ],
+        "instructions": (
+            "Static allocation only: create every task with xTaskCreateStaticPinnedToCore using "
+            "static StackType_t buffers of exactly the planned stack_bytes and a static StaticTask_t, "
+            "and every queue/semaphore/event group/timer with its *CreateStatic variant and static "
+            "storage. No malloc/calloc/new, xTaskCreate or xQueueCreate anywhere. Create all timers "
+            "and driver objects once at startup, before heap_guard_arm() (ISR-core setup as the task "
+            "placement says). #include \"heap_guard.h\" and make heap_guard_arm(); the last "
+            "statement of app_main."
+        ),
+    },
+    "low-power": {
+        "summary": "battery operation: -Os, power management with tickless idle and automatic light sleep (start it with pm_helper_init()), 80 MHz, WARN logging",
+        "options": [
+            "CONFIG_COMPILER_OPTIMIZATION_SIZE=y",
+            "CONFIG_ESP_DEFAULT_CPU_FREQ_MHZ_80=y",
+            "CONFIG_PM_ENABLE=y",
+            "CONFIG_PM_SLP_IRAM_OPT=y",
+            "CONFIG_PM_RTOS_IDLE_OPT=y",
+            "CONFIG_FREERTOS_USE_TICKLESS_IDLE=y",
+            "CONFIG_FREERTOS_IDLE_TIME_BEFORE_SLEEP=3",
+            "CONFIG_FREERTOS_HZ=1000",
+            "CONFIG_LOG_DEFAULT_LEVEL_WARN=y",
+            "CONFIG_BOOTLOADER_LOG_LEVEL_WARN=y",
+        ],
+    },
+}
+
+# Requirement keywords that pick a profile in "auto" mode (checked in order).
+_PROFILE_KEYWORDS = (
+    ("static", ("static allocation", "statically allocated", "no heap", "no dynamic allocation", "deterministic memory")),
+    ("low-power", ("battery", "low power", "low-power", "sleep", "coin cell", "power consumption", "idle current")),
+    ("throughput", ("throughput", "bandwidth", "streaming", "data logging", "sample rate", "fft", "dsp")),
+)
+
+
+def select_profile(requirements: str, override: str = "auto") -> Optional[str]:
+    """
+    Choose the sdkconfig profile for a task.
+
+    Args:
+        requirements: User requirements text
+        override: "auto", "none" (emit nothing) or an explicit profile name
+
+    Returns:
+        Profile name, or None when no sdkconfig.defaults should be emitted
+    """
+    if override == "none":
+        return None
+    if override != "auto":
+        return override
+
+    text = requirements.lower()
+    for profile, keywords in _PROFILE_KEYWORDS:
+        if any(re.search(rf"(?<![a-z]){re.escape(k)}(?![a-z])", text) for k in keywords):
+            return profile
+    return DEFAULT_PROFILE
+
+
+def render_sdkconfig_defaults(profile: str, extra_options: List[str] = None) -> str:
+    """Render sdkconfig.defaults content for a profile."""
+    spec = PROFILES[profile]
+    lines = [
+        f"# embed-agent profile: {profile}",
+        f"# {spec['summary']}",
+        *spec["options"],
+        *(option for option in extra_options or [] if option not in spec["options"]),
+    ]
+    return "\n".join(lines) + "\n"
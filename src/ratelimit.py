@@ -0,0 +1,64 @@
+"""
+Token-bucket rate limiting of LLM requests toward the configured api_base.
+
+The scheduler (src/scheduler.py) keeps one bucket per endpoint, shared by
+every node, batch job and server worker of the process: each uncached LLM
+call takes one token, tokens refill continuously
+at rate_per_min, and up to burst calls may go out back to back. Callers
+without a token wait (threads in acquire(), coroutines in aacquire()), so
+a saturated API budget slows the workers down and - in server mode - fills
+the job queue, which then rejects new jobs (see src/server.py).
+"""
+
+import asyncio
+import threading
+import time
+from typing import Optional
+
+
+class TokenBucket:
+    """Thread-safe token bucket usable from threads and coroutines."""
+
+    def __init__(self, rate_per_min: float, burst: Optional[int] = None):
+        if rate_per_min <= 0:
+            raise ValueError("rate_per_min must be > 0")
+        self.rate_per_s = rate_per_min / 60.0
+        self.capacity = float(burst if burst else max(1, round(rate_per_min / 60)))
+        self._tokens = self.capacity
+        self._updated = time.monotonic()
+        self._lock = threading.Lock()
+
+    def _refill(self, now: float) -> None:
+        self._tokens = min(self.capacity, self._tokens + (now - self._updated) * self.rate_per_s)
+        self._updated = now
+
+    def reserve(self) -> float:
+        """Take a token and return 0.0, or return the seconds until one is available."""
+        with self._lock:
+            self._refill(time.monotonic())
+            if self._tokens >= 1:
+                self._tokens -= 1
+                return 0.0
+            return (1 - self._tokens) / self.rate_per_s
+
+    def acquire(self) -> float:
+        """Block until a token is taken; returns the seconds waited."""
+        waited = 0.0
+        while (delay := self.reserve()) > 0:
+            time.sleep(delay)
+            waited += delay
+        return waited
+
+    async def aacquire(self) -> float:
+        """Wait (without blocking the event loop) until a token is taken; returns the seconds waited."""
+        waited = 0.0
+        while (delay := self.reserve()) > 0:
+            await asyncio.sleep(delay)
+            waited += delay
+        return waited
+
+    def available(self) -> float:
+        """Tokens currently in the bucket."""
+        with self._lock:
+            self._refill(time.monotonic())
+            return self._tokens
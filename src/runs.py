@@ -0,0 +1,127 @@
+"""
+Run directory helpers shared by single-run and batch modes.
+
+Task directory structure:
+    tasks/<task>/
+    ├── prompt.txt
+    └── runs/
+        └── 2026-02-12_14-30-25/
+"""
+
+import hashlib
+import json
+from datetime import datetime
+from pathlib import Path
+from typing import Optional
+
+from src.objects import ObjectStore, read_artifact, store_root
+
+
+def list_prompt_files(task_dir: Path) -> list[Path]:
+    """Find all .txt files in the task directory (excluding runs/)."""
+    return sorted([
+        f for f in task_dir.glob("*.txt")
+        if f.is_file()
+    ])
+
+
+def create_run_dir(task_dir: Path) -> Path:
+    """
+    Create a fresh timestamped run directory under task_dir/runs.
+
+    Concurrent runs of the same task can start within the same second, so a
+    numeric suffix is appended when the timestamp directory already exists.
+    """
+    runs_root = task_dir / "runs"
+    runs_root.mkdir(parents=True, exist_ok=True)
+
+    timestamp = datetime.now().strftime("%Y-%m-%d_%H-%M-%S")
+    run_dir = runs_root / timestamp
+    suffix = 1
+    while True:
+        try:
+            run_dir.mkdir()
+            return run_dir
+        except FileExistsError:
+            suffix += 1
+            run_dir = runs_root / f"{timestamp}_{suffix}"
+
+
+def build_inputs(task_dir: Path, prompt_file: Path, run_dir: Path) -> dict:
+    """Build the initial graph state for one task/prompt run."""
+    return {
+        "requirements": prompt_file.read_text().strip(),
+        "task_name": task_dir.name,
+        "task_dir": str(task_dir),
+        "prompt_file": prompt_file.name,
+        "run_dir": str(run_dir),
+        "messages": [],
+        "debug_logs": [],
+    }
+
+
+def latest_benchmark(task_dir: Path, key: str, exclude: Optional[Path] = None) -> Optional[dict]:
+    """Return the newest successful benchmark result of a task that contains key."""
+    runs_dir = task_dir / "runs"
+    if not runs_dir.is_dir():
+        return None
+
+    for run_dir in sorted(runs_dir.iterdir(), reverse=True):
+        if exclude is not None and run_dir.resolve() == exclude.resolve():
+            continue
+        try:
+            metadata = json.loads((run_dir / "metadata.json").read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            continue
+        benchmark = metadata.get("benchmark") or {}
+        if benchmark.get("status") == "ok" and key in benchmark:
+            return benchmark
+    return None
+
+
+def latest_successful_run(task_dir: Path, target: str, exclude: Optional[Path] = None) -> Optional[dict]:
+    """
+    Return the newest run of a task that can serve as a base for incremental edits.
+
+    A run qualifies when it generated code for the same target, its build (if
+    one ran; "skipped" for non-ESP-IDF targets) succeeded, and its code file (or its object store blob) still
+    matches the sha256 recorded in output/manifest.lock.json.
+
+    Returns:
+        {"run_dir", "requirements", "path", "code", "sha256"} or None
+    """
+    runs_dir = task_dir / "runs"
+    if not runs_dir.is_dir():
+        return None
+
+    store = ObjectStore(store_root(task_dir))
+    for run_dir in sorted(runs_dir.iterdir(), reverse=True):
+        if exclude is not None and run_dir.resolve() == exclude.resolve():
+            continue
+        try:
+            metadata = json.loads((run_dir / "metadata.json").read_text(encoding="utf-8"))
+            manifest = json.loads((run_dir / "output" / "manifest.lock.json").read_text(encoding="utf-8"))
+        except (OSError, ValueError):
+            continue
+        build_status = (metadata.get("build") or {}).get("status", "ok")
+        if manifest.get("target") != target or build_status not in ("ok", "skipped"):
+            continue
+
+        code = next((a for a in manifest.get("artifacts", []) if a.get("role") == "code"), None)
+        if code is None:
+            continue
+        try:
+            content = read_artifact(run_dir / "output", code, store).decode("utf-8")
+        except (OSError, KeyError, UnicodeDecodeError):
+            continue
+        sha256 = hashlib.sha256(content.encode("utf-8")).hexdigest()
+        if sha256 != code.get("sha256"):
+            continue
+        return {
+            "run_dir": str(run_dir),
+            "requirements": metadata.get("requirements", ""),
+            "path": code["path"],
+            "code": content,
+            "sha256": sha256,
+        }
+    return None
@@ -0,0 +1,307 @@
+"""
+LLM request scheduler: rate limits, retries, hedging and model fallback.
+
+Every uncached LLM call from the nodes goes through one process-wide
+Scheduler (see nodes.invoke_llm / nodes.astream_llm):
+
+- rate limit: one TokenBucket per endpoint (api_base) at
+  model.requests_per_min, plus at most scheduler.max_in_flight concurrent
+  requests per endpoint (0 = unlimited)
+- retries: 408/409/425/429/5xx responses, timeouts and connection errors
+  are retried with exponential backoff (full jitter, capped at
+  backoff_max_s; a Retry-After header wins). Other errors raise at once.
+- fallback: once the primary model has used its max_retries + 1 attempts,
+  the configured fallback_model (on fallback_api_base, default the same
+  endpoint) gets the same number of attempts
+- hedging: with hedge enabled, an attempt still unanswered after the model's
+  observed p95 latency (full call for invoke, time to first content for
+  streams; needs hedge_min_samples observations) gets a duplicate request
+  and the first answer wins. The losing stream is closed; a losing blocking
+  call is abandoned and its result discarded.
+
+Streams are only retried, hedged or failed over before their first content
+chunk, since tokens already handed to on_token cannot be taken back.
+
+Every decision is returned as an event list, which the nodes put into the
+debug log under metrics["scheduler"]:
+
+    {"event": "attempt" | "retry" | "hedge" | "hedge_won" | "fallback" | "rate_wait", "model": ..., ...}
+"""
+
+import asyncio
+import collections
+import concurrent.futures
+import random
+import threading
+import time
+from dataclasses import dataclass
+from typing import Any, AsyncIterator, Callable, Dict, List, Optional, Tuple
+
+from src.ratelimit import TokenBucket
+
+RETRYABLE_STATUS = {408, 409, 425, 429, 500, 502, 503, 504}
+RETRYABLE_ERRORS = {"APITimeoutError", "APIConnectionError", "TimeoutError", "ReadTimeout", "ConnectTimeout"}
+
+# Latency observations kept per (kind, model)
+LATENCY_WINDOW = 200
+
+
+@dataclass(frozen=True)
+class Target:
+    """One model on one endpoint, and how to call it."""
+
+    model: str
+    endpoint: str
+    llm: Any
+
+
+def is_retryable(exc: BaseException) -> bool:
+    """True for rate limits, server errors, timeouts and connection failures."""
+    status = getattr(exc, "status_code", None) or getattr(getattr(exc, "response", None), "status_code", None)
+    if isinstance(status, int):
+        return status in RETRYABLE_STATUS
+    return type(exc).__name__ in RETRYABLE_ERRORS or isinstance(exc, (TimeoutError, ConnectionError))
+
+
+def retry_after_s(exc: BaseException) -> Optional[float]:
+    """Retry-After seconds from an HTTP error response, if sent."""
+    headers = getattr(getattr(exc, "response", None), "headers", None) or {}
+    try:
+        return float(headers.get("retry-after"))
+    except (TypeError, ValueError):
+        return None
+
+
+class Scheduler:
+    """Process-wide policy for LLM requests (see module docstring)."""
+
+    def __init__(
+        self,
+        requests_per_min: int = 0,
+        max_in_flight: int = 0,
+        max_retries: int = 3,
+        backoff_base_s: float = 1.0,
+        backoff_max_s: float = 30.0,
+        hedge: bool = False,
+        hedge_min_samples: int = 20,
+    ):
+        self.requests_per_min = requests_per_min
+        self.max_in_flight = max_in_flight
+        self.max_retries = max_retries
+        self.backoff_base_s = backoff_base_s
+        self.backoff_max_s = backoff_max_s
+        self.hedge = hedge
+        self.hedge_min_samples = hedge_min_samples
+        self._buckets: Dict[str, TokenBucket] = {}
+        self._slots: Dict[str, threading.BoundedSemaphore] = {}
+        self._latency: Dict[Tuple[str, str], collections.deque] = {}
+        self._lock = threading.Lock()
+
+    # -- shared state -------------------------------------------------------
+
+    def bucket(self, endpoint: str) -> Optional[TokenBucket]:
+        """The endpoint's token bucket (None when unlimited)."""
+        if self.requests_per_min <= 0:
+            return None
+        with self._lock:
+            return self._buckets.setdefault(endpoint, TokenBucket(self.requests_per_min))
+
+    def _slot(self, endpoint: str) -> Optional[threading.BoundedSemaphore]:
+        if self.max_in_flight <= 0:
+            return None
+        with self._lock:
+            return self._slots.setdefault(endpoint, threading.BoundedSemaphore(self.max_in_flight))
+
+    def observe(self, kind: str, model: str, seconds: float) -> None:
+        with self._lock:
+            self._latency.setdefault((kind, model), collections.deque(maxlen=LATENCY_WINDOW)).append(seconds)
+
+    def p95(self, kind: str, model: str) -> Optional[float]:
+        """Observed p95 latency in seconds, or None below hedge_min_samples observations."""
+        with self._lock:
+            samples = sorted(self._latency.get((kind, model), ()))
+        if len(samples) < max(1, self.hedge_min_samples):
+            return None
+        return samples[min(len(samples) - 1, int(len(samples) * 0.95))]
+
+    def _backoff(self, attempt: int, exc: BaseException) -> float:
+        hinted = retry_after_s(exc)
+        if hinted is not None:
+            return min(self.backoff_max_s, hinted)
+        return random.uniform(0, min(self.backoff_max_s, self.backoff_base_s * 2 ** attempt))
+
+    def _plan(self, targets: List[Target]) -> List[Tuple[int, Target]]:
+        """(attempt index on that target, target) for every attempt, fallback last."""
+        return [(attempt, target) for target in targets for attempt in range(self.max_retries + 1)]
+
+    # -- blocking calls -----------------------------------------------------
+
+    def _admit(self, target: Target, events: List[dict]) -> None:
+        bucket = self.bucket(target.endpoint)
+        waited = bucket.acquire() if bucket else 0.0
+        if waited:
+            events.append({"event": "rate_wait", "model": target.model, "wait_ms": round(waited * 1000, 2)})
+        slot = self._slot(target.endpoint)
+        if slot:
+            slot.acquire()
+
+    def _release(self, target: Target) -> None:
+        slot = self._slot(target.endpoint)
+        if slot:
+            slot.release()
+
+    def _call(self, target: Target, call: Callable[[Any], Any], events: List[dict]) -> Any:
+        self._admit(target, events)
+        try:
+            start = time.perf_counter()
+            result = call(target.llm)
+            self.observe("invoke", target.model, time.perf_counter() - start)
+            return result
+        finally:
+            self._release(target)
+
+    def _hedged_call(self, target: Target, call: Callable[[Any], Any], events: List[dict]) -> Any:
+        threshold = self.p95("invoke", target.model) if self.hedge else None
+        if threshold is None:
+            return self._call(target, call, events)
+
+        pool = concurrent.futures.ThreadPoolExecutor(max_workers=2)
+        try:
+            futures = [pool.submit(self._call, target, call, events)]
+            done, _ = concurrent.futures.wait(futures, timeout=threshold)
+            if not done:
+                events.append({"event": "hedge", "model": target.model, "after_ms": round(threshold * 1000, 2)})
+                futures.append(pool.submit(self._call, target, call, events))
+            pending = set(futures)
+            error = None
+            while pending:
+                done, pending = concurrent.futures.wait(pending, return_when=concurrent.futures.FIRST_COMPLETED)
+                for future in done:
+                    if future.exception() is None:
+                        if len(futures) > 1:
+                            events.append({"event": "hedge_won", "model": target.model, "hedge": future is futures[1]})
+                        return future.result()
+                    error = future.exception()
+            raise error
+        finally:
+            pool.shutdown(wait=False)
+
+    def invoke(self, targets: List[Target], call: Callable[[Any], Any]) -> Tuple[Any, Target, List[dict]]:
+        """
+        Run call(llm) under the policy, primary target first.
+
+        Returns:
+            (result, target that answered, events)
+        """
+        events: List[dict] = []
+        plan = self._plan(targets)
+        for index, (attempt, target) in enumerate(plan):
+            if attempt == 0 and target is not targets[0]:
+                events.append({"event": "fallback", "model": target.model, "endpoint": target.endpoint})
+            events.append({"event": "attempt", "model": target.model, "attempt": attempt})
+            try:
+                return self._hedged_call(target, call, events), target, events
+            except Exception as e:  # pylint: disable=broad-except
+                if not is_retryable(e) or index == len(plan) - 1:
+                    raise
+                delay = self._backoff(attempt, e) if plan[index + 1][1] is target else 0.0
+                events.append({"event": "retry", "model": target.model, "error": f"{type(e).__name__}: {e}"[:200],
+                               "backoff_ms": round(delay * 1000, 2)})
+                time.sleep(delay)
+        raise AssertionError("unreachable")
+
+    # -- streams ------------------------------------------------------------
+
+    async def _aadmit(self, target: Target, events: List[dict]) -> None:
+        bucket = self.bucket(target.endpoint)
+        waited = await bucket.aacquire() if bucket else 0.0
+        if waited:
+            events.append({"event": "rate_wait", "model": target.model, "wait_ms": round(waited * 1000, 2)})
+        slot = self._slot(target.endpoint)
+        while slot and not slot.acquire(blocking=False):
+            await asyncio.sleep(0.05)
+
+    async def _open(self, target: Target, stream: Callable[[Any], AsyncIterator], events: List[dict]):
+        """Start a stream and read up to its first content chunk: (prefix chunk, iterator)."""
+        await self._aadmit(target, events)
+        iterator = stream(target.llm).__aiter__()
+        try:
+            start = time.perf_counter()
+            prefix = None
+            async for chunk in iterator:
+                prefix = chunk if prefix is None else prefix + chunk
+                if chunk.content:
+                    break
+            self.observe("ttft", target.model, time.perf_counter() - start)
+            return prefix, iterator
+        except BaseException:
+            self._release(target)
+            await _aclose(iterator)
+            raise
+
+    async def _hedged_open(self, target: Target, stream, events: List[dict]):
+        threshold = self.p95("ttft", target.model) if self.hedge else None
+        first = asyncio.ensure_future(self._open(target, stream, events))
+        if threshold is None:
+            return await first
+
+        done, _ = await asyncio.wait({first}, timeout=threshold)
+        if done:
+            return first.result()
+        events.append({"event": "hedge", "model": target.model, "after_ms": round(threshold * 1000, 2)})
+        second = asyncio.ensure_future(self._open(target, stream, events))
+        pending = {first, second}
+        error = None
+        while pending:
+            done, pending = await asyncio.wait(pending, return_when=asyncio.FIRST_COMPLETED)
+            winners = [task for task in done if task.exception() is None]
+            if winners:
+                for loser in pending:
+                    loser.cancel()
+                for loser in winners[1:]:  # both answered in the same step
+                    self._release(target)
+                    await _aclose(loser.result()[1])
+                events.append({"event": "hedge_won", "model": target.model, "hedge": winners[0] is second})
+                return winners[0].result()
+            error = next(iter(done)).exception()
+        raise error
+
+    async def astream(self, targets: List[Target], stream: Callable[[Any], AsyncIterator]):
+        """
+        Open stream(llm) under the policy, primary target first.
+
+        Returns:
+            (first chunks aggregated up to the first content, rest of the stream,
+             target that answered, events); iterate the rest with
+             Scheduler.finish(target) in a finally block.
+        """
+        events: List[dict] = []
+        plan = self._plan(targets)
+        for index, (attempt, target) in enumerate(plan):
+            if attempt == 0 and target is not targets[0]:
+                events.append({"event": "fallback", "model": target.model, "endpoint": target.endpoint})
+            events.append({"event": "attempt", "model": target.model, "attempt": attempt})
+            try:
+                prefix, iterator = await self._hedged_open(target, stream, events)
+                return prefix, iterator, target, events
+            except Exception as e:  # pylint: disable=broad-except
+                if not is_retryable(e) or index == len(plan) - 1:
+                    raise
+                delay = self._backoff(attempt, e) if plan[index + 1][1] is target else 0.0
+                events.append({"event": "retry", "model": target.model, "error": f"{type(e).__name__}: {e}"[:200],
+                               "backoff_ms": round(delay * 1000, 2)})
+                await asyncio.sleep(delay)
+        raise AssertionError("unreachable")
+
+    def finish(self, target: Target) -> None:
+        """Release the in-flight slot of a stream returned by astream()."""
+        self._release(target)
+
+
+async def _aclose(iterator) -> None:
+    close = getattr(iterator, "aclose", None)
+    if close:
+        try:
+            await close()
+        except Exception:  # pylint: disable=broad-except
+            pass
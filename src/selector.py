@@ -0,0 +1,103 @@
+"""
+Local (no-LLM) skill selection fast path for the manager.
+
+Requirements text is matched against each skill's name and frontmatter
+keywords. Skills that share a frontmatter `group` are mutually exclusive
+(e.g. arduino vs esp-idf as the framework); the confidence of a group is the
+winner's share of the group's keyword hits. The overall confidence is the
+lowest group confidence, so an ambiguous or missing framework match sends the
+request back to the LLM planner.
+"""
+
+import re
+from dataclasses import dataclass, field
+from typing import Dict, List, Optional
+
+# Confidence assigned to a group none of whose skills matched.
+UNMATCHED_GROUP_CONFIDENCE = 0.5
+
+
+@dataclass
+class SkillSelection:
+    """Result of local skill selection."""
+
+    skills: List[str] = field(default_factory=list)
+    project_name: str = "embedded_project"
+    confidence: float = 0.0
+    scores: Dict[str, int] = field(default_factory=dict)
+
+
+def _count_hits(text: str, terms: List[str]) -> int:
+    """Count how many distinct terms appear in text as whole words."""
+    hits = 0
+    for term in terms:
+        pattern = rf"(?<![a-z0-9]){re.escape(term.lower())}(?![a-z0-9])"
+        if re.search(pattern, text):
+            hits += 1
+    return hits
+
+
+def to_snake_case(value: str, default: str = "embedded_project") -> str:
+    """Convert an arbitrary label (e.g. a task directory name) to snake_case."""
+    snake = re.sub(r"[^a-z0-9]+", "_", value.lower()).strip("_")
+    if not snake:
+        return default
+    if snake[0].isdigit():
+        snake = f"project_{snake}"
+    return snake
+
+
+def select_skills(
+    requirements: str,
+    skill_metadata: Dict[str, dict],
+    task_name: Optional[str] = None,
+) -> SkillSelection:
+    """
+    Select skills for a request using keyword rules over SKILL.md frontmatter.
+
+    Args:
+        requirements: User requirements text
+        skill_metadata: SkillRegistry.metadata (name -> {keywords, group, ...})
+        task_name: Task directory name used to derive the project name
+
+    Returns:
+        SkillSelection with chosen skills and a confidence in [0, 1]
+    """
+    text = requirements.lower()
+    scores = {
+        name: _count_hits(text, [name, *meta.get("keywords", [])])
+        for name, meta in skill_metadata.items()
+    }
+
+    groups: Dict[str, List[str]] = {}
+    selected: List[str] = []
+    for name, meta in skill_metadata.items():
+        group = meta.get("group")
+        if group:
+            groups.setdefault(group, []).append(name)
+        elif scores[name] > 0:
+            selected.append(name)
+
+    confidences: List[float] = []
+    for members in groups.values():
+        ranked = sorted(members, key=lambda n: scores[n], reverse=True)
+        top = scores[ranked[0]]
+        if top == 0:
+            confidences.append(UNMATCHED_GROUP_CONFIDENCE)
+            continue
+
+        second = scores[ranked[1]] if len(ranked) > 1 else 0
+        confidences.append(top / (top + second))
+        selected.append(ranked[0])
+
+    if not selected:
+        confidence = 0.0
+    else:
+        confidence = min(confidences) if confidences else 1.0
+
+    return SkillSelection(
+        skills=sorted(selected),
+        project_name=to_snake_case(task_name or ""),
+        confidence=round(confidence, 3),
+        scores=scores,
+    )
@@ -0,0 +1,280 @@
+"""
+Long-running agent server: one warm process serving generation jobs over HTTP.
+
+python main.py --serve compiles the graph once, creates the model client
+(and with it the HTTP connection pool) and scans the skill index before
+listening, so a job pays only for its LLM calls. Jobs run on one asyncio
+event loop in a background thread - the model's async client is bound to
+it - with server.workers graph runs at a time, like the batch runner.
+
+API (JSON bodies):
+    POST /jobs        {"task_dir", "prompt_file"?, "requirements"?, "wait"?: bool}
+                      -> 202 {"id", "status"}          (200 + result with "wait": true)
+                      -> 503 + Retry-After             queue full (backpressure)
+    GET  /jobs/<id>   -> {"id", "status": queued|running|done|failed, "run_dir", "result", "error", ...}
+    GET  /health      -> {"queued", "running", "workers", "queue_size", "rate_tokens"}
+
+"task_dir" must be inside server.tasks_root and "prompt_file" inside
+task_dir. "requirements" overrides the prompt file's text (an IDE sends the
+buffer); the run still goes to <task_dir>/runs/<timestamp>, created when a
+worker starts the job (a job's run_dir is null while queued), so rejected
+and still-queued requests leave no run directory behind. Uncached LLM calls share
+the model.requests_per_min token bucket, so a saturated API budget slows the
+workers, the queue fills, and new jobs are refused until it drains.
+"""
+
+import asyncio
+import itertools
+import json
+import threading
+import time
+from collections import OrderedDict
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+from pathlib import Path
+from typing import Callable, Optional
+
+from src.runs import build_inputs, create_run_dir, list_prompt_files
+
+# Seconds a client is told to wait after a 503
+RETRY_AFTER_S = 5
+
+
+def _result_summary(state: dict) -> dict:
+    """JSON-safe subset of a final graph state."""
+    code = next((a for a in state.get("artifacts", []) if a.get("role") == "code"), None)
+    return {
+        "status_msg": state.get("status_msg"),
+        "manifest_path": state.get("manifest_path"),
+        "persisted_paths": state.get("persisted_paths", []),
+        "code_path": code.get("path") if code else None,
+        "code": code.get("content") if code else None,
+        "lint": (state.get("lint_result") or {}).get("status"),
+        "build": state.get("build_result"),
+        "benchmark": (state.get("benchmark_result") or {}).get("status"),
+    }
+
+
+class AgentServer:
+    """Bounded job queue in front of a compiled graph."""
+
+    def __init__(
+        self,
+        app,
+        workers: int = 2,
+        queue_size: int = 16,
+        history: int = 256,
+        tasks_root: Path = Path("tasks"),
+        rate_tokens: Optional[Callable[[], float]] = None,
+    ):
+        self.app = app
+        self.tasks_root = Path(tasks_root).resolve()
+        self.workers = workers
+        self.queue_size = queue_size
+        self.history = history
+        self.rate_tokens = rate_tokens
+        self.jobs: "OrderedDict[str, dict]" = OrderedDict()
+        self._ids = itertools.count(1)
+        self._jobs_lock = threading.Lock()
+        self._loop = asyncio.new_event_loop()
+        self._queue: Optional[asyncio.Queue] = None
+        self._thread = threading.Thread(target=self._run_loop, name="agent-server-loop", daemon=True)
+
+    def start(self) -> None:
+        """Start the event loop thread and its workers."""
+        ready = threading.Event()
+        self._loop.call_soon(ready.set)
+        self._thread.start()
+        ready.wait()
+
+    def _run_loop(self) -> None:
+        asyncio.set_event_loop(self._loop)
+        self._queue = asyncio.Queue(maxsize=self.queue_size)
+        for _ in range(self.workers):
+            self._loop.create_task(self._worker())
+        self._loop.run_forever()
+
+    async def _worker(self) -> None:
+        while True:
+            job = await self._queue.get()
+            with self._jobs_lock:
+                job.update(status="running", started_at=time.time())
+                spec = job.pop("_spec")
+            try:
+                inputs = self._inputs(**spec)
+                with self._jobs_lock:
+                    job["run_dir"] = inputs["run_dir"]
+                update = {"status": "done", "result": _result_summary(await self.app.ainvoke(inputs))}
+            except Exception as e:  # pylint: disable=broad-except
+                update = {"status": "failed", "error": f"{type(e).__name__}: {e}"}
+            with self._jobs_lock:
+                job.update(update, finished_at=time.time())
+                job["duration_s"] = round(job["finished_at"] - job["started_at"], 2)
+                done = job.pop("_done")
+            done.set()
+            self._queue.task_done()
+
+    def _resolve(self, request: dict) -> dict:
+        """Validated task_dir, prompt_file and requirements of a job request (ValueError on bad input)."""
+        if not request.get("task_dir") or not isinstance(request["task_dir"], str):
+            raise ValueError(f"task_dir not found: {request.get('task_dir')!r}")
+        task_dir = Path(request["task_dir"]).resolve()
+        if not task_dir.is_relative_to(self.tasks_root) or task_dir == self.tasks_root:
+            raise ValueError(f"task_dir must be inside {self.tasks_root}: {request['task_dir']!r}")
+        if not task_dir.is_dir():
+            raise ValueError(f"task_dir not found: {request['task_dir']!r}")
+
+        requirements = request.get("requirements")
+        if requirements is not None and (not isinstance(requirements, str) or not requirements.strip()):
+            raise ValueError("requirements must be a non-empty string")
+        if request.get("prompt_file"):
+            if not isinstance(request["prompt_file"], str):
+                raise ValueError("prompt_file must be a string")
+            prompt_file = (task_dir / request["prompt_file"]).resolve()
+            if not prompt_file.is_relative_to(task_dir):
+                raise ValueError(f"prompt_file must be inside task_dir: {request['prompt_file']!r}")
+            if not prompt_file.is_file():
+                raise ValueError(f"prompt_file not found: {prompt_file}")
+        else:
+            prompt_files = list_prompt_files(task_dir)
+            if not prompt_files and requirements is None:
+                raise ValueError(f"No prompt files in {task_dir} and no requirements given")
+            prompt_file = prompt_files[0] if prompt_files else None
+        return {"task_dir": task_dir, "prompt_file": prompt_file, "requirements": requirements}
+
+    @staticmethod
+    def _inputs(task_dir: Path, prompt_file: Optional[Path], requirements: Optional[str]) -> dict:
+        """Initial graph state of a job, in a new run directory."""
+        run_dir = create_run_dir(task_dir)
+        if prompt_file is None:
+            inputs = {"task_name": task_dir.name, "task_dir": str(task_dir), "prompt_file": "request",
+                      "run_dir": str(run_dir), "messages": [], "debug_logs": []}
+        else:
+            inputs = build_inputs(task_dir, prompt_file, run_dir)
+        if requirements is not None:
+            inputs["requirements"] = requirements.strip()
+            inputs["prompt_file"] = "request"
+        return inputs
+
+    def submit(self, request: dict) -> dict:
+        """
+        Queue a job.
+
+        Raises:
+            ValueError: invalid request
+            asyncio.QueueFull: queue at server.queue_size
+        """
+        if self._queue.full():
+            raise asyncio.QueueFull()
+        spec = self._resolve(request)
+        job = {
+            "id": str(next(self._ids)),
+            "status": "queued",
+            "task_dir": str(spec["task_dir"]),
+            "run_dir": None,
+            "queued_at": time.time(),
+            "_spec": spec,
+            "_done": threading.Event(),
+        }
+        done = job["_done"]
+        with self._jobs_lock:
+            self.jobs[job["id"]] = job
+        try:
+            asyncio.run_coroutine_threadsafe(self._enqueue(job), self._loop).result()
+        except asyncio.QueueFull:
+            with self._jobs_lock:
+                del self.jobs[job["id"]]
+            raise
+        with self._jobs_lock:
+            finished = [k for k, j in self.jobs.items() if j["status"] in ("done", "failed")]
+            for key in finished[: max(0, len(self.jobs) - self.history)]:
+                del self.jobs[key]
+        return {**self.get(job["id"]), "_done": done}
+
+    async def _enqueue(self, job: dict) -> None:
+        self._queue.put_nowait(job)  # QueueFull propagates to submit()
+
+    def get(self, job_id: str) -> Optional[dict]:
+        """Public view of a job."""
+        with self._jobs_lock:
+            job = self.jobs.get(job_id)
+            return {k: v for k, v in job.items() if not k.startswith("_")} if job else None
+
+    def health(self) -> dict:
+        with self._jobs_lock:
+            statuses = [j["status"] for j in self.jobs.values()]
+        return {
+            "queued": statuses.count("queued"),
+            "running": statuses.count("running"),
+            "workers": self.workers,
+            "queue_size": self.queue_size,
+            "rate_tokens": round(self.rate_tokens(), 2) if self.rate_tokens else None,
+        }
+
+
+def _handler(server: AgentServer):
+    class Handler(BaseHTTPRequestHandler):
+        """JSON API of the agent server (see module docstring)."""
+
+        def _send(self, code: int, body: dict, headers: Optional[dict] = None) -> None:
+            payload = json.dumps(body, default=str).encode("utf-8")
+            self.send_response(code)
+            self.send_header("Content-Type", "application/json")
+            self.send_header("Content-Length", str(len(payload)))
+            for name, value in (headers or {}).items():
+                self.send_header(name, value)
+            self.end_headers()
+            self.wfile.write(payload)
+
+        def do_GET(self):  # pylint: disable=invalid-name
+            if self.path == "/health":
+                self._send(200, server.health())
+            elif self.path.startswith("/jobs/"):
+                job = server.get(self.path[len("/jobs/"):])
+                if job:
+                    self._send(200, job)
+                else:
+                    self._send(404, {"error": "unknown job"})
+            else:
+                self._send(404, {"error": "not found"})
+
+        def do_POST(self):  # pylint: disable=invalid-name
+            if self.path != "/jobs":
+                self._send(404, {"error": "not found"})
+                return
+            try:
+                length = int(self.headers.get("Content-Length") or 0)
+                request = json.loads(self.rfile.read(length) or b"{}")
+                if not isinstance(request, dict):
+                    raise ValueError("body must be a JSON object")
+                job = server.submit(request)
+            except asyncio.QueueFull:
+                self._send(503, {"error": "queue full"}, {"Retry-After": str(RETRY_AFTER_S)})
+                return
+            except ValueError as e:
+                self._send(400, {"error": str(e)})
+                return
+
+            done = job.pop("_done")
+            if request.get("wait"):
+                done.wait()
+                self._send(200, server.get(job["id"]))
+            else:
+                self._send(202, job)
+
+        def log_message(self, format, *args):  # pylint: disable=redefined-builtin
+            print(f"[server] {self.address_string()} {format % args}")
+
+    return Handler
+
+
+def serve(server: AgentServer, host: str, port: int) -> None:
+    """Start the workers and serve HTTP until interrupted."""
+    server.start()
+    httpd = ThreadingHTTPServer((host, port), _handler(server))
+    print(f"Serving on http://{host}:{port} ({server.workers} workers, queue {server.queue_size})")
+    try:
+        httpd.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    finally:
+        httpd.server_close()
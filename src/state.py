@@ -27,6 +27,7 @@ class AgentState(TypedDict, total=False):
 
     # Run configuration
     task_name: str
+    task_dir: str  # Path to the task directory (e.g., tasks/dht11)
     prompt_file: str  # Name of the prompt file used (e.g., "prompt_v2.txt")
     run_dir: str  # Path to current run directory (e.g., tasks/dht11/runs/2026-02-12_14-30-25)
 
@@ -34,9 +35,13 @@ class AgentState(TypedDict, total=False):
     project_name: str
     active_platform: Optional[str]
     active_skills: List[str]
-    active_skill_content: Optional[str]
+    active_skill_content: Optional[str]  # Static skill sections (cacheable coder prompt prefix)
+    retrieved_skill_content: Optional[str]  # Skill sections retrieved for the requirements (after the prefix)
+    skill_context_stats: dict  # Injected skill sections/token counts (set by manager)
     prepared_output_dir: Optional[str]
     prepared_code_path: Optional[str]
+    firmware_profile: Optional[str]  # sdkconfig.defaults profile (None = not emitted)
+    task_placement: Optional[dict]  # TaskPlacement (manager plan, validated by prepare_workspace)
     workspace: WorkspaceInfo
 
     # Artifacts from generation/assembly
@@ -53,4 +58,24 @@ class AgentState(TypedDict, total=False):
     # Final output
     manifest_path: Optional[str]
     persisted_paths: List[str]
-    status_msg: str
\ No newline at end of file
+    status_msg: str
+
+    # Verification / repair loop
+    lint_result: dict  # LintResult.to_dict() from lint_firmware
+    lint_repairs: int
+    build_result: dict  # BuildResult.to_dict() from build_verify
+    repair_feedback: Optional[str]  # Diagnostics handed back to coder, cleared once consumed
+    repair_attempts: int
+
+    # On-target benchmark
+    benchmark_result: dict  # run_benchmark() result (or skipped/failed status)
+
+    # Multi-candidate generation
+    candidate: dict  # Variant handed to one candidate_node via Send (index, temperature, skills)
+    candidates: Annotated[List[dict], operator.add]  # Full candidate records (code, artifacts, results)
+    candidate_summary: List[dict]  # Per-candidate results for metadata.json (set by select_candidate)
+
+    # Incremental regeneration
+    base_run: Optional[dict]  # latest_successful_run() result + similarity, or None for a full rewrite
+    code_patch: Optional[str]  # Coder's diff against base_run, applied by assemble_artifacts
+    incremental: dict  # base_run dir, similarity, mode (reuse/diff/full), patch status
\ No newline at end of file
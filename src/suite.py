@@ -0,0 +1,250 @@
+"""
+Regression benchmark suite: one batch over every task, summarized and compared to a baseline.
+
+Each run of the suite (python main.py --suite) goes through the batch runner
+and writes <suite.results_dir>/<timestamp>.json:
+
+    {
+      "created_at", "model", "temperature",
+      "runs": {"<task>/<prompt>": run_summary(), ...},
+      "totals": totals()
+    }
+
+A run summary holds per-node duration_ms, prompt/completion/cached tokens and cost,
+the LLM cache hit rate, build status and app size, the on-target timing error
+(candidates.timing_error_ms) and the generated code's sha256. The baseline is
+a results file stored with --save-baseline; compare() reports every total
+and per-run metric that moved by more than suite.tolerance_pct in the wrong
+direction, plus runs whose generated code differs from the baseline's (the
+golden output; deterministic while the prompt, skills and model are unchanged
+and temperature is 0).
+"""
+
+import hashlib
+import json
+import math
+import statistics
+from datetime import datetime
+from pathlib import Path
+from typing import List, Optional
+
+from src.candidates import timing_error_ms
+
+# Totals/run metrics where a higher value is better (everything else: lower is better)
+HIGHER_IS_BETTER = {"build_ok_rate", "cache_hit_rate", "cached_tokens"}
+
+
+def _code_sha256(state: dict) -> Optional[str]:
+    """sha256 of the generated code, from the run's manifest (output/ may hold no files with store.mode ref)."""
+    try:
+        manifest = json.loads(Path(state["manifest_path"]).read_text(encoding="utf-8"))
+    except (KeyError, TypeError, OSError, ValueError):
+        manifest = {}
+    code = next((a for a in manifest.get("artifacts", []) if a.get("role") == "code"), None)
+    if code:
+        return code.get("sha256")
+    if state.get("prepared_code_path") and Path(state["prepared_code_path"]).is_file():
+        return hashlib.sha256(Path(state["prepared_code_path"]).read_bytes()).hexdigest()
+    return None
+
+
+def run_summary(result, prompt_cost_per_mtok: float = 0.0, completion_cost_per_mtok: float = 0.0) -> dict:
+    """Summarize one BatchResult (see module docstring)."""
+    state = result.final_state or {}
+    nodes: dict = {}
+    prompt_tokens = completion_tokens = cached_tokens = 0
+    llm_calls = cache_hits = 0
+    for entry in state.get("debug_logs", []):
+        node = nodes.setdefault(entry["node"], {"calls": 0, "duration_ms": 0.0})
+        node["calls"] += 1
+        node["duration_ms"] = round(node["duration_ms"] + entry.get("duration_ms", 0.0), 2)
+
+        metrics = entry.get("metrics") or {}
+        if "cache" in metrics:
+            llm_calls += 1
+            cache_hits += metrics["cache"] == "hit"
+        prompt_tokens += metrics.get("prompt_tokens") or 0
+        completion_tokens += metrics.get("completion_tokens") or 0
+        cached_tokens += metrics.get("cached_tokens") or 0
+
+    build = state.get("build_result") or {}
+    benchmark = state.get("benchmark_result") or {}
+    timing = timing_error_ms(benchmark) if benchmark.get("status") == "ok" else math.inf
+
+    return {
+        "ok": result.ok,
+        "error": result.error or None,
+        "run_dir": str(result.run_dir) if result.run_dir else None,
+        "duration_s": round(result.duration_s, 2),
+        "nodes": nodes,
+        "llm_calls": llm_calls,
+        "cache_hit_rate": round(cache_hits / llm_calls, 4) if llm_calls else None,
+        "prompt_tokens": prompt_tokens,
+        "completion_tokens": completion_tokens,
+        "cached_tokens": cached_tokens,
+        "cost": round(
+            prompt_tokens / 1e6 * prompt_cost_per_mtok + completion_tokens / 1e6 * completion_cost_per_mtok, 6
+        ),
+        "build": build.get("status"),
+        "app_size": build.get("app_size"),
+        "benchmark": benchmark.get("status"),
+        "timing_error_ms": None if math.isinf(timing) else round(timing, 4),
+        "code_sha256": _code_sha256(state),
+    }
+
+
+def _mean(values: List[Optional[float]]) -> Optional[float]:
+    values = [v for v in values if v is not None]
+    return round(statistics.mean(values), 4) if values else None
+
+
+def totals(runs: dict) -> dict:
+    """Suite-wide aggregates of run summaries."""
+    summaries = list(runs.values())
+    built = [s for s in summaries if s["build"] not in (None, "skipped")]
+    node_ms: dict = {}
+    for summary in summaries:
+        for node, stats in summary["nodes"].items():
+            node_ms.setdefault(node, []).append(stats["duration_ms"])
+    return {
+        "runs": len(summaries),
+        "failed": sum(1 for s in summaries if not s["ok"]),
+        "mean_duration_s": _mean([s["duration_s"] for s in summaries]),
+        "node_mean_ms": {node: _mean(values) for node, values in sorted(node_ms.items())},
+        "prompt_tokens": sum(s["prompt_tokens"] for s in summaries),
+        "completion_tokens": sum(s["completion_tokens"] for s in summaries),
+        "cached_tokens": sum(s.get("cached_tokens", 0) for s in summaries),
+        "cost": round(sum(s["cost"] for s in summaries), 6),
+        "cache_hit_rate": _mean([s["cache_hit_rate"] for s in summaries]),
+        "build_ok_rate": round(sum(1 for s in built if s["build"] == "ok") / len(built), 4) if built else None,
+        "mean_app_size": _mean([s["app_size"] for s in summaries]),
+        "mean_timing_error_ms": _mean([s["timing_error_ms"] for s in summaries]),
+    }
+
+
+def build_results(results, model: str, temperature: float, **costs) -> dict:
+    """Results document for a finished batch (see module docstring)."""
+    runs = {r.job.label: run_summary(r, **costs) for r in results}
+    return {
+        "created_at": datetime.now().isoformat(),
+        "model": model,
+        "temperature": temperature,
+        "runs": runs,
+        "totals": totals(runs),
+    }
+
+
+def write_results(results: dict, results_dir: Path) -> Path:
+    """Write a results document as <results_dir>/<timestamp>.json."""
+    results_dir.mkdir(parents=True, exist_ok=True)
+    path = results_dir / f"{datetime.now().strftime('%Y-%m-%d_%H-%M-%S')}.json"
+    path.write_text(json.dumps(results, indent=2), encoding="utf-8")
+    return path
+
+
+def load_baseline(path: Path) -> Optional[dict]:
+    """Stored baseline results, or None if there is none yet."""
+    try:
+        return json.loads(path.read_text(encoding="utf-8"))
+    except (OSError, ValueError):
+        return None
+
+
+def _delta(name: str, current, baseline, tolerance_pct: float) -> Optional[dict]:
+    """Change of one metric; flagged as a regression beyond tolerance_pct in the wrong direction."""
+    if not isinstance(current, (int, float)) or not isinstance(baseline, (int, float)):
+        return None
+    change_pct = (current - baseline) / abs(baseline) * 100 if baseline else (0.0 if current == baseline else math.inf)
+    worse = change_pct < 0 if name in HIGHER_IS_BETTER else change_pct > 0
+    return {
+        "baseline": baseline,
+        "current": current,
+        "change_pct": round(change_pct, 2) if not math.isinf(change_pct) else None,
+        "regression": worse and abs(change_pct) > tolerance_pct,
+    }
+
+
+def compare(current: dict, baseline: dict, tolerance_pct: float = 10.0) -> dict:
+    """
+    Compare results against a baseline.
+
+    Returns:
+        {"totals": {metric: delta}, "runs": {label: {metric: delta, "code_changed", "build"}},
+         "new_runs": [...], "missing_runs": [...], "regressions": [...]}
+    """
+    report: dict = {"totals": {}, "runs": {}, "regressions": []}
+    for name, value in current["totals"].items():
+        if name == "runs":
+            continue
+        if name == "node_mean_ms":
+            for node, ms in value.items():
+                delta = _delta(f"{node}_ms", ms, baseline["totals"].get(name, {}).get(node), tolerance_pct)
+                if delta:
+                    report["totals"][f"{node}_ms"] = delta
+            continue
+        delta = _delta(name, value, baseline["totals"].get(name), tolerance_pct)
+        if delta:
+            report["totals"][name] = delta
+
+    for label, run in current["runs"].items():
+        base = baseline["runs"].get(label)
+        if base is None:
+            continue
+        entry = {
+            name: delta
+            for name in ("duration_s", "prompt_tokens", "completion_tokens", "cost", "app_size", "timing_error_ms")
+            if (delta := _delta(name, run[name], base.get(name), tolerance_pct))
+        }
+        entry["code_changed"] = run["code_sha256"] != base.get("code_sha256")
+        if run["build"] != base.get("build"):
+            entry["build"] = {"baseline": base.get("build"), "current": run["build"]}
+        report["runs"][label] = entry
+        if base.get("build") == "ok" and run["build"] != "ok":
+            report["regressions"].append(f"{label}: build {base.get('build')} -> {run['build']}")
+        if base.get("ok") and not run["ok"]:
+            report["regressions"].append(f"{label}: run failed ({run['error']})")
+
+    for name, delta in report["totals"].items():
+        if delta["regression"]:
+            report["regressions"].append(f"totals.{name}: {delta['baseline']} -> {delta['current']}")
+    for label, entry in report["runs"].items():
+        for name in ("app_size", "timing_error_ms"):
+            if name in entry and entry[name]["regression"]:
+                report["regressions"].append(f"{label}: {name} {entry[name]['baseline']} -> {entry[name]['current']}")
+
+    report["new_runs"] = sorted(set(current["runs"]) - set(baseline["runs"]))
+    report["missing_runs"] = sorted(set(baseline["runs"]) - set(current["runs"]))
+    return report
+
+
+def format_report(results: dict, report: Optional[dict]) -> str:
+    """Human-readable suite summary (and baseline comparison, if any)."""
+    t = results["totals"]
+    lines = [
+        "=== Suite summary ===",
+        f"Runs: {t['runs']} ({t['failed']} failed), mean {t['mean_duration_s']}s",
+        f"Tokens: {t['prompt_tokens']} prompt ({t.get('cached_tokens', 0)} cached) / "
+        f"{t['completion_tokens']} completion, cost {t['cost']}",
+        f"Cache hit rate: {t['cache_hit_rate']}, build ok rate: {t['build_ok_rate']}",
+        f"Mean app size: {t['mean_app_size']}, mean timing error: {t['mean_timing_error_ms']} ms",
+        "Node mean ms: " + ", ".join(f"{n}={ms}" for n, ms in t["node_mean_ms"].items()),
+    ]
+    if report is None:
+        lines.append("No baseline (store one with --save-baseline)")
+        return "\n".join(lines)
+
+    lines.append("=== Against baseline ===")
+    for name, delta in report["totals"].items():
+        change = f"{delta['change_pct']:+.1f}%" if delta["change_pct"] is not None else "new"
+        flag = "  REGRESSION" if delta["regression"] else ""
+        lines.append(f"  {name}: {delta['baseline']} -> {delta['current']} ({change}){flag}")
+    changed = [label for label, entry in report["runs"].items() if entry["code_changed"]]
+    lines.append(f"Golden output changed: {len(changed)}/{len(report['runs'])} runs")
+    lines.extend(f"  {label}" for label in changed)
+    if report["new_runs"]:
+        lines.append(f"New runs: {', '.join(report['new_runs'])}")
+    if report["missing_runs"]:
+        lines.append(f"Missing runs: {', '.join(report['missing_runs'])}")
+    lines.append(f"Regressions: {len(report['regressions'])}")
+    lines.extend(f"  {r}" for r in report["regressions"])
+    return "\n".join(lines)